@@ -1,9 +1,153 @@
 #include "adxl.h"
+#include "adxl_os.h"
 
 /******************************************************************************************************************************************************************************/
 /*																				 SPI INTERFACE 																				  */
 /******************************************************************************************************************************************************************************/
 
+static BUS_HOOK Bus_Hook = NULL;
+static void *Bus_Hook_Arg = NULL;
+
+/**
+ * @brief Function that reports a transaction edge to the installed bus hook
+ *
+ * @param spi SPI interface
+ * @param complete false after CS is asserted, true after it is released
+ */
+static inline void Bus_Event(SPI_HandleTypeDef *spi, bool complete)
+{
+	if (Bus_Hook != NULL)
+	{
+		Bus_Hook(spi, complete, Bus_Hook_Arg);
+	}
+}
+
+#ifdef ADXL_SPI_LL
+static SPI_HandleTypeDef *Fast_Path[ADXL_SPI_LL_DEVICES];
+
+/**
+ * @brief Function that tells if a device uses the register-level SPI path
+ *
+ * @param spi SPI interface
+ * @return true if the device was selected with Set_SPI_Fast_Path
+ */
+static bool SPI_LL_Enabled(SPI_HandleTypeDef *spi)
+{
+	uint8_t i = 0;
+	for (i = 0; i < ADXL_SPI_LL_DEVICES; i++)
+	{
+		if (Fast_Path[i] == spi)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Function that runs one full-duplex transaction on the SPI registers. The next byte is written as soon as TXE is set, so the bus
+ * does not idle between bytes, and each received byte is taken on RXNE
+ *
+ * @param spi SPI interface
+ * @param buffer Bytes to send, replaced with the bytes received
+ * @param length Number of bytes
+ * @return STATUS_ADXL ERR_SPI if the peripheral stops making progress
+ */
+static STATUS_ADXL SPI_LL_Transfer(SPI_HandleTypeDef *spi, uint8_t *buffer, uint8_t length)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	SPI_TypeDef *instance = spi->Instance;
+	uint32_t spin = 0;
+	uint8_t sent = 0;
+	uint8_t received = 0;
+	if (!(instance->CR1 & SPI_CR1_SPE))
+	{
+		instance->CR1 |= SPI_CR1_SPE;
+	}
+	// A transmit-only HAL call leaves a byte in DR and OVR set: reading DR then SR clears both
+	(void)instance->DR;
+	(void)instance->SR;
+	GPIOB->BSRR = (uint32_t)CS_Pin << 16;
+	Bus_Event(spi, false);
+	while (received < length && ret_val == STATUS_OK_ADXL)
+	{
+		// At most two bytes in flight: one shifting, one waiting in DR
+		if (sent < length && (uint8_t)(sent - received) < 2 && (instance->SR & SPI_SR_TXE))
+		{
+			instance->DR = buffer[sent++];
+		}
+		if (instance->SR & SPI_SR_RXNE)
+		{
+			buffer[received++] = (uint8_t)instance->DR;
+			spin = 0;
+		}
+		else if (++spin > ADXL_SPI_LL_SPIN)
+		{
+			ret_val = ERR_SPI;
+		}
+	}
+	spin = 0;
+	while ((instance->SR & SPI_SR_BSY) && ++spin < ADXL_SPI_LL_SPIN)
+	{
+	}
+	GPIOB->BSRR = CS_Pin;
+	Bus_Event(spi, true);
+	return ret_val;
+}
+#endif
+
+/**
+ * @brief Function that selects the register-level SPI path for a device. It drives the SPI data register and CS directly instead of the HAL calls
+ * (only available when built with ADXL_SPI_LL, the SPI must be initialized by HAL_SPI_Init as 8-bit master)
+ *
+ * @param spi SPI interface
+ * @param enable true to use the register-level path
+ * @return STATUS_ADXL ERR_PARAM if the path is not built in or ADXL_SPI_LL_DEVICES devices already use it
+ */
+STATUS_ADXL Set_SPI_Fast_Path(SPI_HandleTypeDef *spi, bool enable)
+{
+	STATUS_ADXL ret_val = ERR_PARAM;
+#ifdef ADXL_SPI_LL
+	uint8_t i = 0;
+	for (i = 0; i < ADXL_SPI_LL_DEVICES; i++)
+	{
+		if (Fast_Path[i] == spi)
+		{
+			Fast_Path[i] = NULL;
+		}
+	}
+	for (i = 0; i < ADXL_SPI_LL_DEVICES && enable && ret_val != STATUS_OK_ADXL; i++)
+	{
+		if (Fast_Path[i] == NULL)
+		{
+			Fast_Path[i] = spi;
+			ret_val = STATUS_OK_ADXL;
+		}
+	}
+	if (!enable)
+	{
+		ret_val = STATUS_OK_ADXL;
+	}
+#else
+	ret_val = enable ? ERR_PARAM : STATUS_OK_ADXL;
+	(void)spi;
+#endif
+	return ret_val;
+}
+
+/**
+ * @brief Function that installs a hook called at both ends of every blocking transaction (HAL and register-level paths), inside the bus lock.
+ * Install it before the bus is in use: the pointer is not swapped atomically
+ *
+ * @param hook Hook, NULL to remove it
+ * @param arg Argument passed to the hook
+ */
+void Set_Bus_Hook(BUS_HOOK hook, void *arg)
+{
+	Bus_Hook_Arg = arg;
+	Bus_Hook = hook;
+}
+
 /**
  * @brief Function that writes to 8-bit register
  *
@@ -18,7 +162,20 @@ STATUS_ADXL Register_Write(SPI_HandleTypeDef *spi, uint8_t address, uint8_t valu
 	uint8_t data[2];
 	data[0] = address |= 0x40; // see datasheet ADXL313 SPI
 	data[1] = value;
+	if (!Bus_Lock(BUS_PRIORITY_CONFIG))
+	{
+		return ERR_BUSY;
+	}
+#ifdef ADXL_SPI_LL
+	if (SPI_LL_Enabled(spi))
+	{
+		ret_val = SPI_LL_Transfer(spi, data, 2);
+		Bus_Unlock();
+		return ret_val;
+	}
+#endif
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_RESET); // In this case, I use F411RE
+	Bus_Event(spi, false);
 	if (HAL_SPI_Transmit(spi, data, 2, 100))
 	{
 		ret_val = ERR_SPI;
@@ -28,6 +185,8 @@ STATUS_ADXL Register_Write(SPI_HandleTypeDef *spi, uint8_t address, uint8_t valu
 		ret_val = STATUS_OK_ADXL;
 	}
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	Bus_Event(spi, true);
+	Bus_Unlock();
 	return ret_val;
 }
 
@@ -46,7 +205,29 @@ STATUS_ADXL Read_Byte(SPI_HandleTypeDef *spi, uint8_t address, uint8_t *pdata)
 	address |= 0x40; // See datasheet. It sets the bit 6 to 1
 	*pdata = 0;
 	uint8_t tmp = 0;
+	// Status registers are part of the sampling path and take priority over configuration traffic
+	if (!Bus_Lock((address == (INT_SOURCE | 0xC0) || address == (FIFO_STATUS | 0xC0)) ? BUS_PRIORITY_SAMPLE : BUS_PRIORITY_CONFIG))
+	{
+		return ERR_BUSY;
+	}
+#ifdef ADXL_SPI_LL
+	if (SPI_LL_Enabled(spi))
+	{
+		uint8_t buffer[2] = {address, 0};
+		if (SPI_LL_Transfer(spi, buffer, 2))
+		{
+			ret_val = ERR_RECEIVE;
+		}
+		else
+		{
+			*pdata = buffer[1];
+		}
+		Bus_Unlock();
+		return ret_val;
+	}
+#endif
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_RESET);
+	Bus_Event(spi, false);
 	if (HAL_SPI_Transmit(spi, &address, 1, 100))
 	{
 		ret_val = ERR_TRANSMIT;
@@ -60,6 +241,8 @@ STATUS_ADXL Read_Byte(SPI_HandleTypeDef *spi, uint8_t address, uint8_t *pdata)
 		*pdata = tmp;
 	}
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	Bus_Event(spi, true);
+	Bus_Unlock();
 	return ret_val;
 }
 
@@ -80,7 +263,31 @@ STATUS_ADXL Read_6Bytes(SPI_HandleTypeDef *spi, uint8_t address, int16_t *x_axis
 	address |= 0x40; // See datasheet. It sets the bit 6 to 1
 
 	uint8_t tmp[6];
+	if (!Bus_Lock(BUS_PRIORITY_SAMPLE))
+	{
+		return ERR_BUSY;
+	}
+#ifdef ADXL_SPI_LL
+	if (SPI_LL_Enabled(spi))
+	{
+		// Address and six data bytes in one pipelined transaction
+		uint8_t buffer[7] = {address, 0, 0, 0, 0, 0, 0};
+		if (SPI_LL_Transfer(spi, buffer, 7))
+		{
+			ret_val = ERR_RECEIVE;
+		}
+		else
+		{
+			*x_axis = (int16_t)(buffer[2] << 8 | buffer[1]);
+			*y_axis = (int16_t)(buffer[4] << 8 | buffer[3]);
+			*z_axis = (int16_t)(buffer[6] << 8 | buffer[5]);
+		}
+		Bus_Unlock();
+		return ret_val;
+	}
+#endif
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_RESET);
+	Bus_Event(spi, false);
 	if (HAL_SPI_Transmit(spi, &address, 1, 100))
 	{
 		ret_val = ERR_TRANSMIT;
@@ -97,6 +304,67 @@ STATUS_ADXL Read_6Bytes(SPI_HandleTypeDef *spi, uint8_t address, int16_t *x_axis
 		*z_axis = (int16_t)(tmp[5] << 8 | tmp[4]);
 	}
 	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	Bus_Event(spi, true);
+	Bus_Unlock();
+	return ret_val;
+}
+
+/**
+ * @brief Function that reads consecutive registers in one multi-byte transaction
+ *
+ * @param spi SPI interface
+ * @param address First register address
+ * @param data Pointer to the values
+ * @param count Number of registers (1 - ADXL_BURST_MAX)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Read_Registers(SPI_HandleTypeDef *spi, uint8_t address, uint8_t *data, uint8_t count)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	address |= 0x80; // See datasheet. It sets the bit 7 to 1
+	address |= 0x40; // See datasheet. It sets the bit 6 to 1
+	if (count == 0 || count > ADXL_BURST_MAX)
+	{
+		return ERR_PARAM;
+	}
+	if (!Bus_Lock(BUS_PRIORITY_CONFIG))
+	{
+		return ERR_BUSY;
+	}
+#ifdef ADXL_SPI_LL
+	if (SPI_LL_Enabled(spi))
+	{
+		uint8_t buffer[ADXL_BURST_MAX + 1] = {0};
+		uint8_t i = 0;
+		buffer[0] = address;
+		if (SPI_LL_Transfer(spi, buffer, count + 1))
+		{
+			ret_val = ERR_RECEIVE;
+		}
+		else
+		{
+			for (i = 0; i < count; i++)
+			{
+				data[i] = buffer[i + 1];
+			}
+		}
+		Bus_Unlock();
+		return ret_val;
+	}
+#endif
+	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_RESET);
+	Bus_Event(spi, false);
+	if (HAL_SPI_Transmit(spi, &address, 1, 100))
+	{
+		ret_val = ERR_TRANSMIT;
+	}
+	else if (HAL_SPI_Receive(spi, data, count, 100))
+	{
+		ret_val = ERR_RECEIVE;
+	}
+	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	Bus_Event(spi, true);
+	Bus_Unlock();
 	return ret_val;
 }
 
@@ -334,6 +602,44 @@ STATUS_ADXL Set_Bandwidth_Rate(SPI_HandleTypeDef *spi, bool low_power, uint8_t r
 	return ret_val;
 }
 
+/**
+ * @brief Function that receives the bandwidth rate register
+ *
+ * @param spi SPI interface
+ * @param data Pointer to the bandwidth rate value (bit 4 LOW_POWER, bits 3:0 rate)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_Bandwidth_Rate(SPI_HandleTypeDef *spi, uint8_t *data)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t tmp = 0;
+	if (Read_Byte(spi, BW_RATE, &tmp))
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		*data = tmp;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that returns the sample period of a rate code. The output data rate is twice the bandwidth (0x0F: 3200 Hz ... 0x06: 6.25 Hz)
+ *
+ * @param rate Rate code (BANDWIDTH)
+ * @return uint32_t Sample period in ns
+ */
+uint32_t Sample_Period_Ns(uint8_t rate)
+{
+	rate &= 0x0F;
+	if (rate < BW_3_125_Hz)
+	{
+		rate = BW_3_125_Hz;
+	}
+	return 312500UL << (BW_1600_Hz - rate); // 3200 Hz -> 312.5 us
+}
+
 /******************************************************************************************************************************************************************************/
 /*																				Measures and calibrations																	  */
 /******************************************************************************************************************************************************************************/
@@ -713,3 +1019,96 @@ STATUS_ADXL Get_Interrupt_Source(SPI_HandleTypeDef *spi, t_IntSource *p_int_sour
 	p_int_source->overrun = ((byte >> OVERRUN_BIT) & 1);
 	return ret_val;
 }
+
+/******************************************************************************************************************************************************************************/
+/*																				FIFO Functions 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that receives the FIFO control register
+ *
+ * @param spi SPI interface
+ * @param data Pointer to the FIFO control value
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_FIFO_Control(SPI_HandleTypeDef *spi, uint8_t *data)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t tmp = 0;
+	if (Read_Byte(spi, FIFO_CTL, &tmp))
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		*data = tmp;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that sets the FIFO control register
+ *
+ * @param spi SPI interface
+ * @param mode FIFO mode (FIFO_MODE). To re-arm trigger mode the FIFO must go through bypass mode first
+ * @param trigger_pin 0 links the trigger event of trigger mode to INT1 and 1 to INT2
+ * @param samples Watermark level in FIFO and stream modes, number of samples kept before the trigger event in trigger mode (0-31)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Set_FIFO_Control(SPI_HandleTypeDef *spi, uint8_t mode, bool trigger_pin, uint8_t samples)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t data = 0;
+	data = (mode & 0x03) << 6 | trigger_pin << 5 | (samples & 0x1F);
+	if (Register_Write(spi, FIFO_CTL, data))
+	{
+		ret_val = ERR_WRITE;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that receives the FIFO status
+ *
+ * @param spi SPI interface
+ * @param triggered Pointer to the FIFO_TRIG bit. It is set when a trigger event occurs in trigger mode
+ * @param entries Pointer to the number of samples stored in the FIFO (0-32)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_FIFO_Status(SPI_HandleTypeDef *spi, bool *triggered, uint8_t *entries)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t tmp = 0;
+	if (Read_Byte(spi, FIFO_STATUS, &tmp))
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		*triggered = ((tmp >> FIFO_TRIGGER_BIT) & 1);
+		*entries = tmp & 0x3F;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that reads samples from the FIFO (one burst read of the data registers per entry)
+ *
+ * @param spi SPI interface
+ * @param samples Pointer to the destination array
+ * @param count Number of entries to read. It must not exceed the entries reported by Get_FIFO_Status
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Read_FIFO(SPI_HandleTypeDef *spi, t_Sample *samples, uint8_t count)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t i = 0;
+	for (i = 0; i < count && ret_val == STATUS_OK_ADXL; i++)
+	{
+		if (Read_6Bytes(spi, MEASUREMENTS_DATA, &samples[i].x, &samples[i].y, &samples[i].z))
+		{
+			ret_val = ERR_READING;
+		}
+	}
+	return ret_val;
+}
\ No newline at end of file
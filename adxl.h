@@ -1,8 +1,17 @@
+#ifndef ADXL_H
+#define ADXL_H
+
 #include "main.h"
+#include "adxl_types.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
 /******************************************************************************************************************************************************************************/
 /*																				 Registers and Variables 																	  */
 /******************************************************************************************************************************************************************************/
@@ -27,6 +36,8 @@
 #define SOFT_RESET 					0x18
 #define INT_SOURCE 					0x30
 #define BW_RATE 					0x2c
+#define FIFO_CTL 					0x38
+#define FIFO_STATUS 				0x39
 
 #define BIT0 						0x00 	// 0000 0000
 #define BIT1 						0x01	// 0000 0001
@@ -43,16 +54,13 @@
 #define ACTIVITY_BIT 				0x04
 #define DATA_READY_BIT 				0x07
 
-typedef enum STATUS_ADXL
-{
-	STATUS_OK_ADXL = 0x00,
-	ERR_SPI,
-	ERR_TRANSMIT,
-	ERR_RECEIVE,
-	ERR_READING,
-	ERR_WRITE,
-	ERR_ID
-} STATUS_ADXL;
+#ifndef ADXL_SPI_LL_DEVICES
+#define ADXL_SPI_LL_DEVICES 		2 		// devices that can use the register-level SPI path (build with ADXL_SPI_LL)
+#endif
+#define ADXL_SPI_LL_SPIN 			10000 	// status polls without progress before a register-level transfer gives up
+#define ADXL_BURST_MAX 				32 		// registers per Read_Registers transaction
+
+#define FIFO_TRIGGER_BIT 			0x07
 
 typedef enum HZ_SLEEP_MODE
 {
@@ -90,14 +98,15 @@ typedef enum BANDWIDTH
 	BW_1600_Hz
 } BANDWIDTH;
 
-typedef struct t_IntSource
+typedef enum FIFO_MODE
 {
-	bool data_ready;
-	bool activity;
-	bool inactivity;
-	bool watermark;
-	bool overrun;
-} t_IntSource;
+	FIFO_BYPASS = 0,
+	FIFO_FIFO,
+	FIFO_STREAM,
+	FIFO_TRIGGER
+} FIFO_MODE;
+
+typedef void (*BUS_HOOK)(SPI_HandleTypeDef *spi, bool complete, void *arg); // complete: false right after CS is asserted, true right after it is released
 
 /******************************************************************************************************************************************************************************/
 /*																				 SPI INTERFACE 																				  */
@@ -135,6 +144,36 @@ STATUS_ADXL Read_Byte(SPI_HandleTypeDef *spi, uint8_t address, uint8_t *pdata);
  */
 STATUS_ADXL Read_6Bytes(SPI_HandleTypeDef *spi, uint8_t address, int16_t *x_axis, int16_t *y_axis, int16_t *z_axis);
 
+/**
+ * @brief Function that reads consecutive registers in one multi-byte transaction
+ *
+ * @param spi SPI interface
+ * @param address First register address
+ * @param data Pointer to the values
+ * @param count Number of registers (1 - ADXL_BURST_MAX)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Read_Registers(SPI_HandleTypeDef *spi, uint8_t address, uint8_t *data, uint8_t count);
+
+/**
+ * @brief Function that selects the register-level SPI path for a device. It drives the SPI data register and CS directly instead of the HAL calls
+ * (only available when built with ADXL_SPI_LL, the SPI must be initialized by HAL_SPI_Init as 8-bit master)
+ *
+ * @param spi SPI interface
+ * @param enable true to use the register-level path
+ * @return STATUS_ADXL ERR_PARAM if the path is not built in or ADXL_SPI_LL_DEVICES devices already use it
+ */
+STATUS_ADXL Set_SPI_Fast_Path(SPI_HandleTypeDef *spi, bool enable);
+
+/**
+ * @brief Function that installs a hook called at both ends of every blocking transaction (HAL and register-level paths), inside the bus lock.
+ * Install it before the bus is in use: the pointer is not swapped atomically
+ *
+ * @param hook Hook, NULL to remove it
+ * @param arg Argument passed to the hook
+ */
+void Set_Bus_Hook(BUS_HOOK hook, void *arg);
+
 /******************************************************************************************************************************************************************************/
 /*																		Identification Functions																			  */
 /******************************************************************************************************************************************************************************/
@@ -240,6 +279,23 @@ STATUS_ADXL Set_Data_Format(SPI_HandleTypeDef *spi, bool self_test, bool spi_sta
  */
 STATUS_ADXL Set_Bandwidth_Rate(SPI_HandleTypeDef *spi, bool low_power, uint8_t rate);
 
+/**
+ * @brief Function that receives the bandwidth rate register
+ *
+ * @param spi SPI interface
+ * @param data Pointer to the bandwidth rate value (bit 4 LOW_POWER, bits 3:0 rate)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_Bandwidth_Rate(SPI_HandleTypeDef *spi, uint8_t *data);
+
+/**
+ * @brief Function that returns the sample period of a rate code. The output data rate is twice the bandwidth (0x0F: 3200 Hz ... 0x06: 6.25 Hz)
+ *
+ * @param rate Rate code (BANDWIDTH)
+ * @return uint32_t Sample period in ns
+ */
+uint32_t Sample_Period_Ns(uint8_t rate);
+
 /******************************************************************************************************************************************************************************/
 /*																				Measures and calibrations																	  */
 /******************************************************************************************************************************************************************************/
@@ -418,3 +474,53 @@ STATUS_ADXL Set_Interrupt_Pins(SPI_HandleTypeDef *spi, bool data_ready, bool act
  * @return STATUS_ADXL
  */
 STATUS_ADXL Get_Interrupt_Source(SPI_HandleTypeDef *spi, t_IntSource *p_int_source);
+
+/******************************************************************************************************************************************************************************/
+/*																				FIFO Functions 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that receives the FIFO control register
+ *
+ * @param spi SPI interface
+ * @param data Pointer to the FIFO control value
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_FIFO_Control(SPI_HandleTypeDef *spi, uint8_t *data);
+
+/**
+ * @brief Function that sets the FIFO control register
+ *
+ * @param spi SPI interface
+ * @param mode FIFO mode (FIFO_MODE). To re-arm trigger mode the FIFO must go through bypass mode first
+ * @param trigger_pin 0 links the trigger event of trigger mode to INT1 and 1 to INT2
+ * @param samples Watermark level in FIFO and stream modes, number of samples kept before the trigger event in trigger mode (0-31)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Set_FIFO_Control(SPI_HandleTypeDef *spi, uint8_t mode, bool trigger_pin, uint8_t samples);
+
+/**
+ * @brief Function that receives the FIFO status
+ *
+ * @param spi SPI interface
+ * @param triggered Pointer to the FIFO_TRIG bit. It is set when a trigger event occurs in trigger mode
+ * @param entries Pointer to the number of samples stored in the FIFO (0-32)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Get_FIFO_Status(SPI_HandleTypeDef *spi, bool *triggered, uint8_t *entries);
+
+/**
+ * @brief Function that reads samples from the FIFO (one burst read of the data registers per entry)
+ *
+ * @param spi SPI interface
+ * @param samples Pointer to the destination array
+ * @param count Number of entries to read. It must not exceed the entries reported by Get_FIFO_Status
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Read_FIFO(SPI_HandleTypeDef *spi, t_Sample *samples, uint8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_H */
@@ -0,0 +1,346 @@
+#include "adxl_align.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+#define POSITION_LIMIT 				((int64_t)1 << 38) // ns, about 275 s: keeps the Q24 offset of Align_Position in 64 bits
+
+/**
+ * @brief Function that returns the estimated time of a sample of a sensor
+ *
+ * @param channel Pointer to the sensor
+ * @param sequence Sequence number of the sample
+ * @return int64_t Time in ns since the epoch
+ */
+static int64_t Align_Time_Of(const t_AlignChannel *channel, uint32_t sequence)
+{
+	return channel->ref_time + (((int64_t)(int32_t)(sequence - channel->ref_sequence) * channel->period) >> 16);
+}
+
+/**
+ * @brief Function that converts a time into a sample position of a sensor
+ *
+ * @param channel Pointer to the sensor
+ * @param time Time in ns since the epoch
+ * @param sequence Pointer to the sequence number of the sample at or before the time
+ * @param mu Pointer to the fraction of a period after that sample, Q15
+ */
+static void Align_Position(const t_AlignChannel *channel, int64_t time, uint32_t *sequence, int32_t *mu)
+{
+	int64_t offset = time - channel->ref_time;
+	int64_t numerator = 0;
+	int64_t denominator = channel->period >> 8;
+	int64_t position = 0;
+	// A sensor that stalled for minutes is far behind the frame: the clamped position is still far outside its history
+	if (offset > POSITION_LIMIT)
+	{
+		offset = POSITION_LIMIT;
+	}
+	else if (offset < -POSITION_LIMIT)
+	{
+		offset = -POSITION_LIMIT;
+	}
+	numerator = offset * (1 << 24);
+	position = numerator / denominator; // Q16 samples after ref_sequence
+	if (numerator % denominator != 0 && numerator < 0)
+	{
+		position--;
+	}
+	*sequence = channel->ref_sequence + (uint32_t)(position >> 16);
+	*mu = (int32_t)((position & 0xFFFF) >> 1);
+}
+
+/**
+ * @brief Function that returns the time of the first frame every sensor can interpolate
+ *
+ * @param align Pointer to the alignment
+ * @return int64_t Time in ns since the epoch
+ */
+static int64_t Align_Start(const t_Align *align)
+{
+	int64_t start = 0;
+	int64_t time = 0;
+	uint8_t i = 0;
+	for (i = 0; i < align->channels; i++)
+	{
+		// One sample before the frame is needed by the interpolator
+		time = Align_Time_Of(&align->channel[i], align->channel[i].next_sequence - align->channel[i].stored + 1);
+		if (i == 0 || time > start)
+		{
+			start = time;
+		}
+	}
+	return start;
+}
+
+/**
+ * @brief Function that emits every frame the sensors cover. A late sensor is waited for until another sensor is half a history ahead
+ *
+ * @param align Pointer to the alignment
+ */
+static void Align_Emit(t_Align *align)
+{
+	t_AlignChannel *channel = NULL;
+	const t_Sample *h = NULL;
+	uint32_t sequence = 0;
+	uint32_t mask = ALIGN_HISTORY - 1;
+	int32_t mu = 0;
+	int32_t newest = 0;
+	int32_t oldest = 0;
+	int64_t start = 0;
+	int64_t skip = 0;
+	bool ready = true;
+	bool ahead = false;
+	uint8_t i = 0;
+
+	if (!align->running)
+	{
+		for (i = 0; i < align->channels; i++)
+		{
+			if (!align->channel[i].started)
+			{
+				return;
+			}
+		}
+		// Frames sit on multiples of the grid period after the epoch, so frame n is at epoch + n * period
+		start = Align_Start(align);
+		skip = start / align->period;
+		if (skip * align->period < start)
+		{
+			skip++;
+		}
+		align->next_time = skip * align->period;
+		align->frame.sequence = (uint32_t)skip;
+		align->running = true;
+	}
+	while (true)
+	{
+		ready = true;
+		ahead = false;
+		align->frame.valid = 0;
+		for (i = 0; i < align->channels; i++)
+		{
+			channel = &align->channel[i];
+			Align_Position(channel, align->next_time, &sequence, &mu);
+			newest = (int32_t)(channel->next_sequence - 1 - sequence);
+			oldest = (int32_t)(sequence - (channel->next_sequence - channel->stored));
+			if (newest < 2)
+			{
+				ready = false;
+				continue;
+			}
+			if (newest >= ALIGN_HISTORY / 2)
+			{
+				ahead = true;
+			}
+			if (oldest >= 1)
+			{
+				h = channel->history;
+				align->frame.samples[i].x = Align_Interpolate(h[(sequence - 1) & mask].x, h[sequence & mask].x, h[(sequence + 1) & mask].x, h[(sequence + 2) & mask].x, mu);
+				align->frame.samples[i].y = Align_Interpolate(h[(sequence - 1) & mask].y, h[sequence & mask].y, h[(sequence + 1) & mask].y, h[(sequence + 2) & mask].y, mu);
+				align->frame.samples[i].z = Align_Interpolate(h[(sequence - 1) & mask].z, h[sequence & mask].z, h[(sequence + 1) & mask].z, h[(sequence + 2) & mask].z, mu);
+				align->frame.valid |= (uint8_t)(1 << i);
+			}
+		}
+		if (!ready && !ahead)
+		{
+			break;
+		}
+		if (align->frame.valid == 0 && ready)
+		{
+			// Every sensor has moved past the frame (long stall): jump to the oldest time they still cover, keeping the grid phase
+			start = Align_Start(align);
+			if (start > align->next_time)
+			{
+				skip = (start - align->next_time + align->period - 1) / align->period;
+				align->next_time += skip * align->period;
+				align->frame.sequence += (uint32_t)skip;
+				continue;
+			}
+		}
+		if (!ready)
+		{
+			align->forced++;
+		}
+		align->frame.timestamp = align->epoch + (uint64_t)(align->next_time / 1000);
+		if (align->output)
+		{
+			align->output(&align->frame, align->arg);
+		}
+		align->frame.sequence++;
+		align->next_time += align->period;
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Time Alignment 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the alignment of several sample streams onto one time grid
+ *
+ * @param align Pointer to the alignment
+ * @param channels Number of sensors (at most ALIGN_MAX_SENSORS)
+ * @param period Grid period in ns
+ * @param output Function called with every aligned frame
+ * @param arg User argument for output
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Align_Init(t_Align *align, uint8_t channels, uint32_t period, ALIGN_OUTPUT output, void *arg)
+{
+	uint8_t i = 0;
+	if (channels == 0 || channels > ALIGN_MAX_SENSORS || period == 0)
+	{
+		return ERR_PARAM;
+	}
+	for (i = 0; i < ALIGN_MAX_SENSORS; i++)
+	{
+		align->channel[i].started = false;
+		align->channel[i].stored = 0;
+	}
+	align->channels = channels;
+	align->period = period;
+	align->epoch = 0;
+	align->epoch_set = false;
+	align->running = false;
+	align->next_time = 0;
+	align->frame.sequence = 0;
+	align->output = output;
+	align->arg = arg;
+	align->forced = 0;
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that adds a block of one sensor (see adxl_stream.h), updates its rate estimate and emits every frame that can be interpolated
+ *
+ * @param align Pointer to the alignment
+ * @param channel Sensor number
+ * @param block Sample block
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Align_Push(t_Align *align, uint8_t channel, const t_SampleBlock *block)
+{
+	t_AlignChannel *c = NULL;
+	uint32_t newest = 0;
+	uint64_t interrupt = 0;
+	uint32_t elapsed = 0;
+	int64_t predicted = 0;
+	int64_t error = 0;
+	uint8_t shift = 0;
+	uint16_t i = 0;
+
+	if (channel >= align->channels || block->count == 0 || block->period == 0)
+	{
+		return ERR_PARAM;
+	}
+	c = &align->channel[channel];
+	// The newest sample is the one converted when the interrupt fired: it carries the measured time
+	newest = block->sequence + block->count - 1;
+	interrupt = block->timestamp + ((uint64_t)(block->count - 1) * block->period) / 1000;
+	if (!align->epoch_set)
+	{
+		align->epoch = interrupt;
+		align->epoch_set = true;
+	}
+	c->last_ns = (int64_t)(interrupt - align->epoch) * 1000;
+
+	if (!c->started || block->period != c->nominal || (int32_t)(block->sequence - c->next_sequence) < 0)
+	{
+		// First block, rate change or restarted numbering: restart the tracker from the nominal period
+		c->started = true;
+		c->nominal = block->period;
+		c->period = (int64_t)block->period << 16;
+		c->ref_sequence = newest;
+		c->ref_time = c->last_ns;
+		c->residual = 0;
+		c->updates = 0;
+		c->stored = 0;
+	}
+	else
+	{
+		if (block->sequence != c->next_sequence)
+		{
+			c->stored = 0;
+		}
+		elapsed = newest - c->ref_sequence;
+		predicted = Align_Time_Of(c, newest);
+		error = c->last_ns - predicted;
+		// Alpha-beta tracker. The gains start at 1 (two-point estimate) and halve at every update down to the settled values
+		if (c->updates < 0xFFFF)
+		{
+			c->updates++;
+		}
+		shift = (uint8_t)((c->updates - 1) < ALIGN_PHASE_SHIFT ? (c->updates - 1) : ALIGN_PHASE_SHIFT);
+		c->ref_time = predicted + (error >> shift);
+		shift = (uint8_t)((c->updates - 1) < ALIGN_RATE_SHIFT ? (c->updates - 1) : ALIGN_RATE_SHIFT);
+		if (elapsed > 0)
+		{
+			c->period += ((error * 65536) / (int64_t)elapsed) >> shift;
+		}
+		c->ref_sequence = newest;
+		c->residual = (int32_t)(error > INT32_MAX ? INT32_MAX : (error < INT32_MIN ? INT32_MIN : error));
+	}
+
+	for (i = 0; i < block->count; i++)
+	{
+		c->history[(block->sequence + i) & (ALIGN_HISTORY - 1)] = block->samples[i];
+	}
+	c->next_sequence = block->sequence + block->count;
+	c->stored = (uint16_t)((c->stored + block->count) > ALIGN_HISTORY ? ALIGN_HISTORY : (c->stored + block->count));
+
+	Align_Emit(align);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that returns the estimated deviation of a sensor from its nominal rate
+ *
+ * @param align Pointer to the alignment
+ * @param channel Sensor number
+ * @return int32_t Deviation in ppm, positive if the sensor is slower than nominal
+ */
+int32_t Align_Rate_Ppm(const t_Align *align, uint8_t channel)
+{
+	const t_AlignChannel *c = NULL;
+	int64_t nominal = 0;
+	if (channel >= align->channels || !align->channel[channel].started)
+	{
+		return 0;
+	}
+	c = &align->channel[channel];
+	nominal = (int64_t)c->nominal << 16;
+	return (int32_t)(((c->period - nominal) * 1000000) / nominal);
+}
+
+/**
+ * @brief Function that interpolates between x0 and x1 with a cubic Lagrange Farrow structure
+ *
+ * @param xm1 Sample before x0
+ * @param x0 Sample at mu = 0
+ * @param x1 Sample at mu = 1
+ * @param x2 Sample after x1
+ * @param mu Fractional position, Q15
+ * @return int16_t
+ */
+int16_t Align_Interpolate(int16_t xm1, int16_t x0, int16_t x1, int16_t x2, int32_t mu)
+{
+	// Polynomial coefficients scaled by 6, evaluated with Horner's rule
+	int64_t c3 = -(int64_t)xm1 + 3 * (int64_t)x0 - 3 * (int64_t)x1 + x2;
+	int64_t c2 = 3 * (int64_t)xm1 - 6 * (int64_t)x0 + 3 * (int64_t)x1;
+	int64_t c1 = -2 * (int64_t)xm1 - 3 * (int64_t)x0 + 6 * (int64_t)x1 - x2;
+	int64_t value = ((c3 * mu) >> 15) + c2;
+	value = ((value * mu) >> 15) + c1;
+	value = (value * mu) >> 15;
+	value = x0 + (value >= 0 ? (value + 3) / 6 : (value - 3) / 6);
+	if (value > INT16_MAX)
+	{
+		value = INT16_MAX;
+	}
+	else if (value < INT16_MIN)
+	{
+		value = INT16_MIN;
+	}
+	return (int16_t)value;
+}
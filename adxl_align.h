@@ -0,0 +1,115 @@
+#ifndef ADXL_ALIGN_H
+#define ADXL_ALIGN_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef ALIGN_MAX_SENSORS
+#define ALIGN_MAX_SENSORS 			4
+#endif
+
+#define ALIGN_HISTORY 				64 		// samples kept per sensor, power of two
+#define ALIGN_PHASE_SHIFT 			3 		// phase gain of the rate tracker once settled (1/8)
+#define ALIGN_RATE_SHIFT 			8 		// rate gain of the rate tracker once settled (1/256)
+
+typedef struct t_AlignedFrame
+{
+	uint32_t sequence; 				// frame number n, at epoch + n * period
+	uint64_t timestamp; 			// grid time in us
+	uint8_t valid; 					// bit n set if samples[n] holds data (cleared during gaps)
+	t_Sample samples[ALIGN_MAX_SENSORS];
+} t_AlignedFrame;
+
+typedef void (*ALIGN_OUTPUT)(const t_AlignedFrame *frame, void *arg);
+
+typedef struct t_AlignChannel
+{
+	t_Sample history[ALIGN_HISTORY]; // sample with sequence n at n % ALIGN_HISTORY
+	uint32_t next_sequence; 		// one past the newest stored sample
+	uint16_t stored; 				// contiguous samples in the history
+	uint32_t nominal; 				// nominal sample period in ns
+	uint32_t ref_sequence; 			// sequence of the tracker reference
+	int64_t ref_time; 				// estimated time of ref_sequence in ns since the epoch
+	int64_t period; 				// estimated sample period in ns, Q16
+	int64_t last_ns; 				// last interrupt time in ns since the epoch
+	int32_t residual; 				// last timing error of the tracker in ns
+	uint16_t updates;
+	bool started;
+} t_AlignChannel;
+
+typedef struct t_Align
+{
+	t_AlignChannel channel[ALIGN_MAX_SENSORS];
+	uint8_t channels;
+	uint32_t period; 				// grid period in ns
+	uint64_t epoch; 				// time of the first interrupt in us
+	bool epoch_set;
+	bool running;
+	int64_t next_time; 				// time of the next frame in ns since the epoch
+	t_AlignedFrame frame;
+	ALIGN_OUTPUT output;
+	void *arg;
+	uint32_t forced; 				// frames emitted without waiting for a late sensor
+} t_Align;
+
+/******************************************************************************************************************************************************************************/
+/*																				Time Alignment 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the alignment of several sample streams onto one time grid
+ *
+ * @param align Pointer to the alignment
+ * @param channels Number of sensors (at most ALIGN_MAX_SENSORS)
+ * @param period Grid period in ns
+ * @param output Function called with every aligned frame
+ * @param arg User argument for output
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Align_Init(t_Align *align, uint8_t channels, uint32_t period, ALIGN_OUTPUT output, void *arg);
+
+/**
+ * @brief Function that adds a block of one sensor (see adxl_stream.h), updates its rate estimate and emits every frame that can be interpolated
+ *
+ * @param align Pointer to the alignment
+ * @param channel Sensor number
+ * @param block Sample block
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Align_Push(t_Align *align, uint8_t channel, const t_SampleBlock *block);
+
+/**
+ * @brief Function that returns the estimated deviation of a sensor from its nominal rate
+ *
+ * @param align Pointer to the alignment
+ * @param channel Sensor number
+ * @return int32_t Deviation in ppm, positive if the sensor is slower than nominal
+ */
+int32_t Align_Rate_Ppm(const t_Align *align, uint8_t channel);
+
+/**
+ * @brief Function that interpolates between x0 and x1 with a cubic Lagrange Farrow structure
+ *
+ * @param xm1 Sample before x0
+ * @param x0 Sample at mu = 0
+ * @param x1 Sample at mu = 1
+ * @param x2 Sample after x1
+ * @param mu Fractional position, Q15
+ * @return int16_t
+ */
+int16_t Align_Interpolate(int16_t xm1, int16_t x0, int16_t x1, int16_t x2, int32_t mu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_ALIGN_H */
@@ -0,0 +1,251 @@
+#include "adxl_allan.h"
+#include <math.h>
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that adds a sum of 2^level samples to the cascade. Each sum adds one cluster difference of 2^(level+1) samples,
+ * and every second sum is paired into the level above
+ *
+ * @param level Pointer to the levels of one axis
+ * @param index Level of the sum
+ * @param value Sum of 2^index samples
+ */
+static void Allan_Push(t_AllanLevel *level, uint8_t index, int64_t value)
+{
+	t_AllanLevel *l = NULL;
+	int64_t difference = 0;
+	while (index < ALLAN_LEVELS)
+	{
+		l = &level[index];
+		l->history[3] = l->history[2];
+		l->history[2] = l->history[1];
+		l->history[1] = l->history[0];
+		l->history[0] = value;
+		l->sums++;
+		if (index == 0 && l->sums >= 2)
+		{
+			// Clusters of one sample: consecutive samples
+			difference = l->history[0] - l->history[1];
+			l->squares += (double)difference * (double)difference;
+			l->terms++;
+		}
+		if (index + 1 < ALLAN_LEVELS && l->sums >= 4)
+		{
+			// Two adjacent clusters of 2^(index+1) samples, each made of two sums of this level
+			difference = (l->history[0] + l->history[1]) - (l->history[2] + l->history[3]);
+			level[index + 1].squares += (double)difference * (double)difference;
+			level[index + 1].terms++;
+		}
+		if (l->sums & 1)
+		{
+			l->pair = value;
+			break;
+		}
+		value += l->pair;
+		index++;
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Allan Deviation 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes an overlapping Allan deviation accumulator. Clusters of 2^k samples start every 2^(k-1) samples (50% overlap),
+ * so memory is fixed and independent of the capture length
+ *
+ * @param allan Pointer to the accumulator
+ * @param rate Rate code of the capture (BANDWIDTH)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Allan_Init(t_Allan *allan, uint8_t rate, uint8_t data_format)
+{
+	uint8_t a = 0;
+	uint8_t i = 0;
+	if (rate < BW_3_125_Hz || rate > BW_1600_Hz)
+	{
+		return ERR_PARAM;
+	}
+	for (a = 0; a < 3; a++)
+	{
+		for (i = 0; i < ALLAN_LEVELS; i++)
+		{
+			allan->level[a][i].sums = 0;
+			allan->level[a][i].squares = 0.0;
+			allan->level[a][i].terms = 0;
+		}
+	}
+	allan->period = Sample_Period_Ns(rate);
+	allan->lsb_per_g = Format_Lsb_Per_G(data_format);
+	allan->samples = 0;
+	allan->gaps = 0;
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that adds a block of samples (see adxl_stream.h). It can be used directly as the on_block callback of a stream or a replay
+ *
+ * @param block Sample block
+ * @param arg Pointer to the accumulator
+ */
+void Allan_On_Block(const t_SampleBlock *block, void *arg)
+{
+	t_Allan *allan = (t_Allan *)arg;
+	uint16_t i = 0;
+	for (i = 0; i < block->count; i++)
+	{
+		Allan_Push(allan->level[0], 0, block->samples[i].x);
+		Allan_Push(allan->level[1], 0, block->samples[i].y);
+		Allan_Push(allan->level[2], 0, block->samples[i].z);
+	}
+	allan->samples += block->count;
+}
+
+/**
+ * @brief Function that handles lost samples: no cluster difference spans the gap. It can be used directly as the on_gap callback
+ *
+ * @param gap Gap record
+ * @param arg Pointer to the accumulator
+ */
+void Allan_On_Gap(const t_Gap *gap, void *arg)
+{
+	t_Allan *allan = (t_Allan *)arg;
+	uint8_t a = 0;
+	uint8_t i = 0;
+	(void)gap;
+	// Keep the accumulated differences, restart the partial sums
+	for (a = 0; a < 3; a++)
+	{
+		for (i = 0; i < ALLAN_LEVELS; i++)
+		{
+			allan->level[a][i].sums = 0;
+		}
+	}
+	allan->gaps++;
+}
+
+/**
+ * @brief Function that computes the deviation curve and the noise figures per axis
+ *
+ * @param allan Pointer to the accumulator
+ * @param report Pointer to the report
+ */
+void Allan_Report(const t_Allan *allan, t_AllanReport *report)
+{
+	const t_AllanLevel *l = NULL;
+	float scale = 1e6f / (float)allan->lsb_per_g;
+	float slope = 0.0f;
+	float white = 0.0f;
+	float walk = 0.0f;
+	uint8_t white_count = 0;
+	uint8_t walk_count = 0;
+	double m = 0.0;
+	uint8_t a = 0;
+	uint8_t i = 0;
+
+	report->levels = 0;
+	while (report->levels < ALLAN_LEVELS && allan->level[0][report->levels].terms >= ALLAN_MIN_TERMS)
+	{
+		report->levels++;
+	}
+	for (i = 0; i < report->levels; i++)
+	{
+		report->tau[i] = (float)((double)((uint64_t)1 << i) * allan->period * 1e-9);
+	}
+	for (a = 0; a < 3; a++)
+	{
+		report->bias_instability[a] = 0.0f;
+		report->bias_tau[a] = 0.0f;
+		for (i = 0; i < report->levels; i++)
+		{
+			// AVAR = <(difference of cluster averages)^2> / 2, the sums are m times the averages
+			l = &allan->level[a][i];
+			m = (double)((uint64_t)1 << i);
+			report->deviation[a][i] = (float)sqrt(l->squares / (2.0 * l->terms * m * m)) * scale;
+			if (i == 0 || report->deviation[a][i] < report->bias_instability[a])
+			{
+				report->bias_instability[a] = report->deviation[a][i];
+				report->bias_tau[a] = report->tau[i];
+			}
+		}
+		report->bias_instability[a] /= ALLAN_BIAS_FACTOR;
+
+		// White noise: sigma = N / sqrt(tau). Rate random walk: sigma = K * sqrt(tau / 3)
+		white = 0.0f;
+		walk = 0.0f;
+		white_count = 0;
+		walk_count = 0;
+		for (i = 0; i + 1 < report->levels; i++)
+		{
+			if (report->deviation[a][i] <= 0.0f || report->deviation[a][i + 1] <= 0.0f)
+			{
+				continue;
+			}
+			slope = log2f(report->deviation[a][i + 1] / report->deviation[a][i]);
+			if (slope > -0.65f && slope < -0.35f)
+			{
+				white += report->deviation[a][i] * sqrtf(report->tau[i]);
+				white_count++;
+			}
+			else if (slope > 0.35f && slope < 0.65f)
+			{
+				walk += report->deviation[a][i + 1] * sqrtf(3.0f / report->tau[i + 1]);
+				walk_count++;
+			}
+		}
+		if (white_count == 0 && report->levels > 0)
+		{
+			white = report->deviation[a][0] * sqrtf(report->tau[0]);
+			white_count = 1;
+		}
+		report->noise_density[a] = white_count ? white / white_count : 0.0f;
+		report->random_walk[a] = walk_count ? walk / walk_count : 0.0f;
+	}
+}
+
+/**
+ * @brief Function that moves a characterization sweep to the next setting (every BANDWIDTH in normal mode, and in low power where the
+ * sensor supports it), writes BW_RATE and restarts the accumulator. Capture for the wanted time between calls, then call Allan_Report
+ *
+ * @param spi SPI interface
+ * @param sweep Pointer to the sweep (zero it and set data_format before the first call)
+ * @param allan Pointer to the accumulator
+ * @return STATUS_ADXL ERR_PARAM once every setting has been visited
+ */
+STATUS_ADXL Allan_Sweep_Next(SPI_HandleTypeDef *spi, t_AllanSweep *sweep, t_Allan *allan)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (!sweep->started)
+	{
+		sweep->rate = BW_3_125_Hz;
+		sweep->low_power = false;
+		sweep->started = true;
+	}
+	else if (!sweep->low_power && sweep->rate >= BW_6_25_Hz && sweep->rate <= BW_200_Hz)
+	{
+		// Low power is available from 12.5 Hz to 400 Hz output data rate
+		sweep->low_power = true;
+	}
+	else
+	{
+		sweep->low_power = false;
+		sweep->rate++;
+	}
+	if (sweep->rate > BW_1600_Hz)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else if (Set_Bandwidth_Rate(spi, sweep->low_power, sweep->rate))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else
+	{
+		ret_val = Allan_Init(allan, sweep->rate, sweep->data_format);
+	}
+	return ret_val;
+}
@@ -0,0 +1,114 @@
+#ifndef ADXL_ALLAN_H
+#define ADXL_ALLAN_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef ALLAN_LEVELS
+#define ALLAN_LEVELS 				28 		// cluster sizes 2^0 .. 2^27 samples (about 23 h at 3200 Hz)
+#endif
+
+#define ALLAN_MIN_TERMS 			8 		// differences a cluster size needs before it is reported
+#define ALLAN_BIAS_FACTOR 			0.664f 	// flicker floor of the Allan deviation over the bias instability
+
+typedef struct t_AllanLevel
+{
+	int64_t history[4]; 			// newest first: sums of 2^level consecutive samples, one every 2^level samples
+	int64_t pair; 					// first half of the next sum of the level above
+	uint32_t sums; 					// sums received since the start or the last gap
+	double squares; 				// squared differences of the clusters of 2^level samples (sum domain)
+	uint32_t terms;
+} t_AllanLevel;
+
+typedef struct t_Allan
+{
+	t_AllanLevel level[3][ALLAN_LEVELS];
+	uint32_t period; 				// sample period in ns
+	uint32_t lsb_per_g; 			// output scale from DATA_FORMAT
+	uint64_t samples;
+	uint32_t gaps;
+} t_Allan;
+
+typedef struct t_AllanReport
+{
+	uint8_t levels; 				// reported cluster sizes
+	float tau[ALLAN_LEVELS]; 		// s
+	float deviation[3][ALLAN_LEVELS]; // Allan deviation per axis in ug
+	float noise_density[3]; 		// ug/sqrt(Hz), from the -1/2 slope region
+	float bias_instability[3]; 		// ug, minimum deviation / 0.664
+	float bias_tau[3]; 				// s, cluster time of the minimum
+	float random_walk[3]; 			// ug/sqrt(s), from the +1/2 slope region (0 if the capture is too short to show it)
+} t_AllanReport;
+
+typedef struct t_AllanSweep
+{
+	uint8_t rate; 					// BANDWIDTH under test
+	bool low_power;
+	bool started;
+	uint8_t data_format; 			// DATA_FORMAT register value kept during the sweep
+} t_AllanSweep;
+
+/******************************************************************************************************************************************************************************/
+/*																				Allan Deviation 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes an overlapping Allan deviation accumulator. Clusters of 2^k samples start every 2^(k-1) samples (50% overlap),
+ * so memory is fixed and independent of the capture length
+ *
+ * @param allan Pointer to the accumulator
+ * @param rate Rate code of the capture (BANDWIDTH)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Allan_Init(t_Allan *allan, uint8_t rate, uint8_t data_format);
+
+/**
+ * @brief Function that adds a block of samples (see adxl_stream.h). It can be used directly as the on_block callback of a stream or a replay
+ *
+ * @param block Sample block
+ * @param arg Pointer to the accumulator
+ */
+void Allan_On_Block(const t_SampleBlock *block, void *arg);
+
+/**
+ * @brief Function that handles lost samples: no cluster difference spans the gap. It can be used directly as the on_gap callback
+ *
+ * @param gap Gap record
+ * @param arg Pointer to the accumulator
+ */
+void Allan_On_Gap(const t_Gap *gap, void *arg);
+
+/**
+ * @brief Function that computes the deviation curve and the noise figures per axis
+ *
+ * @param allan Pointer to the accumulator
+ * @param report Pointer to the report
+ */
+void Allan_Report(const t_Allan *allan, t_AllanReport *report);
+
+/**
+ * @brief Function that moves a characterization sweep to the next setting (every BANDWIDTH in normal mode, and in low power where the
+ * sensor supports it), writes BW_RATE and restarts the accumulator. Capture for the wanted time between calls, then call Allan_Report
+ *
+ * @param spi SPI interface
+ * @param sweep Pointer to the sweep (zero it and set data_format before the first call)
+ * @param allan Pointer to the accumulator
+ * @return STATUS_ADXL ERR_PARAM once every setting has been visited
+ */
+STATUS_ADXL Allan_Sweep_Next(SPI_HandleTypeDef *spi, t_AllanSweep *sweep, t_Allan *allan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_ALLAN_H */
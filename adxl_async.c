@@ -0,0 +1,294 @@
+#include "adxl_async.h"
+#include "adxl_os.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that starts one full-duplex transfer of the context buffers
+ *
+ * @param async Pointer to the context
+ * @param size Number of bytes (address byte included)
+ * @return STATUS_ADXL
+ */
+static STATUS_ADXL Async_Start_Transfer(t_Async *async, uint16_t size)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_RESET);
+	if (HAL_SPI_TransmitReceive_IT(async->spi, async->tx, async->rx, size))
+	{
+		HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+		ret_val = ERR_SPI;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that starts the next transfer of the current operation
+ *
+ * @param async Pointer to the context
+ * @return STATUS_ADXL
+ */
+static STATUS_ADXL Async_Next(t_Async *async)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	switch (async->operation)
+	{
+	case ASYNC_READ_SAMPLES:
+		async->tx[0] = MEASUREMENTS_DATA | 0x80 | 0x40; // read + multi-byte, see datasheet
+		ret_val = Async_Start_Transfer(async, ASYNC_FRAME_SIZE);
+		break;
+	case ASYNC_WRITE_REGISTERS:
+		async->tx[0] = async->addresses[async->done] | 0x40;
+		async->tx[1] = async->values[async->done];
+		ret_val = Async_Start_Transfer(async, 2);
+		break;
+	case ASYNC_READ_INT_SOURCE:
+		async->tx[0] = INT_SOURCE | 0x80 | 0x40;
+		ret_val = Async_Start_Transfer(async, 2);
+		break;
+	default:
+		ret_val = ERR_SPI;
+		break;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that ends the current operation and calls the user callback
+ *
+ * @param async Pointer to the context
+ * @param status Result of the operation
+ */
+static void Async_Finish(t_Async *async, STATUS_ADXL status)
+{
+	ASYNC_CALLBACK callback = async->callback;
+	void *arg = async->arg;
+	Bus_Unlock_Async();
+	__atomic_store_n(&async->operation, ASYNC_IDLE, __ATOMIC_RELEASE);
+	if (callback)
+	{
+		callback(status, arg);
+	}
+}
+
+/**
+ * @brief Function that claims the context and the bus for an operation. The compare-and-swap makes two callers racing on an idle
+ * context, a task and an interrupt handler for instance, see exactly one success
+ *
+ * @param async Pointer to the context
+ * @param operation Operation to claim
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or the bus is held
+ */
+static STATUS_ADXL Async_Claim(t_Async *async, ASYNC_OPERATION operation)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	ASYNC_OPERATION idle = ASYNC_IDLE;
+	if (!__atomic_compare_exchange_n(&async->operation, &idle, operation, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		ret_val = ERR_BUSY;
+	}
+	else if (!Bus_Try_Lock_Async(operation == ASYNC_WRITE_REGISTERS ? BUS_PRIORITY_CONFIG : BUS_PRIORITY_SAMPLE))
+	{
+		// A blocking transaction owns the bus: starting now would assert CS in the middle of it
+		__atomic_store_n(&async->operation, ASYNC_IDLE, __ATOMIC_RELEASE);
+		ret_val = ERR_BUSY;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that starts the first transfer of a claimed operation, releasing the claim if it cannot start
+ *
+ * @param async Pointer to the context, claimed by Async_Claim
+ * @param count Number of transfers
+ * @param callback User callback
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL
+ */
+static STATUS_ADXL Async_Begin(t_Async *async, uint16_t count, ASYNC_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	async->count = count;
+	async->done = 0;
+	async->callback = callback;
+	async->arg = arg;
+	if (count == 0)
+	{
+		Async_Finish(async, STATUS_OK_ADXL);
+	}
+	else if (Async_Next(async))
+	{
+		Bus_Unlock_Async();
+		__atomic_store_n(&async->operation, ASYNC_IDLE, __ATOMIC_RELEASE);
+		ret_val = ERR_SPI;
+	}
+	return ret_val;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																			Non-blocking Operations																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that binds an asynchronous context to an SPI interface. The context holds every buffer the transfers need, so no memory is allocated per operation
+ *
+ * @param async Pointer to the context
+ * @param spi SPI interface
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Async_Init(t_Async *async, SPI_HandleTypeDef *spi)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t i = 0;
+	async->spi = spi;
+	async->operation = ASYNC_IDLE;
+	for (i = 0; i < ASYNC_FRAME_SIZE; i++)
+	{
+		async->tx[i] = 0;
+		async->rx[i] = 0;
+	}
+	async->samples = NULL;
+	async->addresses = NULL;
+	async->values = NULL;
+	async->int_source = NULL;
+	async->count = 0;
+	async->done = 0;
+	async->callback = NULL;
+	async->arg = NULL;
+	return ret_val;
+}
+
+/**
+ * @brief Function that reads samples from the data registers (one FIFO entry per transfer) without blocking
+ *
+ * @param async Pointer to the context
+ * @param samples Pointer to the destination array. It must stay valid until the callback is called
+ * @param count Number of samples to read
+ * @param callback Function called when the last transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Read_Samples(t_Async *async, t_Sample *samples, uint16_t count, ASYNC_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = Async_Claim(async, ASYNC_READ_SAMPLES);
+	if (ret_val == STATUS_OK_ADXL)
+	{
+		async->samples = samples;
+		ret_val = Async_Begin(async, count, callback, arg);
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that writes a list of registers without blocking (one transfer per register)
+ *
+ * @param async Pointer to the context
+ * @param addresses Pointer to the register addresses. It must stay valid until the callback is called
+ * @param values Pointer to the values to write
+ * @param count Number of registers
+ * @param callback Function called when the last transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Write_Registers(t_Async *async, const uint8_t *addresses, const uint8_t *values, uint16_t count, ASYNC_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = Async_Claim(async, ASYNC_WRITE_REGISTERS);
+	if (ret_val == STATUS_OK_ADXL)
+	{
+		async->addresses = addresses;
+		async->values = values;
+		ret_val = Async_Begin(async, count, callback, arg);
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that reads and decodes the interrupt source register without blocking
+ *
+ * @param async Pointer to the context
+ * @param p_int_source Pointer to struct. It must stay valid until the callback is called
+ * @param callback Function called when the transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Read_Interrupt_Source(t_Async *async, t_IntSource *p_int_source, ASYNC_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = Async_Claim(async, ASYNC_READ_INT_SOURCE);
+	if (ret_val == STATUS_OK_ADXL)
+	{
+		async->int_source = p_int_source;
+		ret_val = Async_Begin(async, 1, callback, arg);
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that returns true while an operation is in flight
+ *
+ * @param async Pointer to the context
+ * @return bool
+ */
+bool Async_Is_Busy(const t_Async *async)
+{
+	return async->operation != ASYNC_IDLE;
+}
+
+/**
+ * @brief Function that must be called from HAL_SPI_TxRxCpltCallback for the SPI interface of the context
+ *
+ * @param async Pointer to the context
+ */
+void Async_Transfer_Complete(t_Async *async)
+{
+	uint8_t byte = 0;
+	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	switch (async->operation)
+	{
+	case ASYNC_READ_SAMPLES:
+		async->samples[async->done].x = (int16_t)(async->rx[2] << 8 | async->rx[1]);
+		async->samples[async->done].y = (int16_t)(async->rx[4] << 8 | async->rx[3]);
+		async->samples[async->done].z = (int16_t)(async->rx[6] << 8 | async->rx[5]);
+		break;
+	case ASYNC_READ_INT_SOURCE:
+		byte = async->rx[1];
+		async->int_source->data_ready = ((byte >> DATA_READY_BIT) & 1);
+		async->int_source->activity = ((byte >> ACTIVITY_BIT) & 1);
+		async->int_source->inactivity = ((byte >> INACTIVITY_BIT) & 1);
+		async->int_source->watermark = ((byte >> WATERMARK_BIT) & 1);
+		async->int_source->overrun = ((byte >> OVERRUN_BIT) & 1);
+		break;
+	case ASYNC_WRITE_REGISTERS:
+		break;
+	default:
+		break;
+	}
+	if (async->operation == ASYNC_IDLE)
+	{
+		return;
+	}
+	async->done++;
+	if (async->done >= async->count)
+	{
+		Async_Finish(async, STATUS_OK_ADXL);
+	}
+	else if (Async_Next(async))
+	{
+		Async_Finish(async, ERR_SPI);
+	}
+}
+
+/**
+ * @brief Function that must be called from HAL_SPI_ErrorCallback for the SPI interface of the context
+ *
+ * @param async Pointer to the context
+ */
+void Async_Transfer_Error(t_Async *async)
+{
+	HAL_GPIO_WritePin(GPIOB, CS_Pin, GPIO_PIN_SET);
+	if (async->operation != ASYNC_IDLE)
+	{
+		Async_Finish(async, async->operation == ASYNC_WRITE_REGISTERS ? ERR_WRITE : ERR_READING);
+	}
+}
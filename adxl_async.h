@@ -0,0 +1,118 @@
+#ifndef ADXL_ASYNC_H
+#define ADXL_ASYNC_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define ASYNC_FRAME_SIZE 			7 		// 1 address byte + 6 data bytes (DATAX0..DATAZ1)
+
+typedef void (*ASYNC_CALLBACK)(STATUS_ADXL status, void *arg);
+
+typedef enum ASYNC_OPERATION
+{
+	ASYNC_IDLE = 0,
+	ASYNC_READ_SAMPLES,
+	ASYNC_WRITE_REGISTERS,
+	ASYNC_READ_INT_SOURCE
+} ASYNC_OPERATION;
+
+typedef struct t_Async
+{
+	SPI_HandleTypeDef *spi;
+	volatile ASYNC_OPERATION operation;
+	uint8_t tx[ASYNC_FRAME_SIZE];
+	uint8_t rx[ASYNC_FRAME_SIZE];
+	t_Sample *samples;
+	const uint8_t *addresses;
+	const uint8_t *values;
+	t_IntSource *int_source;
+	uint16_t count;
+	uint16_t done;
+	ASYNC_CALLBACK callback;
+	void *arg;
+} t_Async;
+
+/******************************************************************************************************************************************************************************/
+/*																			Non-blocking Operations																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that binds an asynchronous context to an SPI interface. The context holds every buffer the transfers need, so no memory is allocated per operation
+ *
+ * @param async Pointer to the context
+ * @param spi SPI interface
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Async_Init(t_Async *async, SPI_HandleTypeDef *spi);
+
+/**
+ * @brief Function that reads samples from the data registers (one FIFO entry per transfer) without blocking
+ *
+ * @param async Pointer to the context
+ * @param samples Pointer to the destination array. It must stay valid until the callback is called
+ * @param count Number of samples to read
+ * @param callback Function called when the last transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Read_Samples(t_Async *async, t_Sample *samples, uint16_t count, ASYNC_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that writes a list of registers without blocking (one transfer per register)
+ *
+ * @param async Pointer to the context
+ * @param addresses Pointer to the register addresses. It must stay valid until the callback is called
+ * @param values Pointer to the values to write
+ * @param count Number of registers
+ * @param callback Function called when the last transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Write_Registers(t_Async *async, const uint8_t *addresses, const uint8_t *values, uint16_t count, ASYNC_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that reads and decodes the interrupt source register without blocking
+ *
+ * @param async Pointer to the context
+ * @param p_int_source Pointer to struct. It must stay valid until the callback is called
+ * @param callback Function called when the transfer is complete or on error
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_BUSY if another operation is in flight or a blocking transaction holds the bus
+ */
+STATUS_ADXL Async_Read_Interrupt_Source(t_Async *async, t_IntSource *p_int_source, ASYNC_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that returns true while an operation is in flight
+ *
+ * @param async Pointer to the context
+ * @return bool
+ */
+bool Async_Is_Busy(const t_Async *async);
+
+/**
+ * @brief Function that must be called from HAL_SPI_TxRxCpltCallback for the SPI interface of the context
+ *
+ * @param async Pointer to the context
+ */
+void Async_Transfer_Complete(t_Async *async);
+
+/**
+ * @brief Function that must be called from HAL_SPI_ErrorCallback for the SPI interface of the context
+ *
+ * @param async Pointer to the context
+ */
+void Async_Transfer_Error(t_Async *async);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_ASYNC_H */
@@ -0,0 +1,225 @@
+#ifndef ADXL_ASYNC_HPP
+#define ADXL_ASYNC_HPP
+
+#include <coroutine>
+#include "adxl_async.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			C++20 Awaitable Front-end																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Awaitable wrappers over t_Async. Each awaiter lives in the coroutine frame of the caller and carries its own
+ * arguments and result, so an operation never allocates. A device runs one operation at a time: a second co_await
+ * while one is in flight completes at once with ERR_BUSY and leaves the first one untouched.
+ *
+ * The completion callback and the EXTI handler run in interrupt context, therefore they only record what happened:
+ * the suspended coroutine is resumed later from the event loop by Device::poll().
+ *
+ *	adxl::Device dev(&hspi1);
+ *	STATUS_ADXL st = co_await dev.read_fifo(buf, 32);
+ *	...
+ *	HAL_GPIO_EXTI_Callback: dev.interrupt();
+ *	HAL_SPI_TxRxCpltCallback: dev.transfer_complete();
+ *	while (1) { dev.poll(); }
+ */
+namespace adxl
+{
+	class Device
+	{
+	public:
+		explicit Device(SPI_HandleTypeDef *spi) { Async_Init(&async_, spi); }
+
+		Device(const Device &) = delete;
+		Device &operator=(const Device &) = delete;
+
+		class Awaiter
+		{
+		public:
+			bool await_ready() const noexcept { return false; }
+
+			bool await_suspend(std::coroutine_handle<> handle) noexcept
+			{
+				if (dev_.current_ != nullptr || Async_Is_Busy(&dev_.async_))
+				{
+					// Another operation owns the device: fail this one without touching its state
+					status_ = ERR_BUSY;
+					return false;
+				}
+				handle_ = handle;
+				done_ = false;
+				dev_.current_ = this;
+				if (kind_ == EVENT && !dev_.take_edge())
+				{
+					return true; // poll() starts the INT_SOURCE read after the next interrupt
+				}
+				started_ = true;
+				status_ = start();
+				if (status_ != STATUS_OK_ADXL || done_)
+				{
+					// Failed to start or completed synchronously: do not suspend
+					dev_.current_ = nullptr;
+					return false;
+				}
+				return true;
+			}
+
+			STATUS_ADXL await_resume() const noexcept { return status_; }
+
+		private:
+			friend class Device;
+
+			enum Kind
+			{
+				READ,
+				WRITE,
+				EVENT
+			};
+
+			Awaiter(Device &dev, Kind kind) : dev_(dev), kind_(kind) {}
+
+			STATUS_ADXL start() noexcept
+			{
+				switch (kind_)
+				{
+				case READ:
+					return Async_Read_Samples(&dev_.async_, samples_, count_, &Awaiter::on_complete, this);
+				case WRITE:
+					return Async_Write_Registers(&dev_.async_, addresses_, values_, count_, &Awaiter::on_complete, this);
+				default:
+					return Async_Read_Interrupt_Source(&dev_.async_, int_source_, &Awaiter::on_complete, this);
+				}
+			}
+
+			static void on_complete(STATUS_ADXL status, void *arg)
+			{
+				Awaiter *awaiter = static_cast<Awaiter *>(arg);
+				awaiter->status_ = status;
+				awaiter->done_ = true;
+			}
+
+			Device &dev_;
+			Kind kind_;
+			t_Sample *samples_ = nullptr;
+			const uint8_t *addresses_ = nullptr;
+			const uint8_t *values_ = nullptr;
+			t_IntSource *int_source_ = nullptr;
+			uint16_t count_ = 0;
+			bool started_ = false;
+			std::coroutine_handle<> handle_ = nullptr;
+			volatile bool done_ = false;
+			volatile STATUS_ADXL status_ = STATUS_OK_ADXL;
+		};
+
+		/**
+		 * @brief Awaitable read of count samples (one FIFO entry per transfer)
+		 */
+		Awaiter read_fifo(t_Sample *samples, uint16_t count)
+		{
+			Awaiter awaiter(*this, Awaiter::READ);
+			awaiter.samples_ = samples;
+			awaiter.count_ = count;
+			return awaiter;
+		}
+
+		/**
+		 * @brief Awaitable write of a register list
+		 */
+		Awaiter configure(const uint8_t *addresses, const uint8_t *values, uint16_t count)
+		{
+			Awaiter awaiter(*this, Awaiter::WRITE);
+			awaiter.addresses_ = addresses;
+			awaiter.values_ = values;
+			awaiter.count_ = count;
+			return awaiter;
+		}
+
+		/**
+		 * @brief Awaitable next sensor interrupt: waits for the EXTI edge (interrupt()), then reads and decodes INT_SOURCE.
+		 * An edge that arrived while nobody was waiting completes the next call straight away
+		 */
+		Awaiter next_event(t_IntSource *p_int_source)
+		{
+			Awaiter awaiter(*this, Awaiter::EVENT);
+			awaiter.int_source_ = p_int_source;
+			return awaiter;
+		}
+
+		/**
+		 * @brief Must be called from HAL_GPIO_EXTI_Callback for the sensor interrupt pin
+		 */
+		void interrupt() { __atomic_fetch_add(&edges_, 1, __ATOMIC_RELEASE); }
+
+		/**
+		 * @brief Must be called from HAL_SPI_TxRxCpltCallback
+		 */
+		void transfer_complete() { Async_Transfer_Complete(&async_); }
+
+		/**
+		 * @brief Must be called from HAL_SPI_ErrorCallback
+		 */
+		void transfer_error() { Async_Transfer_Error(&async_); }
+
+		/**
+		 * @brief Starts a next_event() read once its interrupt arrived and resumes the waiting coroutine once its operation
+		 * has completed. Call it from the main loop
+		 *
+		 * @return true if a coroutine was resumed
+		 */
+		bool poll()
+		{
+			Awaiter *op = current_;
+			STATUS_ADXL status = STATUS_OK_ADXL;
+			if (op == nullptr)
+			{
+				return false;
+			}
+			if (!op->started_)
+			{
+				if (!take_edge())
+				{
+					return false;
+				}
+				op->started_ = true;
+				status = op->start();
+				if (status != STATUS_OK_ADXL)
+				{
+					op->status_ = status;
+					op->done_ = true;
+				}
+			}
+			if (!op->done_)
+			{
+				return false;
+			}
+			current_ = nullptr;
+			op->handle_.resume();
+			return true;
+		}
+
+		/**
+		 * @brief Returns true while an operation is waiting for its interrupt or its transfers
+		 */
+		bool busy() const { return current_ != nullptr; }
+
+	private:
+		bool take_edge()
+		{
+			uint32_t edges = __atomic_load_n(&edges_, __ATOMIC_ACQUIRE);
+			while (edges != 0)
+			{
+				if (__atomic_compare_exchange_n(&edges_, &edges, edges - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		t_Async async_;
+		Awaiter *current_ = nullptr;
+		uint32_t edges_ = 0; 			// interrupts not consumed by next_event() yet
+	};
+}
+
+#endif /* ADXL_ASYNC_HPP */
@@ -0,0 +1,392 @@
+#include "adxl_autotune.h"
+#include "adxl_tilt.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that clears the window statistics
+ *
+ * @param tune Pointer to the tuning
+ */
+static void Autotune_Reset_Window(t_Autotune *tune)
+{
+	uint8_t i = 0;
+	for (i = 0; i < 3; i++)
+	{
+		tune->axis[i].sum = 0;
+		tune->axis[i].squares = 0;
+		tune->axis[i].min = INT16_MAX;
+		tune->axis[i].max = INT16_MIN;
+	}
+	tune->count = 0;
+}
+
+/**
+ * @brief Function that converts a threshold in ug to register units (15.625 mg/LSB), rounded up so the threshold is never below the target
+ *
+ * @param value Threshold in ug
+ * @return uint8_t 1-255
+ */
+static uint8_t Autotune_Units(int32_t value)
+{
+	int32_t units = (value + AUTOTUNE_THRESHOLD_UG - 1) / AUTOTUNE_THRESHOLD_UG;
+	if (units < 1)
+	{
+		units = 1;
+	}
+	else if (units > 255)
+	{
+		units = 255;
+	}
+	return (uint8_t)units;
+}
+
+/**
+ * @brief Function that limits a threshold to what the registers can hold
+ *
+ * @param value Threshold in ug
+ * @return int32_t 0 - AUTOTUNE_THRESHOLD_MAX
+ */
+static int32_t Autotune_Clamp(int64_t value)
+{
+	if (value > AUTOTUNE_THRESHOLD_MAX)
+	{
+		value = AUTOTUNE_THRESHOLD_MAX;
+	}
+	else if (value < 0)
+	{
+		value = 0;
+	}
+	return (int32_t)value;
+}
+
+/**
+ * @brief Function that picks the coupling from the gravity projection of a quiet window. DC compares the absolute acceleration, which only holds
+ * while the orientation does: it is chosen once the projection has stayed within the inactivity band (at least one threshold step) of where the
+ * run started for AUTOTUNE_STABLE_WINDOWS windows and the raised thresholds still fit the registers. Any move restarts the run in AC
+ *
+ * @param tune Pointer to the tuning
+ * @param projection Mean acceleration per axis in ug
+ * @param gravity Largest gravity component on the enabled axes in ug
+ * @param base Vibration baseline in ug
+ * @return uint8_t AC_SET or DC_SET
+ */
+static uint8_t Autotune_Coupling(t_Autotune *tune, const int32_t projection[3], int32_t gravity, int32_t base)
+{
+	const uint8_t mask[3] = {AUTOTUNE_AXIS_X, AUTOTUNE_AXIS_Y, AUTOTUNE_AXIS_Z};
+	int64_t limit = ((int64_t)base * tune->config.inactivity_margin) / 16;
+	int64_t delta = 0;
+	bool moved = !tune->tuned;
+	uint8_t i = 0;
+	if (limit < AUTOTUNE_THRESHOLD_UG)
+	{
+		limit = AUTOTUNE_THRESHOLD_UG;
+	}
+	for (i = 0; i < 3; i++)
+	{
+		delta = (int64_t)projection[i] - tune->projection[i];
+		moved |= (tune->config.axes & mask[i]) && (delta > limit || -delta > limit);
+	}
+	if (moved)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			tune->projection[i] = projection[i];
+		}
+		tune->stable = 1;
+	}
+	else if (tune->stable < AUTOTUNE_STABLE_WINDOWS)
+	{
+		tune->stable++;
+	}
+	return (tune->stable >= AUTOTUNE_STABLE_WINDOWS && (int64_t)gravity + ((int64_t)base * tune->config.activity_margin) / 16 < AUTOTUNE_THRESHOLD_MAX)
+			   ? DC_SET
+			   : AC_SET;
+}
+
+/**
+ * @brief Function that closes a window: statistics per axis, coupling, then first tuning or slow adaptation
+ *
+ * @param tune Pointer to the tuning
+ */
+static void Autotune_Window(t_Autotune *tune)
+{
+	const uint8_t mask[3] = {AUTOTUNE_AXIS_X, AUTOTUNE_AXIS_Y, AUTOTUNE_AXIS_Z};
+	t_AutotuneAxis *axis = NULL;
+	int64_t n = tune->count;
+	int64_t variance = 0;
+	int32_t mean = 0;
+	int32_t peak = 0;
+	int32_t base = 0;
+	int32_t gravity = 0;
+	uint32_t noise = 0;
+	int32_t offset = 0;
+	int32_t activity = 0;
+	int32_t inactivity = 0;
+	int32_t g = 0;
+	int32_t projection[3];
+	uint8_t coupling = tune->config.coupling;
+	bool transient = false;
+	uint8_t i = 0;
+
+	for (i = 0; i < 3; i++)
+	{
+		axis = &tune->axis[i];
+		mean = (int32_t)((axis->sum >= 0 ? axis->sum + n / 2 : axis->sum - n / 2) / n);
+		variance = (n * axis->squares - (int64_t)axis->sum * axis->sum) / (n * n);
+		peak = (axis->max - mean) > (mean - axis->min) ? (axis->max - mean) : (mean - axis->min);
+		tune->noise[i] = (uint32_t)(((uint64_t)Tilt_Isqrt(variance > UINT32_MAX ? UINT32_MAX : (uint32_t)variance) * 1000000) / tune->lsb_per_g);
+		tune->baseline[i] = (uint32_t)(((uint64_t)peak * 1000000) / tune->lsb_per_g);
+		projection[i] = (int32_t)(((int64_t)mean * 1000000) / tune->lsb_per_g);
+		g = projection[i] < 0 ? -projection[i] : projection[i];
+		if (tune->config.axes & mask[i])
+		{
+			base = (int32_t)tune->baseline[i] > base ? (int32_t)tune->baseline[i] : base;
+			gravity = g > gravity ? g : gravity;
+			noise = tune->noise[i] > noise ? tune->noise[i] : noise;
+			transient |= (uint64_t)tune->baseline[i] > (uint64_t)tune->noise[i] * AUTOTUNE_CREST_FACTOR;
+		}
+	}
+	Autotune_Reset_Window(tune);
+
+	// A peak far above the spread of the window is an event, not noise or steady vibration. The first window must also be at rest:
+	// a sensor carried or vibrating while it is tuned would set thresholds it can never fall below
+	if (transient || (!tune->tuned && noise > tune->config.noise_floor))
+	{
+		tune->skipped++;
+		return;
+	}
+	tune->windows++;
+
+	if (coupling == AUTOTUNE_COUPLING_AUTO)
+	{
+		coupling = Autotune_Coupling(tune, projection, gravity, base);
+	}
+
+	// DC coupling compares the absolute acceleration of each enabled axis, so the largest gravity component sits under both thresholds
+	offset = (coupling == DC_SET) ? gravity : 0;
+	activity = Autotune_Clamp((int64_t)offset + ((int64_t)base * tune->config.activity_margin) / 16);
+	inactivity = Autotune_Clamp((int64_t)offset + ((int64_t)base * tune->config.inactivity_margin) / 16);
+
+	// A coupling change moves the thresholds by the gravity offset: take the new ones at once rather than filtering towards them
+	if (!tune->tuned || coupling != tune->coupling)
+	{
+		tune->coupling = coupling;
+		tune->activity = activity;
+		tune->inactivity = inactivity;
+		tune->tuned = true;
+	}
+	else
+	{
+		tune->activity += (activity - tune->activity) / (1 << tune->config.adapt_shift);
+		tune->inactivity += (inactivity - tune->inactivity) / (1 << tune->config.adapt_shift);
+	}
+
+	tune->thresh_act = Autotune_Units(tune->activity);
+	tune->thresh_inact = Autotune_Units(tune->inactivity);
+	if (tune->thresh_act <= tune->thresh_inact)
+	{
+		// Keep at least one step of hysteresis between the two thresholds
+		tune->thresh_inact = (tune->thresh_act > 1) ? tune->thresh_act - 1 : 1;
+		tune->thresh_act = tune->thresh_inact + 1;
+	}
+	tune->changed = !tune->applied || tune->thresh_act != tune->applied_act || tune->thresh_inact != tune->applied_inact ||
+					tune->coupling != tune->applied_coupling;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Threshold Tuning 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the threshold tuning
+ *
+ * @param tune Pointer to the tuning
+ * @param config Pointer to the configuration (window >= 2, noise_floor > 0, coupling AUTOTUNE_COUPLING_AUTO, AC_SET or DC_SET)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Autotune_Init(t_Autotune *tune, const t_AutotuneConfig *config, uint8_t data_format)
+{
+	uint8_t i = 0;
+	if (config->window < 2 || config->axes == 0 || config->adapt_shift > 15 || (config->coupling != AUTOTUNE_COUPLING_AUTO && config->coupling != AC_SET && config->coupling != DC_SET) || config->noise_floor == 0)
+	{
+		return ERR_PARAM;
+	}
+	tune->config = *config;
+	tune->coupling = (config->coupling == AUTOTUNE_COUPLING_AUTO) ? AC_SET : config->coupling;
+	for (i = 0; i < 3; i++)
+	{
+		tune->projection[i] = 0;
+	}
+	tune->stable = 0;
+	tune->activity = 0;
+	tune->inactivity = 0;
+	tune->thresh_act = 0;
+	tune->thresh_inact = 0;
+	tune->applied_act = 0;
+	tune->applied_inact = 0;
+	tune->applied_coupling = tune->coupling;
+	tune->tuned = false;
+	tune->applied = false;
+	tune->changed = false;
+	tune->windows = 0;
+	tune->skipped = 0;
+	Autotune_Set_Format(tune, data_format);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that updates the output scale after a range or resolution change. The window in progress is discarded
+ *
+ * @param tune Pointer to the tuning
+ * @param data_format DATA_FORMAT register value
+ */
+void Autotune_Set_Format(t_Autotune *tune, uint8_t data_format)
+{
+	tune->lsb_per_g = Format_Lsb_Per_G(data_format);
+	Autotune_Reset_Window(tune);
+}
+
+/**
+ * @brief Function that measures noise floor and vibration baseline per axis over windows of samples. The first window at or below the configured
+ * noise floor sets the thresholds, later windows without activity move the thresholds slowly towards their new target. With automatic coupling
+ * the tuning starts in AC, switches to DC once the gravity projection has held still for AUTOTUNE_STABLE_WINDOWS windows and back to AC when it moves
+ *
+ * @param tune Pointer to the tuning
+ * @param block Sample block (see adxl_stream.h)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Autotune_Process_Block(t_Autotune *tune, const t_SampleBlock *block)
+{
+	const t_Sample *s = NULL;
+	int16_t value[3];
+	uint16_t i = 0;
+	uint8_t a = 0;
+	for (i = 0; i < block->count; i++)
+	{
+		s = &block->samples[i];
+		value[0] = s->x;
+		value[1] = s->y;
+		value[2] = s->z;
+		for (a = 0; a < 3; a++)
+		{
+			tune->axis[a].sum += value[a];
+			tune->axis[a].squares += (int32_t)value[a] * value[a];
+			tune->axis[a].min = value[a] < tune->axis[a].min ? value[a] : tune->axis[a].min;
+			tune->axis[a].max = value[a] > tune->axis[a].max ? value[a] : tune->axis[a].max;
+		}
+		if (++tune->count == tune->config.window)
+		{
+			Autotune_Window(tune);
+		}
+	}
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that collects windows from the FIFO (stream mode must be configured) until one is used to tune the thresholds. Between drains
+ * it sleeps in wait, or without one in HAL_Delay for the time the FIFO takes to fill halfway
+ *
+ * @param spi SPI interface
+ * @param tune Pointer to the tuning
+ * @param timeout Time limit in ms
+ * @param wait Function that waits for the watermark interrupt, NULL to delay instead
+ * @param arg User argument for wait
+ * @return STATUS_ADXL ERR_BUSY if no usable window was collected in time
+ */
+STATUS_ADXL Autotune_Measure(SPI_HandleTypeDef *spi, t_Autotune *tune, uint32_t timeout, AUTOTUNE_WAIT wait, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_Sample samples[FIFO_SIZE];
+	t_SampleBlock block = {0};
+	uint32_t start = HAL_GetTick();
+	uint32_t windows = tune->windows;
+	uint32_t elapsed = 0;
+	uint32_t delay = 1;
+	bool triggered = false;
+	uint8_t entries = 0;
+	uint8_t rate = 0;
+	block.samples = samples;
+	if (wait == NULL && Get_Bandwidth_Rate(spi, &rate) == STATUS_OK_ADXL)
+	{
+		delay = (uint32_t)(((uint64_t)Sample_Period_Ns(rate) * (FIFO_SIZE / 2)) / 1000000);
+		delay = delay > 0 ? delay : 1;
+	}
+	while (ret_val == STATUS_OK_ADXL && tune->windows == windows)
+	{
+		elapsed = HAL_GetTick() - start;
+		if (elapsed > timeout)
+		{
+			ret_val = ERR_BUSY;
+		}
+		else if (Get_FIFO_Status(spi, &triggered, &entries))
+		{
+			ret_val = ERR_READING;
+		}
+		else if (entries > 0 && Read_FIFO(spi, samples, entries))
+		{
+			ret_val = ERR_READING;
+		}
+		else
+		{
+			block.count = entries;
+			Autotune_Process_Block(tune, &block);
+			// Nothing more to read until the FIFO fills again: sleep rather than poll FIFO_STATUS
+			if (tune->windows == windows && wait)
+			{
+				wait(timeout - elapsed + 1, arg);
+			}
+			else if (tune->windows == windows)
+			{
+				HAL_Delay(delay < timeout - elapsed + 1 ? delay : timeout - elapsed + 1);
+			}
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that writes the thresholds, TIME_INACT and the coupling. After the first call only changed thresholds and coupling are written
+ *
+ * @param spi SPI interface
+ * @param tune Pointer to the tuning
+ * @return STATUS_ADXL ERR_PARAM if no window has been measured yet
+ */
+STATUS_ADXL Autotune_Apply(SPI_HandleTypeDef *spi, t_Autotune *tune)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	const uint8_t axes = tune->config.axes;
+	if (!tune->tuned)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else if (!tune->applied && Set_Time_Inactivity(spi, tune->config.time_inactivity))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else if ((!tune->applied || tune->coupling != tune->applied_coupling) &&
+			 Set_Activity_Inactivity_Control(spi, tune->coupling, tune->coupling, axes & AUTOTUNE_AXIS_X, axes & AUTOTUNE_AXIS_Y, axes & AUTOTUNE_AXIS_Z))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else if ((!tune->applied || tune->thresh_act != tune->applied_act) && Set_Threshold_Activity(spi, tune->thresh_act))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else if ((!tune->applied || tune->thresh_inact != tune->applied_inact) && Set_Threshold_Inactivity(spi, tune->thresh_inact))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else
+	{
+		tune->applied_act = tune->thresh_act;
+		tune->applied_inact = tune->thresh_inact;
+		tune->applied_coupling = tune->coupling;
+		tune->applied = true;
+		tune->changed = false;
+	}
+	return ret_val;
+}
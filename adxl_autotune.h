@@ -0,0 +1,134 @@
+#ifndef ADXL_AUTOTUNE_H
+#define ADXL_AUTOTUNE_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define AUTOTUNE_THRESHOLD_UG 		15625 	// THRESH_ACT/THRESH_INACT scale factor in ug/LSB
+#define AUTOTUNE_THRESHOLD_MAX 		(255 * AUTOTUNE_THRESHOLD_UG) // largest threshold the registers hold, in ug
+#define AUTOTUNE_CREST_FACTOR 		6 		// peak over standard deviation above which a window holds an event
+#define AUTOTUNE_AXIS_X 			0x04
+#define AUTOTUNE_AXIS_Y 			0x02
+#define AUTOTUNE_AXIS_Z 			0x01
+#define AUTOTUNE_COUPLING_AUTO 		0x02 	// choose AC or DC from the measured data (AC_SET and DC_SET override it)
+#define AUTOTUNE_STABLE_WINDOWS 	4 		// quiet windows with the same gravity projection before the automatic choice is DC
+
+/**
+ * @brief Function used by Autotune_Measure to sleep until the FIFO watermark interrupt or for timeout ms, whichever comes first
+ */
+typedef void (*AUTOTUNE_WAIT)(uint32_t timeout, void *arg);
+
+typedef struct t_AutotuneConfig
+{
+	uint16_t window; 				// samples per measurement window
+	uint8_t axes; 					// AUTOTUNE_AXIS_* used by the activity and inactivity functions
+	uint8_t coupling; 				// AUTOTUNE_COUPLING_AUTO, or AC_SET / DC_SET to force one (DC thresholds are raised by the gravity on the enabled axes)
+	uint32_t noise_floor; 			// noise of the sensor at rest in ug rms: a first window above it holds motion and is rejected
+	uint8_t activity_margin; 		// activity threshold over the vibration baseline, Q4 (32 = 2.0x)
+	uint8_t inactivity_margin; 		// inactivity threshold over the vibration baseline, Q4 (20 = 1.25x)
+	uint8_t time_inactivity; 		// TIME_INACT in s, written as is
+	uint8_t adapt_shift; 			// weight of a new quiet window during operation (1 / 2^adapt_shift)
+} t_AutotuneConfig;
+
+typedef struct t_AutotuneAxis
+{
+	int32_t sum;
+	int64_t squares;
+	int16_t min;
+	int16_t max;
+} t_AutotuneAxis;
+
+typedef struct t_Autotune
+{
+	t_AutotuneConfig config;
+	uint32_t lsb_per_g; 			// output scale from DATA_FORMAT
+	t_AutotuneAxis axis[3];
+	uint16_t count; 				// samples in the current window
+	uint32_t noise[3]; 				// standard deviation of the last window in ug
+	uint32_t baseline[3]; 			// largest deviation from the mean of the last window in ug
+	uint8_t coupling; 				// AC_SET or DC_SET in use
+	int32_t projection[3]; 			// gravity projection in ug the stable run is measured against
+	uint8_t stable; 				// consecutive quiet windows within the inactivity band of projection
+	int32_t activity; 				// filtered activity threshold in ug
+	int32_t inactivity; 			// filtered inactivity threshold in ug
+	uint8_t thresh_act; 			// register values
+	uint8_t thresh_inact;
+	uint8_t applied_act; 			// register values last written by Autotune_Apply
+	uint8_t applied_inact;
+	uint8_t applied_coupling;
+	bool tuned; 					// first quiet window done
+	bool applied; 					// registers written at least once
+	bool changed; 					// register values or coupling differ from the applied ones
+	uint32_t windows; 				// windows used for tuning
+	uint32_t skipped; 				// windows ignored because they contained an event, or a first window above the noise floor
+} t_Autotune;
+
+/******************************************************************************************************************************************************************************/
+/*																				Threshold Tuning 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the threshold tuning
+ *
+ * @param tune Pointer to the tuning
+ * @param config Pointer to the configuration (window >= 2, noise_floor > 0)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Autotune_Init(t_Autotune *tune, const t_AutotuneConfig *config, uint8_t data_format);
+
+/**
+ * @brief Function that updates the output scale after a range or resolution change. The window in progress is discarded
+ *
+ * @param tune Pointer to the tuning
+ * @param data_format DATA_FORMAT register value
+ */
+void Autotune_Set_Format(t_Autotune *tune, uint8_t data_format);
+
+/**
+ * @brief Function that measures noise floor and vibration baseline per axis over windows of samples. The first window at or below the configured
+ * noise floor sets the thresholds, later windows without activity move the thresholds slowly towards their new target. With automatic coupling
+ * the tuning starts in AC, switches to DC once the gravity projection has held still for AUTOTUNE_STABLE_WINDOWS windows and back to AC when it moves
+ *
+ * @param tune Pointer to the tuning
+ * @param block Sample block (see adxl_stream.h)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Autotune_Process_Block(t_Autotune *tune, const t_SampleBlock *block);
+
+/**
+ * @brief Function that collects windows from the FIFO (stream mode must be configured) until one is used to tune the thresholds. Between drains
+ * it sleeps in wait, or without one in HAL_Delay for the time the FIFO takes to fill halfway
+ *
+ * @param spi SPI interface
+ * @param tune Pointer to the tuning
+ * @param timeout Time limit in ms
+ * @param wait Function that waits for the watermark interrupt, NULL to delay instead
+ * @param arg User argument for wait
+ * @return STATUS_ADXL ERR_BUSY if no usable window was collected in time
+ */
+STATUS_ADXL Autotune_Measure(SPI_HandleTypeDef *spi, t_Autotune *tune, uint32_t timeout, AUTOTUNE_WAIT wait, void *arg);
+
+/**
+ * @brief Function that writes the thresholds, TIME_INACT and the coupling. After the first call only changed thresholds and coupling are written
+ *
+ * @param spi SPI interface
+ * @param tune Pointer to the tuning
+ * @return STATUS_ADXL ERR_PARAM if no window has been measured yet
+ */
+STATUS_ADXL Autotune_Apply(SPI_HandleTypeDef *spi, t_Autotune *tune);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_AUTOTUNE_H */
@@ -0,0 +1,164 @@
+#include "adxl_capture.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Event Capture 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that configures an event capture. The trigger is the interrupt mapped (Set_Interrupt_Pins) to the selected pin, usually activity
+ *
+ * @param capture Pointer to the capture
+ * @param spi SPI interface
+ * @param rate Rate code of BW_RATE, used to date the trigger sample
+ * @param pre_trigger Samples kept before the trigger event (0-31, limited by the FIFO)
+ * @param post_trigger Samples collected from the trigger event on
+ * @param trigger_pin 0: INT1 / 1: INT2
+ * @param callback Function called with the complete capture. The buffer is reused once it returns
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the window does not fit
+ */
+STATUS_ADXL Capture_Init(t_Capture *capture, SPI_HandleTypeDef *spi, uint8_t rate, uint8_t pre_trigger, uint16_t post_trigger, bool trigger_pin, CAPTURE_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (pre_trigger >= FIFO_SIZE || (uint32_t)pre_trigger + post_trigger > CAPTURE_MAX_SAMPLES || (uint32_t)pre_trigger + post_trigger == 0)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		capture->spi = spi;
+		capture->count = 0;
+		capture->length = pre_trigger + post_trigger;
+		capture->pre_trigger = pre_trigger;
+		capture->trigger_pin = trigger_pin;
+		capture->state = CAPTURE_IDLE;
+		capture->period = Sample_Period_Ns(rate);
+		capture->sequence = 0;
+		capture->arm_errors = 0;
+		capture->trigger_time = 0;
+		capture->ready_time = 0;
+		capture->max_latency = 0;
+		capture->callback = callback;
+		capture->arg = arg;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that resets the FIFO and arms trigger mode. If a write fails the capture goes to CAPTURE_REARM and the next Capture_Process
+ * tries again
+ *
+ * @param capture Pointer to the capture
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Capture_Arm(t_Capture *capture)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	capture->count = 0;
+	if (Set_FIFO_Control(capture->spi, FIFO_BYPASS, capture->trigger_pin, 0)) // clears the FIFO and the trigger
+	{
+		ret_val = ERR_WRITE;
+	}
+	else if (Set_FIFO_Control(capture->spi, FIFO_TRIGGER, capture->trigger_pin, capture->pre_trigger))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else
+	{
+		capture->state = CAPTURE_ARMED;
+	}
+	if (ret_val != STATUS_OK_ADXL)
+	{
+		capture->state = CAPTURE_REARM;
+		capture->arm_errors++;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that advances the capture. Call it on every trigger/watermark interrupt or periodically while collecting
+ *
+ * @param capture Pointer to the capture
+ * @param timestamp Current time in us (interrupt entry time when called from the interrupt). The trigger time is this time less the
+ * samples that followed the trigger sample in the FIFO, so it is late by at most one sample period plus the read time
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Capture_Process(t_Capture *capture, uint64_t timestamp)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	bool triggered = false;
+	uint8_t entries = 0;
+	uint16_t pending = 0;
+	uint32_t latency = 0;
+
+	if (capture->state == CAPTURE_IDLE)
+	{
+		ret_val = STATUS_OK_ADXL;
+	}
+	else if (capture->state == CAPTURE_REARM)
+	{
+		ret_val = Capture_Arm(capture);
+	}
+	else if (Get_FIFO_Status(capture->spi, &triggered, &entries))
+	{
+		ret_val = ERR_READING;
+	}
+	else if (capture->state == CAPTURE_ARMED && !triggered)
+	{
+		ret_val = STATUS_OK_ADXL;
+	}
+	else
+	{
+		if (capture->state == CAPTURE_ARMED)
+		{
+			// The newest entry was converted at most one period ago; the trigger sample sits pre_trigger entries from the oldest
+			capture->trigger_time = timestamp;
+			if (entries > capture->pre_trigger)
+			{
+				capture->trigger_time -= ((uint64_t)(entries - 1 - capture->pre_trigger) * capture->period) / 1000;
+			}
+			capture->state = CAPTURE_COLLECTING;
+		}
+		// After the trigger the FIFO keeps the pre-trigger history and fills up with new samples; draining it makes room
+		pending = capture->length - capture->count;
+		if (entries > pending)
+		{
+			entries = (uint8_t)pending;
+		}
+		if (Read_FIFO(capture->spi, &capture->samples[capture->count], entries))
+		{
+			ret_val = ERR_READING;
+		}
+		else
+		{
+			capture->count += entries;
+			if (capture->count >= capture->length)
+			{
+				capture->ready_time = timestamp;
+				latency = (uint32_t)(timestamp - capture->trigger_time);
+				if (latency > capture->max_latency)
+				{
+					capture->max_latency = latency;
+				}
+				capture->sequence++;
+				if (capture->callback)
+				{
+					capture->callback(capture, capture->arg);
+				}
+				ret_val = Capture_Arm(capture);
+			}
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that returns the index of the first sample after the trigger in the capture buffer (valid when the capture was armed for at least pre_trigger samples)
+ *
+ * @param capture Pointer to the capture
+ * @return uint16_t
+ */
+uint16_t Capture_Trigger_Index(const t_Capture *capture)
+{
+	return capture->pre_trigger;
+}
@@ -0,0 +1,100 @@
+#ifndef ADXL_CAPTURE_H
+#define ADXL_CAPTURE_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef CAPTURE_MAX_SAMPLES
+#define CAPTURE_MAX_SAMPLES 		256 	// pre-trigger + post-trigger samples of one capture
+#endif
+
+typedef enum CAPTURE_STATE
+{
+	CAPTURE_IDLE = 0,
+	CAPTURE_ARMED,
+	CAPTURE_COLLECTING,
+	CAPTURE_REARM 					// arming failed, the next Capture_Process retries it
+} CAPTURE_STATE;
+
+struct t_Capture;
+
+typedef void (*CAPTURE_CALLBACK)(const struct t_Capture *capture, void *arg);
+
+typedef struct t_Capture
+{
+	SPI_HandleTypeDef *spi;
+	t_Sample samples[CAPTURE_MAX_SAMPLES];
+	uint16_t count; 			// samples stored in the buffer
+	uint16_t length; 			// pre_trigger + post_trigger
+	uint8_t pre_trigger;
+	bool trigger_pin;
+	CAPTURE_STATE state;
+	uint32_t period; 			// sample period in ns
+	uint32_t sequence; 			// number of completed captures
+	uint32_t arm_errors; 		// failed attempts to arm
+	uint64_t trigger_time; 		// conversion time of the first sample after the trigger in us, derived from the FIFO depth
+	uint64_t ready_time; 		// time the capture was complete in us
+	uint32_t max_latency; 		// worst ready_time - trigger_time in us
+	CAPTURE_CALLBACK callback;
+	void *arg;
+} t_Capture;
+
+/******************************************************************************************************************************************************************************/
+/*																				Event Capture 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that configures an event capture. The trigger is the interrupt mapped (Set_Interrupt_Pins) to the selected pin, usually activity
+ *
+ * @param capture Pointer to the capture
+ * @param spi SPI interface
+ * @param rate Rate code of BW_RATE, used to date the trigger sample
+ * @param pre_trigger Samples kept before the trigger event (0-31, limited by the FIFO)
+ * @param post_trigger Samples collected from the trigger event on
+ * @param trigger_pin 0: INT1 / 1: INT2
+ * @param callback Function called with the complete capture. The buffer is reused once it returns
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the window does not fit
+ */
+STATUS_ADXL Capture_Init(t_Capture *capture, SPI_HandleTypeDef *spi, uint8_t rate, uint8_t pre_trigger, uint16_t post_trigger, bool trigger_pin, CAPTURE_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that resets the FIFO and arms trigger mode. If a write fails the capture goes to CAPTURE_REARM and the next Capture_Process
+ * tries again
+ *
+ * @param capture Pointer to the capture
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Capture_Arm(t_Capture *capture);
+
+/**
+ * @brief Function that advances the capture. Call it on every trigger/watermark interrupt or periodically while collecting
+ *
+ * @param capture Pointer to the capture
+ * @param timestamp Current time in us (interrupt entry time when called from the interrupt). The trigger time is this time less the
+ * samples that followed the trigger sample in the FIFO, so it is late by at most one sample period plus the read time
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Capture_Process(t_Capture *capture, uint64_t timestamp);
+
+/**
+ * @brief Function that returns the index of the first sample after the trigger in the capture buffer (valid when the capture was armed for at least pre_trigger samples)
+ *
+ * @param capture Pointer to the capture
+ * @return uint16_t
+ */
+uint16_t Capture_Trigger_Index(const t_Capture *capture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_CAPTURE_H */
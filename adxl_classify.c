@@ -0,0 +1,186 @@
+#include "adxl_classify.h"
+#include "adxl_tilt.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+static int16_t Saturate(int64_t value)
+{
+	if (value > INT16_MAX)
+	{
+		value = INT16_MAX;
+	}
+	else if (value < INT16_MIN)
+	{
+		value = INT16_MIN;
+	}
+	return (int16_t)value;
+}
+
+static int16_t Root(int64_t value)
+{
+	if (value <= 0)
+	{
+		return 0;
+	}
+	if (value > UINT32_MAX)
+	{
+		value = UINT32_MAX;
+	}
+	return Saturate(Tilt_Isqrt((uint32_t)value));
+}
+
+/**
+ * @brief Function that turns the accumulators into features, classifies and starts a new window
+ *
+ * @param classifier Pointer to the classifier
+ */
+static void Classify_Window(t_Classifier *classifier)
+{
+	const int64_t n = classifier->count;
+	int64_t variance = 0;
+	int64_t total = 0;
+	int64_t high = 0;
+	uint8_t axis = 0;
+	uint8_t motion_class = 0;
+
+	for (axis = 0; axis < 3; axis++)
+	{
+		classifier->features[FEATURE_MEAN_X + axis] = Saturate(classifier->sum[axis] / n);
+		variance = (classifier->sum2[axis] - classifier->sum[axis] * classifier->sum[axis] / n) / n;
+		classifier->features[FEATURE_RMS_X + axis] = Root(variance);
+		total += variance;
+	}
+	// For white noise E[d^2] = 2 var; a sine keeps (1 - cos w) of its variance in d^2 / 2 (see adxl_classify.h)
+	high = classifier->diff2 / (2 * (n - 1));
+	classifier->features[FEATURE_HIGH_BAND] = Root(high);
+	classifier->features[FEATURE_LOW_BAND] = Root(total - high);
+
+	motion_class = Classify_Evaluate(classifier->tree, classifier->nodes, classifier->features);
+	if (classifier->callback)
+	{
+		classifier->callback(motion_class, classifier->features, classifier->arg);
+	}
+	for (axis = 0; axis < 3; axis++)
+	{
+		classifier->sum[axis] = 0;
+		classifier->sum2[axis] = 0;
+	}
+	classifier->diff2 = 0;
+	classifier->count = 0;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																			Motion Classification 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a classifier
+ *
+ * @param classifier Pointer to the classifier
+ * @param tree Pointer to the tree table (const, stays in flash)
+ * @param nodes Number of nodes of the tree
+ * @param window Samples per classification window (at least 2)
+ * @param callback Function called with the class and features of every window
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the tree or the window is not valid
+ */
+STATUS_ADXL Classify_Init(t_Classifier *classifier, const t_TreeNode *tree, uint8_t nodes, uint16_t window, CLASSIFY_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t i = 0;
+	if (tree == NULL || nodes == 0 || window < 2)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		classifier->tree = tree;
+		classifier->nodes = nodes;
+		classifier->window = window;
+		classifier->count = 0;
+		for (i = 0; i < 3; i++)
+		{
+			classifier->sum[i] = 0;
+			classifier->sum2[i] = 0;
+		}
+		classifier->diff2 = 0;
+		for (i = 0; i < FEATURE_COUNT; i++)
+		{
+			classifier->features[i] = 0;
+		}
+		classifier->callback = callback;
+		classifier->arg = arg;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that accumulates the features of a block (single pass, no sample buffer) and classifies every complete window
+ *
+ * @param classifier Pointer to the classifier
+ * @param block Sample block (see adxl_stream.h)
+ */
+void Classify_Process_Block(t_Classifier *classifier, const t_SampleBlock *block)
+{
+	const t_Sample *s = NULL;
+	int32_t dx = 0;
+	int32_t dy = 0;
+	int32_t dz = 0;
+	uint16_t i = 0;
+
+	for (i = 0; i < block->count; i++)
+	{
+		s = &block->samples[i];
+		classifier->sum[0] += s->x;
+		classifier->sum[1] += s->y;
+		classifier->sum[2] += s->z;
+		classifier->sum2[0] += (int32_t)s->x * s->x;
+		classifier->sum2[1] += (int32_t)s->y * s->y;
+		classifier->sum2[2] += (int32_t)s->z * s->z;
+		if (classifier->count > 0)
+		{
+			dx = (int32_t)s->x - classifier->previous.x;
+			dy = (int32_t)s->y - classifier->previous.y;
+			dz = (int32_t)s->z - classifier->previous.z;
+			classifier->diff2 += (int64_t)dx * dx + (int64_t)dy * dy + (int64_t)dz * dz;
+		}
+		classifier->previous = *s;
+		classifier->count++;
+		if (classifier->count >= classifier->window)
+		{
+			Classify_Window(classifier);
+		}
+	}
+}
+
+/**
+ * @brief Function that evaluates a tree
+ *
+ * @param tree Pointer to the tree table
+ * @param nodes Number of nodes of the tree
+ * @param features Pointer to FEATURE_COUNT features
+ * @return uint8_t Class of the reached leaf
+ */
+uint8_t Classify_Evaluate(const t_TreeNode *tree, uint8_t nodes, const int16_t *features)
+{
+	uint8_t node = 0;
+	uint8_t depth = 0;
+	// A valid tree reaches a leaf in fewer steps than it has nodes; the bound protects against a corrupted table
+	while (tree[node].feature != TREE_LEAF && depth < nodes)
+	{
+		if (tree[node].feature >= FEATURE_COUNT)
+		{
+			break;
+		}
+		node = (features[tree[node].feature] <= tree[node].threshold) ? tree[node].left : tree[node].right;
+		if (node >= nodes)
+		{
+			node = 0;
+			break;
+		}
+		depth++;
+	}
+	return (tree[node].feature == TREE_LEAF) ? tree[node].left : 0;
+}
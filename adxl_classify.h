@@ -0,0 +1,116 @@
+#ifndef ADXL_CLASSIFY_H
+#define ADXL_CLASSIFY_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define TREE_LEAF 					0xFF 	// feature value of a leaf node
+
+typedef enum FEATURE
+{
+	FEATURE_MEAN_X = 0, 			// mean in LSB
+	FEATURE_MEAN_Y,
+	FEATURE_MEAN_Z,
+	FEATURE_RMS_X, 					// RMS around the mean in LSB
+	FEATURE_RMS_Y,
+	FEATURE_RMS_Z,
+	FEATURE_LOW_BAND, 				// sqrt(total AC variance - HIGH_BAND^2), all axes
+	FEATURE_HIGH_BAND, 				// sqrt(mean squared first difference / 2), all axes
+	FEATURE_COUNT
+} FEATURE;
+
+typedef enum MOTION_CLASS
+{
+	MOTION_IDLE = 0,
+	MOTION_RUNNING,
+	MOTION_FAULT,
+	MOTION_TRANSPORT
+} MOTION_CLASS;
+
+/*
+ * Quantized decision tree stored in flash (const). Node 0 is the root. An inner node sends the features to left when
+ * features[feature] <= threshold and to right otherwise. A leaf has feature == TREE_LEAF and its class in left.
+ * host/train_tree.py emits such a table; a tree trained elsewhere (for example scikit-learn tree_.feature, tree_.threshold, tree_.children_left,
+ * tree_.children_right and the argmax of tree_.value) maps one to one on this table, with thresholds rounded down to int16.
+ */
+typedef struct t_TreeNode
+{
+	uint8_t feature;
+	int16_t threshold;
+	uint8_t left;
+	uint8_t right;
+} t_TreeNode;
+
+/*
+ * LOW_BAND and HIGH_BAND are a coarse two-band split from one first difference, not a filter bank: a sine at angular
+ * frequency w (rad/sample) contributes (1 - cos w) of its variance to HIGH_BAND^2, i.e. nothing at DC, all of it at
+ * ODR/4 and twice it at ODR/2, and white noise contributes all of its variance. They separate slow motion from
+ * vibration and impacts, nothing finer.
+ */
+
+typedef void (*CLASSIFY_CALLBACK)(uint8_t motion_class, const int16_t *features, void *arg);
+
+typedef struct t_Classifier
+{
+	const t_TreeNode *tree;
+	uint8_t nodes;
+	uint16_t window; 				// samples per window
+	uint16_t count; 				// samples in the current window
+	int64_t sum[3];
+	int64_t sum2[3];
+	int64_t diff2; 					// sum of squared first differences
+	t_Sample previous; 				// last sample of the window, valid when count > 0
+	int16_t features[FEATURE_COUNT];
+	CLASSIFY_CALLBACK callback;
+	void *arg;
+} t_Classifier;
+
+/******************************************************************************************************************************************************************************/
+/*																			Motion Classification 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a classifier
+ *
+ * @param classifier Pointer to the classifier
+ * @param tree Pointer to the tree table (const, stays in flash)
+ * @param nodes Number of nodes of the tree
+ * @param window Samples per classification window (at least 2)
+ * @param callback Function called with the class and features of every window
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the tree or the window is not valid
+ */
+STATUS_ADXL Classify_Init(t_Classifier *classifier, const t_TreeNode *tree, uint8_t nodes, uint16_t window, CLASSIFY_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that accumulates the features of a block (single pass, no sample buffer) and classifies every complete window
+ *
+ * @param classifier Pointer to the classifier
+ * @param block Sample block (see adxl_stream.h)
+ */
+void Classify_Process_Block(t_Classifier *classifier, const t_SampleBlock *block);
+
+/**
+ * @brief Function that evaluates a tree
+ *
+ * @param tree Pointer to the tree table
+ * @param nodes Number of nodes of the tree
+ * @param features Pointer to FEATURE_COUNT features
+ * @return uint8_t Class of the reached leaf
+ */
+uint8_t Classify_Evaluate(const t_TreeNode *tree, uint8_t nodes, const int16_t *features);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_CLASSIFY_H */
@@ -0,0 +1,24 @@
+#include "adxl_crc.h"
+
+static const uint16_t crc16_table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+
+/**
+ * @brief Function that updates a CRC-16/CCITT with a buffer (nibble table, 32 bytes of flash)
+ *
+ * @param crc Current CRC value (CRC16_INIT for a new computation)
+ * @param data Pointer to the data
+ * @param length Number of bytes
+ * @return uint16_t Updated CRC value
+ */
+uint16_t Crc16_Update(uint16_t crc, const uint8_t *data, uint32_t length)
+{
+	uint32_t i = 0;
+	for (i = 0; i < length; i++)
+	{
+		crc = (uint16_t)((crc << 4) ^ crc16_table[((crc >> 12) ^ (data[i] >> 4)) & 0x0F]);
+		crc = (uint16_t)((crc << 4) ^ crc16_table[((crc >> 12) ^ (data[i] & 0x0F)) & 0x0F]);
+	}
+	return crc;
+}
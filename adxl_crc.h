@@ -0,0 +1,27 @@
+#ifndef ADXL_CRC_H
+#define ADXL_CRC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define CRC16_INIT 					0xFFFF 	// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF
+
+/**
+ * @brief Function that updates a CRC-16/CCITT with a buffer (nibble table, 32 bytes of flash)
+ *
+ * @param crc Current CRC value (CRC16_INIT for a new computation)
+ * @param data Pointer to the data
+ * @param length Number of bytes
+ * @return uint16_t Updated CRC value
+ */
+uint16_t Crc16_Update(uint16_t crc, const uint8_t *data, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_CRC_H */
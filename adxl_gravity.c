@@ -0,0 +1,193 @@
+#include "adxl_gravity.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that updates the squared linear acceleration limit of the quasi-static state
+ *
+ * @param gravity Pointer to the tracker
+ */
+static void Gravity_Update_Band(t_Gravity *gravity)
+{
+	uint64_t band = ((uint64_t)gravity->lsb_per_g * gravity->config.dynamic_band) / 1000;
+	gravity->dynamic_limit = band * band;
+}
+
+/**
+ * @brief Function that saturates to the sample range
+ *
+ * @param value Value
+ * @return int16_t
+ */
+static int16_t Gravity_Saturate(int32_t value)
+{
+	if (value > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	if (value < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+	return (int16_t)value;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Gravity Removal 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the gravity tracker
+ *
+ * @param gravity Pointer to the tracker
+ * @param config Pointer to the configuration (shift + dynamic_shift <= GRAVITY_MAX_SHIFT)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Gravity_Init(t_Gravity *gravity, const t_GravityConfig *config, uint8_t data_format)
+{
+	if (config->shift + config->dynamic_shift > GRAVITY_MAX_SHIFT)
+	{
+		return ERR_PARAM;
+	}
+	gravity->config = *config;
+	gravity->lsb_per_g = Format_Lsb_Per_G(data_format);
+	gravity->resets = 0;
+	Gravity_Update_Band(gravity);
+	Gravity_Reset(gravity);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that rescales the gravity estimate after a range or resolution change, so the output stays continuous
+ *
+ * @param gravity Pointer to the tracker
+ * @param data_format New DATA_FORMAT register value
+ */
+void Gravity_Set_Format(t_Gravity *gravity, uint8_t data_format)
+{
+	uint32_t scale = Format_Lsb_Per_G(data_format);
+	int64_t value = 0;
+	uint8_t i = 0;
+	for (i = 0; i < 3; i++)
+	{
+		value = ((int64_t)gravity->gravity[i] * scale) / gravity->lsb_per_g;
+		if (value > ((int64_t)INT16_MAX << GRAVITY_FRACTION_BITS))
+		{
+			value = (int64_t)INT16_MAX << GRAVITY_FRACTION_BITS;
+		}
+		else if (value < ((int64_t)INT16_MIN * (1 << GRAVITY_FRACTION_BITS)))
+		{
+			value = (int64_t)INT16_MIN * (1 << GRAVITY_FRACTION_BITS);
+		}
+		gravity->gravity[i] = (int32_t)value;
+	}
+	gravity->lsb_per_g = scale;
+	Gravity_Update_Band(gravity);
+}
+
+/**
+ * @brief Function that restarts the estimate from the next sample (after a sleep transition or when the orientation is known to have changed).
+ * A gap longer than the time constant restarts it as well
+ *
+ * @param gravity Pointer to the tracker
+ */
+void Gravity_Reset(t_Gravity *gravity)
+{
+	gravity->started = false;
+	gravity->warm_shift = 0;
+	gravity->warm = 0;
+	gravity->resets++;
+}
+
+/**
+ * @brief Function that tracks gravity and writes the linear acceleration of a block in one pass, integer only
+ *
+ * @param gravity Pointer to the tracker
+ * @param block Sample block (see adxl_types.h)
+ * @param linear Destination of block->count samples, may be block->samples for in-place processing
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Gravity_Process_Block(t_Gravity *gravity, const t_SampleBlock *block, t_Sample *linear)
+{
+	int32_t gx = gravity->gravity[0];
+	int32_t gy = gravity->gravity[1];
+	int32_t gz = gravity->gravity[2];
+	int32_t x = 0;
+	int32_t y = 0;
+	int32_t z = 0;
+	int32_t lx = 0;
+	int32_t ly = 0;
+	int32_t lz = 0;
+	uint8_t shift = 0;
+	uint16_t i = 0;
+
+	if (gravity->started && (uint32_t)(block->sequence - gravity->next_sequence) >= ((uint32_t)1 << gravity->config.shift))
+	{
+		// Lost more than a time constant (sleep, long gap): the orientation may have changed
+		Gravity_Reset(gravity);
+	}
+	for (i = 0; i < block->count; i++)
+	{
+		x = block->samples[i].x;
+		y = block->samples[i].y;
+		z = block->samples[i].z;
+		if (!gravity->started)
+		{
+			gx = x * (1 << GRAVITY_FRACTION_BITS);
+			gy = y * (1 << GRAVITY_FRACTION_BITS);
+			gz = z * (1 << GRAVITY_FRACTION_BITS);
+			gravity->started = true;
+		}
+		// Settling: 2^-k while fewer than 2^(k+1) samples were seen, a running mean until the configured coefficient is reached
+		if (gravity->warm_shift < gravity->config.shift && ++gravity->warm >= ((uint32_t)2 << gravity->warm_shift))
+		{
+			gravity->warm_shift++;
+		}
+		shift = gravity->warm_shift;
+		if (gravity->config.dynamic_shift && gravity->warm_shift == gravity->config.shift)
+		{
+			// Slow the tracking down during motion. The test on the linear part is symmetric, so steady vibration does not bias the estimate
+			lx = x - ((gx + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS);
+			ly = y - ((gy + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS);
+			lz = z - ((gz + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS);
+			if ((uint64_t)((int64_t)lx * lx + (int64_t)ly * ly + (int64_t)lz * lz) > gravity->dynamic_limit)
+			{
+				shift += gravity->config.dynamic_shift;
+			}
+		}
+		gx += ((x * (1 << GRAVITY_FRACTION_BITS)) - gx) >> shift;
+		gy += ((y * (1 << GRAVITY_FRACTION_BITS)) - gy) >> shift;
+		gz += ((z * (1 << GRAVITY_FRACTION_BITS)) - gz) >> shift;
+		linear[i].x = Gravity_Saturate(x - ((gx + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS));
+		linear[i].y = Gravity_Saturate(y - ((gy + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS));
+		linear[i].z = Gravity_Saturate(z - ((gz + (1 << (GRAVITY_FRACTION_BITS - 1))) >> GRAVITY_FRACTION_BITS));
+	}
+	gravity->gravity[0] = gx;
+	gravity->gravity[1] = gy;
+	gravity->gravity[2] = gz;
+	gravity->next_sequence = block->sequence + block->count;
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that removes gravity in place, with the stage signature of host/adxl_pipeline.h. An activity or inactivity interrupt restarts
+ * the estimate first: the sensor is waking up or coming to rest, and its orientation may have changed in between
+ *
+ * @param block Sample block
+ * @param samples Samples of the block, replaced by the linear acceleration
+ * @param int_source Interrupt source read before the block was drained (NULL if not available)
+ * @param state Pointer to the tracker
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Gravity_Stage(const t_SampleBlock *block, t_Sample *samples, const t_IntSource *int_source, void *state)
+{
+	t_Gravity *gravity = (t_Gravity *)state;
+	if (int_source && (int_source->activity || int_source->inactivity))
+	{
+		Gravity_Reset(gravity);
+	}
+	return Gravity_Process_Block(gravity, block, samples);
+}
@@ -0,0 +1,94 @@
+#ifndef ADXL_GRAVITY_H
+#define ADXL_GRAVITY_H
+
+#include "adxl_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define GRAVITY_FRACTION_BITS 		14 		// fractional bits of the gravity estimate (keeps the filter difference in 32 bits)
+#define GRAVITY_MAX_SHIFT 			14
+
+typedef struct t_GravityConfig
+{
+	uint8_t shift; 					// low-pass coefficient 2^-shift (time constant about 2^shift samples)
+	uint8_t dynamic_shift; 			// extra shift while the linear acceleration is above dynamic_band (0 disables the gating)
+	uint16_t dynamic_band; 			// mg of linear acceleration below which the sensor is considered quasi-static
+} t_GravityConfig;
+
+typedef struct t_Gravity
+{
+	t_GravityConfig config;
+	int32_t gravity[3]; 			// gravity in LSB << GRAVITY_FRACTION_BITS
+	uint32_t lsb_per_g; 			// output scale from DATA_FORMAT
+	uint64_t dynamic_limit; 		// dynamic_band squared, LSB^2 (left justified data reaches 65536 LSB/g)
+	uint8_t warm_shift; 			// shift used while the filter settles after a reset (grows to config.shift)
+	uint32_t warm; 					// samples since the reset
+	uint32_t next_sequence;
+	bool started;
+	uint32_t resets;
+} t_Gravity;
+
+/******************************************************************************************************************************************************************************/
+/*																				Gravity Removal 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the gravity tracker
+ *
+ * @param gravity Pointer to the tracker
+ * @param config Pointer to the configuration (shift + dynamic_shift <= GRAVITY_MAX_SHIFT)
+ * @param data_format DATA_FORMAT register value, used for the output scale
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Gravity_Init(t_Gravity *gravity, const t_GravityConfig *config, uint8_t data_format);
+
+/**
+ * @brief Function that rescales the gravity estimate after a range or resolution change, so the output stays continuous
+ *
+ * @param gravity Pointer to the tracker
+ * @param data_format New DATA_FORMAT register value
+ */
+void Gravity_Set_Format(t_Gravity *gravity, uint8_t data_format);
+
+/**
+ * @brief Function that restarts the estimate from the next sample (after a sleep transition or when the orientation is known to have changed).
+ * A gap longer than the time constant restarts it as well
+ *
+ * @param gravity Pointer to the tracker
+ */
+void Gravity_Reset(t_Gravity *gravity);
+
+/**
+ * @brief Function that tracks gravity and writes the linear acceleration of a block in one pass, integer only
+ *
+ * @param gravity Pointer to the tracker
+ * @param block Sample block (see adxl_types.h)
+ * @param linear Destination of block->count samples, may be block->samples for in-place processing
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Gravity_Process_Block(t_Gravity *gravity, const t_SampleBlock *block, t_Sample *linear);
+
+/**
+ * @brief Function that removes gravity in place, with the stage signature of host/adxl_pipeline.h. An activity or inactivity interrupt restarts
+ * the estimate first: the sensor is waking up or coming to rest, and its orientation may have changed in between
+ *
+ * @param block Sample block
+ * @param samples Samples of the block, replaced by the linear acceleration
+ * @param int_source Interrupt source read before the block was drained (NULL if not available)
+ * @param state Pointer to the tracker
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Gravity_Stage(const t_SampleBlock *block, t_Sample *samples, const t_IntSource *int_source, void *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_GRAVITY_H */
@@ -0,0 +1,219 @@
+#include "adxl_latency.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+#define SUB_HALF 					(1UL << (LATENCY_SUB_BITS - 1))
+
+/**
+ * @brief Function that maps a value to its bucket. Values below 2^LATENCY_SUB_BITS get one bucket each, larger values keep
+ * LATENCY_SUB_BITS significant bits
+ *
+ * @param value Value
+ * @return uint32_t Bucket index
+ */
+static uint32_t Bucket_Index(uint32_t value)
+{
+	uint32_t msb = 0;
+	uint32_t shift = 0;
+	if (value < (1UL << LATENCY_SUB_BITS))
+	{
+		return value;
+	}
+	msb = 31 - (uint32_t)__builtin_clz(value);
+	shift = msb - LATENCY_SUB_BITS + 1;
+	return shift * SUB_HALF + (value >> shift);
+}
+
+/**
+ * @brief Function that returns the highest value that maps to a bucket
+ *
+ * @param index Bucket index
+ * @return uint32_t
+ */
+static uint32_t Bucket_Top(uint32_t index)
+{
+	uint32_t shift = 0;
+	uint32_t sub = 0;
+	if (index < (1UL << LATENCY_SUB_BITS))
+	{
+		return index;
+	}
+	shift = (index >> (LATENCY_SUB_BITS - 1)) - 1;
+	sub = index - shift * SUB_HALF;
+	return (uint32_t)((((uint64_t)sub + 1) << shift) - 1);
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Histogram 																					  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that clears a histogram
+ *
+ * @param histogram Pointer to the histogram
+ */
+void Histogram_Reset(t_Histogram *histogram)
+{
+	uint32_t i = 0;
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		histogram->counts[i] = 0;
+	}
+	histogram->total = 0;
+	histogram->max = 0;
+}
+
+/**
+ * @brief Function that records a value (log-linear buckets, constant relative error, fixed memory)
+ *
+ * @param histogram Pointer to the histogram
+ * @param value Value to record
+ */
+void Histogram_Record(t_Histogram *histogram, uint32_t value)
+{
+	histogram->counts[Bucket_Index(value)]++;
+	histogram->total++;
+	if (value > histogram->max)
+	{
+		histogram->max = value;
+	}
+}
+
+/**
+ * @brief Function that returns a percentile. The result is the highest value of the bucket that contains it
+ *
+ * @param histogram Pointer to the histogram
+ * @param per_100k Percentile in units of 0.001 % (50000: p50, 99000: p99, 99900: p99.9, 100000: max)
+ * @return uint32_t
+ */
+uint32_t Histogram_Percentile(const t_Histogram *histogram, uint32_t per_100k)
+{
+	uint64_t target = 0;
+	uint64_t seen = 0;
+	uint32_t i = 0;
+	uint32_t value = 0;
+	if (histogram->total == 0)
+	{
+		return 0;
+	}
+	if (per_100k >= 100000)
+	{
+		return histogram->max;
+	}
+	target = ((uint64_t)histogram->total * per_100k + 99999) / 100000; // rank, rounded up
+	if (target == 0)
+	{
+		target = 1;
+	}
+	for (i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		seen += histogram->counts[i];
+		if (seen >= target)
+		{
+			value = Bucket_Top(i);
+			break;
+		}
+	}
+	return (value < histogram->max) ? value : histogram->max;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																			Latency Measurement 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that enables the Cortex-M DWT cycle counter used by LATENCY_NOW
+ */
+void Latency_Enable_Counter(void)
+{
+#ifdef DWT
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief Function that clears every histogram of the harness
+ *
+ * @param latency Pointer to the harness
+ */
+void Latency_Reset(t_Latency *latency)
+{
+	uint8_t i = 0;
+	for (i = 0; i < STAGE_COUNT - 1; i++)
+	{
+		Histogram_Reset(&latency->stage[i]);
+	}
+	Histogram_Reset(&latency->total);
+}
+
+/**
+ * @brief Bus hook for Set_Bus_Hook. It stamps STAGE_BUS_START when the first transaction after Latency_Begin asserts CS and
+ * STAGE_BUS_COMPLETE each time CS is released, so a sample read with Get_Interrupt_Source then Read_6Bytes spans both transactions
+ *
+ * @param spi SPI interface
+ * @param complete false after CS is asserted, true after it is released
+ * @param arg Pointer to the t_LatencyTrace of the sample in flight
+ */
+void Latency_Bus_Hook(SPI_HandleTypeDef *spi, bool complete, void *arg)
+{
+	t_LatencyTrace *trace = (t_LatencyTrace *)arg;
+	(void)spi;
+	if (complete)
+	{
+		Latency_Mark(trace, STAGE_BUS_COMPLETE);
+	}
+	else if (trace->transactions++ == 0)
+	{
+		Latency_Mark(trace, STAGE_BUS_START);
+	}
+}
+
+/**
+ * @brief Function that records the stage intervals of a completed trace
+ *
+ * @param latency Pointer to the harness
+ * @param trace Pointer to a trace with every stage stamped
+ */
+void Latency_Commit(t_Latency *latency, const t_LatencyTrace *trace)
+{
+	uint8_t i = 0;
+	for (i = 0; i < STAGE_COUNT - 1; i++)
+	{
+		Histogram_Record(&latency->stage[i], trace->time[i + 1] - trace->time[i]);
+	}
+	Histogram_Record(&latency->total, trace->time[STAGE_DELIVERY] - trace->time[STAGE_INTERRUPT]);
+}
+
+/**
+ * @brief Function that times blocking Read_6Bytes calls with LATENCY_NOW, from the call to the return. Run it once with Set_SPI_Fast_Path
+ * enabled and once without to compare the register-level and HAL paths on the target
+ *
+ * @param spi SPI interface
+ * @param histogram Pointer to the histogram, cleared first
+ * @param count Number of reads
+ * @return STATUS_ADXL error of the first read that failed
+ */
+STATUS_ADXL Latency_Measure_Reads(SPI_HandleTypeDef *spi, t_Histogram *histogram, uint32_t count)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	int16_t x = 0;
+	int16_t y = 0;
+	int16_t z = 0;
+	uint32_t start = 0;
+	uint32_t i = 0;
+	Histogram_Reset(histogram);
+	for (i = 0; i < count && ret_val == STATUS_OK_ADXL; i++)
+	{
+		start = LATENCY_NOW();
+		ret_val = Read_6Bytes(spi, MEASUREMENTS_DATA, &x, &y, &z);
+		if (ret_val == STATUS_OK_ADXL)
+		{
+			Histogram_Record(histogram, LATENCY_NOW() - start);
+		}
+	}
+	return ret_val;
+}
@@ -0,0 +1,153 @@
+#ifndef ADXL_LATENCY_H
+#define ADXL_LATENCY_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef LATENCY_NOW
+#define LATENCY_NOW() 				(DWT->CYCCNT) 	// CPU cycle counter, see Latency_Enable_Counter
+#endif
+
+#ifndef LATENCY_SUB_BITS
+#define LATENCY_SUB_BITS 			5 		// 2^(LATENCY_SUB_BITS-1) sub-buckets per power of two: 1/16 = 6.25 % resolution
+#endif
+
+#define LATENCY_BUCKETS 			((34 - LATENCY_SUB_BITS) << (LATENCY_SUB_BITS - 1))
+
+typedef enum LATENCY_STAGE
+{
+	STAGE_INTERRUPT = 0, 			// DATA_READY interrupt entry
+	STAGE_BUS_START, 				// CS asserted, first byte of Read_6Bytes/Get_Interrupt_Source
+	STAGE_BUS_COMPLETE, 			// CS released
+	STAGE_DECODE, 					// samples decoded into t_Sample
+	STAGE_DELIVERY, 				// consumer received the samples
+	STAGE_COUNT
+} LATENCY_STAGE;
+
+typedef struct t_Histogram
+{
+	uint32_t counts[LATENCY_BUCKETS];
+	uint32_t total;
+	uint32_t max;
+} t_Histogram;
+
+typedef struct t_LatencyTrace
+{
+	uint32_t time[STAGE_COUNT];
+	uint8_t transactions; 			// bus transactions since Latency_Begin
+} t_LatencyTrace;
+
+typedef struct t_Latency
+{
+	t_Histogram stage[STAGE_COUNT - 1]; // stage[i]: time from stage i to stage i + 1
+	t_Histogram total; 				// interrupt entry to delivery
+} t_Latency;
+
+/******************************************************************************************************************************************************************************/
+/*																				Histogram 																					  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that clears a histogram
+ *
+ * @param histogram Pointer to the histogram
+ */
+void Histogram_Reset(t_Histogram *histogram);
+
+/**
+ * @brief Function that records a value (log-linear buckets, constant relative error, fixed memory)
+ *
+ * @param histogram Pointer to the histogram
+ * @param value Value to record
+ */
+void Histogram_Record(t_Histogram *histogram, uint32_t value);
+
+/**
+ * @brief Function that returns a percentile. The result is the highest value of the bucket that contains it
+ *
+ * @param histogram Pointer to the histogram
+ * @param per_100k Percentile in units of 0.001 % (50000: p50, 99000: p99, 99900: p99.9, 100000: max)
+ * @return uint32_t
+ */
+uint32_t Histogram_Percentile(const t_Histogram *histogram, uint32_t per_100k);
+
+/******************************************************************************************************************************************************************************/
+/*																			Latency Measurement 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that enables the Cortex-M DWT cycle counter used by LATENCY_NOW
+ */
+void Latency_Enable_Counter(void);
+
+/**
+ * @brief Function that clears every histogram of the harness
+ *
+ * @param latency Pointer to the harness
+ */
+void Latency_Reset(t_Latency *latency);
+
+/**
+ * @brief Function that stamps one stage of a sample in flight (a couple of cycles, safe in interrupts)
+ *
+ * @param trace Pointer to the trace of the sample
+ * @param stage Stage reached
+ */
+static inline void Latency_Mark(t_LatencyTrace *trace, LATENCY_STAGE stage)
+{
+	trace->time[stage] = LATENCY_NOW();
+}
+
+/**
+ * @brief Function that starts the trace of a sample at interrupt entry
+ *
+ * @param trace Pointer to the trace of the sample
+ */
+static inline void Latency_Begin(t_LatencyTrace *trace)
+{
+	trace->transactions = 0;
+	Latency_Mark(trace, STAGE_INTERRUPT);
+}
+
+/**
+ * @brief Bus hook for Set_Bus_Hook. It stamps STAGE_BUS_START when the first transaction after Latency_Begin asserts CS and
+ * STAGE_BUS_COMPLETE each time CS is released, so a sample read with Get_Interrupt_Source then Read_6Bytes spans both transactions
+ *
+ * @param spi SPI interface
+ * @param complete false after CS is asserted, true after it is released
+ * @param arg Pointer to the t_LatencyTrace of the sample in flight
+ */
+void Latency_Bus_Hook(SPI_HandleTypeDef *spi, bool complete, void *arg);
+
+/**
+ * @brief Function that records the stage intervals of a completed trace
+ *
+ * @param latency Pointer to the harness
+ * @param trace Pointer to a trace with every stage stamped
+ */
+void Latency_Commit(t_Latency *latency, const t_LatencyTrace *trace);
+
+/**
+ * @brief Function that times blocking Read_6Bytes calls with LATENCY_NOW, from the call to the return. Run it once with Set_SPI_Fast_Path
+ * enabled and once without to compare the register-level and HAL paths on the target
+ *
+ * @param spi SPI interface
+ * @param histogram Pointer to the histogram, cleared first
+ * @param count Number of reads
+ * @return STATUS_ADXL error of the first read that failed
+ */
+STATUS_ADXL Latency_Measure_Reads(SPI_HandleTypeDef *spi, t_Histogram *histogram, uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_LATENCY_H */
@@ -0,0 +1,409 @@
+#include "adxl_log.h"
+#include "adxl_crc.h"
+#include <string.h>
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+static void Put_U16(uint8_t *p, uint16_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+static void Put_U32(uint8_t *p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+static void Put_U64(uint8_t *p, uint64_t value)
+{
+	Put_U32(&p[0], (uint32_t)value);
+	Put_U32(&p[4], (uint32_t)(value >> 32));
+}
+
+static uint16_t Get_U16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t Get_U32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t Get_U64(const uint8_t *p)
+{
+	return (uint64_t)Get_U32(&p[0]) | (uint64_t)Get_U32(&p[4]) << 32;
+}
+
+static uint32_t Zig_Zag(int32_t delta)
+{
+	return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+static int32_t Un_Zig_Zag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint8_t Bit_Width(uint32_t value)
+{
+	uint8_t width = 0;
+	while (value)
+	{
+		width++;
+		value >>= 1;
+	}
+	return width;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Stream Encoder 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes an encoder
+ *
+ * @param encoder Pointer to the encoder
+ * @param data_format DATA_FORMAT register value stored in every block header
+ * @param bw_rate BW_RATE register value stored in every block header
+ * @param write Function that stores a complete block
+ * @param arg User argument for write
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Init(t_LogEncoder *encoder, uint8_t data_format, uint8_t bw_rate, LOG_WRITE write, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	encoder->data_format = data_format;
+	encoder->bw_rate = bw_rate;
+	encoder->count = 0;
+	encoder->sequence = 0;
+	encoder->timestamp = 0;
+	encoder->write = write;
+	encoder->arg = arg;
+	encoder->raw_bytes = 0;
+	encoder->encoded_bytes = 0;
+	return ret_val;
+}
+
+/**
+ * @brief Function that appends a sample block. A block is emitted when the buffer is full or the sequence is discontinuous (gap)
+ *
+ * @param encoder Pointer to the encoder
+ * @param block Sample block (see adxl_stream.h)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Push(t_LogEncoder *encoder, const t_SampleBlock *block)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint16_t i = 0;
+	if (encoder->count > 0 && block->sequence != encoder->sequence + encoder->count)
+	{
+		ret_val = Log_Encoder_Flush(encoder);
+	}
+	for (i = 0; i < block->count && ret_val == STATUS_OK_ADXL; i++)
+	{
+		if (encoder->count == 0)
+		{
+			encoder->sequence = block->sequence + i;
+			encoder->timestamp = block->timestamp + ((uint64_t)i * block->period) / 1000;
+		}
+		encoder->samples[encoder->count++] = block->samples[i];
+		if (encoder->count == LOG_BLOCK_SAMPLES)
+		{
+			ret_val = Log_Encoder_Flush(encoder);
+		}
+	}
+	encoder->raw_bytes += (uint32_t)block->count * sizeof(t_Sample);
+	return ret_val;
+}
+
+/**
+ * @brief Function that emits the buffered samples as a block
+ *
+ * @param encoder Pointer to the encoder
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Flush(t_LogEncoder *encoder)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_LogHeader header;
+	uint32_t length = 0;
+	if (encoder->count > 0)
+	{
+		header.version = LOG_VERSION;
+		header.data_format = encoder->data_format;
+		header.bw_rate = encoder->bw_rate;
+		header.count = encoder->count;
+		header.sequence = encoder->sequence;
+		header.timestamp = encoder->timestamp;
+		if (Log_Encode_Block(&header, encoder->samples, encoder->out, sizeof(encoder->out), &length))
+		{
+			ret_val = ERR_PARAM;
+		}
+		else if (encoder->write(encoder->out, (uint16_t)length, encoder->arg))
+		{
+			ret_val = ERR_WRITE;
+		}
+		else
+		{
+			encoder->encoded_bytes += length;
+		}
+		encoder->count = 0;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that encodes samples into one block
+ *
+ * @param header Header fields (width and payload are computed)
+ * @param samples Pointer to the samples
+ * @param out Destination buffer (LOG_MAX_BLOCK_SIZE is always enough for LOG_BLOCK_SAMPLES)
+ * @param size Size of the destination buffer
+ * @param length Pointer to the length of the block
+ * @return STATUS_ADXL ERR_PARAM if the block does not fit
+ */
+STATUS_ADXL Log_Encode_Block(const t_LogHeader *header, const t_Sample *samples, uint8_t *out, uint32_t size, uint32_t *length)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint32_t max_x = 0;
+	uint32_t max_y = 0;
+	uint32_t max_z = 0;
+	uint8_t wx = 0;
+	uint8_t wy = 0;
+	uint8_t wz = 0;
+	uint32_t payload = 0;
+	uint32_t acc = 0;
+	uint8_t bits = 0;
+	uint8_t *p = NULL;
+	uint16_t i = 0;
+	uint16_t crc = 0;
+
+	if (header->count == 0)
+	{
+		return ERR_PARAM;
+	}
+	// First pass: bit width of every axis
+	for (i = 1; i < header->count; i++)
+	{
+		max_x |= Zig_Zag((int32_t)samples[i].x - samples[i - 1].x);
+		max_y |= Zig_Zag((int32_t)samples[i].y - samples[i - 1].y);
+		max_z |= Zig_Zag((int32_t)samples[i].z - samples[i - 1].z);
+	}
+	wx = Bit_Width(max_x);
+	wy = Bit_Width(max_y);
+	wz = Bit_Width(max_z);
+	payload = 6 + (((uint32_t)header->count - 1) * (wx + wy + wz) + 7) / 8;
+	if (payload > 0xFFFF || LOG_HEADER_SIZE + payload + LOG_CRC_SIZE > size)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		Put_U16(&out[0], LOG_MAGIC);
+		out[2] = LOG_VERSION;
+		out[3] = header->data_format;
+		out[4] = header->bw_rate;
+		out[5] = wx;
+		out[6] = wy;
+		out[7] = wz;
+		Put_U16(&out[8], header->count);
+		Put_U16(&out[10], (uint16_t)payload);
+		Put_U32(&out[12], header->sequence);
+		Put_U64(&out[16], header->timestamp);
+		p = &out[LOG_HEADER_SIZE];
+		Put_U16(&p[0], (uint16_t)samples[0].x);
+		Put_U16(&p[2], (uint16_t)samples[0].y);
+		Put_U16(&p[4], (uint16_t)samples[0].z);
+		p += 6;
+		// Second pass: pack the deltas, at most 7 + 17 bits are pending in the accumulator
+		for (i = 1; i < header->count; i++)
+		{
+			acc |= Zig_Zag((int32_t)samples[i].x - samples[i - 1].x) << bits;
+			bits += wx;
+			while (bits >= 8)
+			{
+				*p++ = (uint8_t)acc;
+				acc >>= 8;
+				bits -= 8;
+			}
+			acc |= Zig_Zag((int32_t)samples[i].y - samples[i - 1].y) << bits;
+			bits += wy;
+			while (bits >= 8)
+			{
+				*p++ = (uint8_t)acc;
+				acc >>= 8;
+				bits -= 8;
+			}
+			acc |= Zig_Zag((int32_t)samples[i].z - samples[i - 1].z) << bits;
+			bits += wz;
+			while (bits >= 8)
+			{
+				*p++ = (uint8_t)acc;
+				acc >>= 8;
+				bits -= 8;
+			}
+		}
+		if (bits > 0)
+		{
+			*p++ = (uint8_t)acc;
+		}
+		crc = Crc16_Update(CRC16_INIT, out, LOG_HEADER_SIZE + payload);
+		Put_U16(p, crc);
+		*length = LOG_HEADER_SIZE + payload + LOG_CRC_SIZE;
+	}
+	return ret_val;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Stream Decoder 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that parses and checks the block at the start of a buffer without decoding the samples
+ *
+ * @param data Pointer to the block
+ * @param size Bytes available
+ * @param header Pointer to the decoded header
+ * @param length Pointer to the total length of the block
+ * @return STATUS_ADXL ERR_READING if there is no valid block (bad sync word, truncated or CRC error)
+ */
+STATUS_ADXL Log_Parse_Block(const uint8_t *data, uint32_t size, t_LogHeader *header, uint32_t *length)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint32_t total = 0;
+	uint32_t bits = 0;
+	if (size < LOG_HEADER_SIZE + LOG_CRC_SIZE || Get_U16(&data[0]) != LOG_MAGIC || data[2] != LOG_VERSION)
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		header->version = data[2];
+		header->data_format = data[3];
+		header->bw_rate = data[4];
+		header->width[0] = data[5];
+		header->width[1] = data[6];
+		header->width[2] = data[7];
+		header->count = Get_U16(&data[8]);
+		header->payload = Get_U16(&data[10]);
+		header->sequence = Get_U32(&data[12]);
+		header->timestamp = Get_U64(&data[16]);
+		total = LOG_HEADER_SIZE + header->payload + LOG_CRC_SIZE;
+		bits = ((uint32_t)header->count - 1) * (header->width[0] + header->width[1] + header->width[2]);
+		if (header->count == 0 || header->width[0] > 17 || header->width[1] > 17 || header->width[2] > 17)
+		{
+			ret_val = ERR_READING;
+		}
+		else if (header->payload != 6 + (bits + 7) / 8 || total > size)
+		{
+			ret_val = ERR_READING;
+		}
+		else if (Crc16_Update(CRC16_INIT, data, LOG_HEADER_SIZE + header->payload) != Get_U16(&data[LOG_HEADER_SIZE + header->payload]))
+		{
+			ret_val = ERR_READING;
+		}
+		else
+		{
+			*length = total;
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that decodes the samples of a block checked by Log_Parse_Block
+ *
+ * @param data Pointer to the block
+ * @param header Header returned by Log_Parse_Block
+ * @param samples Destination array of at least header->count samples
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Decode_Samples(const uint8_t *data, const t_LogHeader *header, t_Sample *samples)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	const uint8_t *p = &data[LOG_HEADER_SIZE];
+	const uint8_t *end = p + header->payload;
+	const uint8_t wx = header->width[0];
+	const uint8_t wy = header->width[1];
+	const uint8_t wz = header->width[2];
+	const uint32_t mx = (1UL << wx) - 1;
+	const uint32_t my = (1UL << wy) - 1;
+	const uint32_t mz = (1UL << wz) - 1;
+	uint64_t acc = 0;
+	uint8_t bits = 0;
+	int32_t x = 0;
+	int32_t y = 0;
+	int32_t z = 0;
+	uint16_t i = 0;
+
+	x = (int16_t)Get_U16(&p[0]);
+	y = (int16_t)Get_U16(&p[2]);
+	z = (int16_t)Get_U16(&p[4]);
+	p += 6;
+	samples[0].x = (int16_t)x;
+	samples[0].y = (int16_t)y;
+	samples[0].z = (int16_t)z;
+	for (i = 1; i < header->count; i++)
+	{
+		// Refill so that one whole triplet (at most 51 bits) is available
+		while (bits <= 56 && p < end)
+		{
+			acc |= (uint64_t)*p++ << bits;
+			bits += 8;
+		}
+		x += Un_Zig_Zag((uint32_t)acc & mx);
+		acc >>= wx;
+		y += Un_Zig_Zag((uint32_t)acc & my);
+		acc >>= wy;
+		z += Un_Zig_Zag((uint32_t)acc & mz);
+		acc >>= wz;
+		bits -= wx + wy + wz;
+		samples[i].x = (int16_t)x;
+		samples[i].y = (int16_t)y;
+		samples[i].z = (int16_t)z;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that finds the next valid block after corrupted data
+ *
+ * @param data Pointer to the buffer
+ * @param size Size of the buffer
+ * @param offset Pointer to the start offset, updated with the offset of the block
+ * @return STATUS_ADXL ERR_READING if no valid block was found
+ */
+STATUS_ADXL Log_Resync(const uint8_t *data, uint32_t size, uint32_t *offset)
+{
+	STATUS_ADXL ret_val = ERR_READING;
+	t_LogHeader header;
+	uint32_t length = 0;
+	uint32_t i = *offset;
+	const uint8_t *hit = NULL;
+	while (ret_val != STATUS_OK_ADXL && i + 1 < size)
+	{
+		hit = memchr(&data[i], (uint8_t)LOG_MAGIC, size - i - 1);
+		if (hit == NULL)
+		{
+			break;
+		}
+		i = (uint32_t)(hit - data);
+		if (data[i + 1] == (uint8_t)(LOG_MAGIC >> 8) && Log_Parse_Block(&data[i], size - i, &header, &length) == STATUS_OK_ADXL)
+		{
+			*offset = i;
+			ret_val = STATUS_OK_ADXL;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	return ret_val;
+}
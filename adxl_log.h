@@ -0,0 +1,158 @@
+#ifndef ADXL_LOG_H
+#define ADXL_LOG_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Block layout (little endian):
+ *
+ *	offset	size	field
+ *	0		2		LOG_MAGIC (sync word for resynchronization)
+ *	2		1		LOG_VERSION
+ *	3		1		DATA_FORMAT register snapshot
+ *	4		1		BW_RATE register snapshot
+ *	5		3		bit width of the x, y and z deltas (0-17)
+ *	8		2		number of samples
+ *	10		2		payload length in bytes
+ *	12		4		sequence number of the first sample
+ *	16		8		timestamp of the first sample in us
+ *	24		n		payload: first sample as 3 x int16, then the zig-zag deltas of every following sample
+ *					bit-packed LSB first, x y z interleaved
+ *	24+n	2		CRC-16/CCITT of bytes 0 .. 24+n-1
+ */
+
+#define LOG_MAGIC 					0xAD13
+#define LOG_VERSION 				2
+#define LOG_HEADER_SIZE 			24
+#define LOG_CRC_SIZE 				2
+
+#ifndef LOG_BLOCK_SAMPLES
+#define LOG_BLOCK_SAMPLES 			128 	// samples per block, bounds the encoder RAM
+#endif
+
+#define LOG_MAX_BLOCK_SIZE 			(LOG_HEADER_SIZE + 6 + ((LOG_BLOCK_SAMPLES - 1) * 3 * 17 + 7) / 8 + LOG_CRC_SIZE)
+
+typedef STATUS_ADXL (*LOG_WRITE)(const uint8_t *data, uint16_t length, void *arg);
+
+typedef struct t_LogHeader
+{
+	uint8_t version;
+	uint8_t data_format;
+	uint8_t bw_rate;
+	uint8_t width[3];
+	uint16_t count;
+	uint16_t payload;
+	uint32_t sequence;
+	uint64_t timestamp;
+} t_LogHeader;
+
+typedef struct t_LogEncoder
+{
+	uint8_t data_format;
+	uint8_t bw_rate;
+	t_Sample samples[LOG_BLOCK_SAMPLES];
+	uint16_t count;
+	uint32_t sequence; 				// sequence number of samples[0]
+	uint64_t timestamp; 			// time of samples[0]
+	uint8_t out[LOG_MAX_BLOCK_SIZE];
+	LOG_WRITE write;
+	void *arg;
+	uint32_t raw_bytes; 			// bytes of raw int16 triplets received
+	uint32_t encoded_bytes; 		// bytes written
+} t_LogEncoder;
+
+/******************************************************************************************************************************************************************************/
+/*																				Stream Encoder 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes an encoder
+ *
+ * @param encoder Pointer to the encoder
+ * @param data_format DATA_FORMAT register value stored in every block header
+ * @param bw_rate BW_RATE register value stored in every block header
+ * @param write Function that stores a complete block
+ * @param arg User argument for write
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Init(t_LogEncoder *encoder, uint8_t data_format, uint8_t bw_rate, LOG_WRITE write, void *arg);
+
+/**
+ * @brief Function that appends a sample block. A block is emitted when the buffer is full or the sequence is discontinuous (gap)
+ *
+ * @param encoder Pointer to the encoder
+ * @param block Sample block (see adxl_stream.h)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Push(t_LogEncoder *encoder, const t_SampleBlock *block);
+
+/**
+ * @brief Function that emits the buffered samples as a block
+ *
+ * @param encoder Pointer to the encoder
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Encoder_Flush(t_LogEncoder *encoder);
+
+/**
+ * @brief Function that encodes samples into one block
+ *
+ * @param header Header fields (width and payload are computed)
+ * @param samples Pointer to the samples
+ * @param out Destination buffer (LOG_MAX_BLOCK_SIZE is always enough for LOG_BLOCK_SAMPLES)
+ * @param size Size of the destination buffer
+ * @param length Pointer to the length of the block
+ * @return STATUS_ADXL ERR_PARAM if the block does not fit
+ */
+STATUS_ADXL Log_Encode_Block(const t_LogHeader *header, const t_Sample *samples, uint8_t *out, uint32_t size, uint32_t *length);
+
+/******************************************************************************************************************************************************************************/
+/*																				Stream Decoder 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that parses and checks the block at the start of a buffer without decoding the samples
+ *
+ * @param data Pointer to the block
+ * @param size Bytes available
+ * @param header Pointer to the decoded header
+ * @param length Pointer to the total length of the block
+ * @return STATUS_ADXL ERR_READING if there is no valid block (bad sync word, truncated or CRC error)
+ */
+STATUS_ADXL Log_Parse_Block(const uint8_t *data, uint32_t size, t_LogHeader *header, uint32_t *length);
+
+/**
+ * @brief Function that decodes the samples of a block checked by Log_Parse_Block
+ *
+ * @param data Pointer to the block
+ * @param header Header returned by Log_Parse_Block
+ * @param samples Destination array of at least header->count samples
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Log_Decode_Samples(const uint8_t *data, const t_LogHeader *header, t_Sample *samples);
+
+/**
+ * @brief Function that finds the next valid block after corrupted data
+ *
+ * @param data Pointer to the buffer
+ * @param size Size of the buffer
+ * @param offset Pointer to the start offset, updated with the offset of the block
+ * @return STATUS_ADXL ERR_READING if no valid block was found
+ */
+STATUS_ADXL Log_Resync(const uint8_t *data, uint32_t size, uint32_t *offset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_LOG_H */
@@ -0,0 +1,397 @@
+#if defined(ADXL_OS_PTHREAD) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L 	// pthread_mutex_timedlock and clock_gettime under -std=c11
+#endif
+
+#include "adxl_os.h"
+
+#if defined(ADXL_OS_FREERTOS) || defined(ADXL_OS_PTHREAD)
+
+/******************************************************************************************************************************************************************************/
+/*																				 OS Backends 																				  */
+/******************************************************************************************************************************************************************************/
+
+#if defined(ADXL_OS_FREERTOS)
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+typedef struct t_OsMutex
+{
+	StaticSemaphore_t buffer;
+	SemaphoreHandle_t handle;
+} t_OsMutex;
+
+static bool Os_Mutex_Init(t_OsMutex *mutex)
+{
+	mutex->handle = xSemaphoreCreateMutexStatic(&mutex->buffer); // FreeRTOS mutexes always use priority inheritance
+	return mutex->handle != NULL;
+}
+
+static bool Os_Mutex_Try(t_OsMutex *mutex)
+{
+	return xSemaphoreTake(mutex->handle, 0) == pdTRUE;
+}
+
+static bool Os_Mutex_Take(t_OsMutex *mutex, uint32_t timeout_ms)
+{
+	return xSemaphoreTake(mutex->handle, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+static void Os_Mutex_Give(t_OsMutex *mutex)
+{
+	xSemaphoreGive(mutex->handle);
+}
+
+static bool Os_In_Interrupt(void)
+{
+	return xPortIsInsideInterrupt() == pdTRUE;
+}
+
+typedef struct t_OsEvent
+{
+	StaticSemaphore_t buffer;
+	SemaphoreHandle_t handle;
+} t_OsEvent;
+
+static bool Os_Event_Init(t_OsEvent *event)
+{
+	event->handle = xSemaphoreCreateBinaryStatic(&event->buffer);
+	return event->handle != NULL;
+}
+
+static bool Os_Event_Wait(t_OsEvent *event, uint32_t timeout_ms)
+{
+	return xSemaphoreTake(event->handle, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+static void Os_Event_Give(t_OsEvent *event)
+{
+	BaseType_t woken = pdFALSE;
+	if (xPortIsInsideInterrupt() == pdTRUE)
+	{
+		xSemaphoreGiveFromISR(event->handle, &woken);
+		portYIELD_FROM_ISR(woken);
+	}
+	else
+	{
+		xSemaphoreGive(event->handle);
+	}
+}
+
+static uint32_t Os_Time_Ms(void)
+{
+	return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS);
+}
+
+#else
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+typedef struct t_OsMutex
+{
+	pthread_mutex_t handle;
+} t_OsMutex;
+
+static bool Os_Mutex_Init(t_OsMutex *mutex)
+{
+	pthread_mutexattr_t attr;
+	bool ok = false;
+	if (pthread_mutexattr_init(&attr) == 0)
+	{
+		pthread_mutexattr_setprotocol(&attr, PTHREAD_PRIO_INHERIT);
+		ok = pthread_mutex_init(&mutex->handle, &attr) == 0;
+		pthread_mutexattr_destroy(&attr);
+	}
+	return ok;
+}
+
+static bool Os_Mutex_Try(t_OsMutex *mutex)
+{
+	return pthread_mutex_trylock(&mutex->handle) == 0;
+}
+
+static bool Os_Mutex_Take(t_OsMutex *mutex, uint32_t timeout_ms)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	return pthread_mutex_timedlock(&mutex->handle, &deadline) == 0;
+}
+
+static void Os_Mutex_Give(t_OsMutex *mutex)
+{
+	pthread_mutex_unlock(&mutex->handle);
+}
+
+static bool Os_In_Interrupt(void)
+{
+	return false; // signal handlers are the only analogue, and the driver is not async-signal-safe anyway
+}
+
+typedef struct t_OsEvent
+{
+	sem_t handle;
+} t_OsEvent;
+
+static bool Os_Event_Init(t_OsEvent *event)
+{
+	return sem_init(&event->handle, 0, 0) == 0;
+}
+
+static bool Os_Event_Wait(t_OsEvent *event, uint32_t timeout_ms)
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L)
+	{
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+	return sem_timedwait(&event->handle, &deadline) == 0;
+}
+
+static void Os_Event_Give(t_OsEvent *event)
+{
+	int value = 0;
+	// Binary like the FreeRTOS semaphore: a release nobody waits for leaves at most one token
+	if (sem_getvalue(&event->handle, &value) != 0 || value == 0)
+	{
+		sem_post(&event->handle);
+	}
+}
+
+static uint32_t Os_Time_Ms(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
+
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				Bus Arbitration 																			  */
+/******************************************************************************************************************************************************************************/
+
+static t_OsMutex bus_mutex;
+static t_OsMutex gate_mutex; 		// held by a sample read from the moment it queues for the bus until it owns it
+static t_OsEvent async_released; 	// given whenever an interrupt-driven claim ends
+static volatile uint32_t sample_waiters = 0;
+static volatile uint32_t task_holds = 0; 	// a task owns bus_mutex
+static volatile uint32_t async_holds = 0; 	// an interrupt-driven operation owns the bus
+static t_BusStats bus_stats;
+
+/**
+ * @brief Function that waits, with bus_mutex held, until no interrupt-driven operation owns the bus. The flags are set before the other
+ * is read on both sides (sequentially consistent), so a task and a claim can never both proceed
+ *
+ * @param start Time the caller started waiting in ms
+ * @return bool false on timeout
+ */
+static bool Bus_Wait_Async(uint32_t start)
+{
+	bool free = true;
+	uint32_t elapsed = 0;
+	__atomic_store_n(&task_holds, 1, __ATOMIC_SEQ_CST);
+	while (free && __atomic_load_n(&async_holds, __ATOMIC_SEQ_CST) != 0)
+	{
+		elapsed = Os_Time_Ms() - start;
+		free = elapsed <= BUS_LOCK_TIMEOUT_MS && Os_Event_Wait(&async_released, BUS_LOCK_TIMEOUT_MS - elapsed);
+	}
+	if (!free)
+	{
+		__atomic_store_n(&task_holds, 0, __ATOMIC_SEQ_CST);
+	}
+	return free;
+}
+
+/**
+ * @brief Function that creates the bus lock. Call it once before any other task uses the sensor
+ *
+ * @return bool true on success
+ */
+bool Bus_Lock_Init(void)
+{
+	sample_waiters = 0;
+	task_holds = 0;
+	async_holds = 0;
+	bus_stats.transactions = 0;
+	bus_stats.contended = 0;
+	bus_stats.yielded = 0;
+	bus_stats.timeouts = 0;
+	bus_stats.refused = 0;
+	return Os_Mutex_Init(&bus_mutex) && Os_Mutex_Init(&gate_mutex) && Os_Event_Init(&async_released);
+}
+
+/**
+ * @brief Function that takes the bus for one transaction. Every wait blocks on a priority-inheriting mutex, so a low
+ * priority holder is boosted instead of spun on. Not callable from an interrupt handler
+ *
+ * @param priority Traffic class
+ * @return bool true if the bus was taken, false on timeout (BUS_LOCK_TIMEOUT_MS) or when called from an interrupt handler
+ */
+bool Bus_Lock(BUS_PRIORITY priority)
+{
+	bool taken = false;
+	bool failed = false;
+	bool contended = false;
+	uint32_t start = 0;
+	uint32_t elapsed = 0;
+
+	// A blocking take in an interrupt handler would stall the scheduler: the caller gets ERR_BUSY and must defer the read to a task
+	if (Os_In_Interrupt())
+	{
+		return false;
+	}
+	start = Os_Time_Ms();
+	if (priority == BUS_PRIORITY_SAMPLE)
+	{
+		__atomic_fetch_add(&sample_waiters, 1, __ATOMIC_ACQ_REL);
+		taken = Os_Mutex_Try(&bus_mutex);
+		if (!taken)
+		{
+			contended = true;
+			// Holding the gate while queued keeps configuration traffic from passing this read
+			if (Os_Mutex_Take(&gate_mutex, BUS_LOCK_TIMEOUT_MS))
+			{
+				elapsed = Os_Time_Ms() - start;
+				taken = elapsed <= BUS_LOCK_TIMEOUT_MS && Os_Mutex_Take(&bus_mutex, BUS_LOCK_TIMEOUT_MS - elapsed);
+				Os_Mutex_Give(&gate_mutex);
+			}
+		}
+		__atomic_fetch_sub(&sample_waiters, 1, __ATOMIC_ACQ_REL);
+	}
+	else
+	{
+		// Configuration traffic passes the gate first, so it blocks behind every queued sample read
+		while (!taken && !failed)
+		{
+			failed = !Os_Mutex_Take(&gate_mutex, BUS_LOCK_TIMEOUT_MS - elapsed);
+			if (!failed)
+			{
+				Os_Mutex_Give(&gate_mutex);
+				if (!Os_Mutex_Try(&bus_mutex))
+				{
+					contended = true;
+					elapsed = Os_Time_Ms() - start;
+					failed = elapsed > BUS_LOCK_TIMEOUT_MS || !Os_Mutex_Take(&bus_mutex, BUS_LOCK_TIMEOUT_MS - elapsed);
+				}
+			}
+			if (!failed && __atomic_load_n(&sample_waiters, __ATOMIC_ACQUIRE) != 0)
+			{
+				// A sample read queued between the gate and the take: give the bus back and wait at the gate again
+				bus_stats.yielded++;
+				contended = true;
+				Os_Mutex_Give(&bus_mutex);
+				elapsed = Os_Time_Ms() - start;
+				failed = elapsed > BUS_LOCK_TIMEOUT_MS;
+			}
+			else if (!failed)
+			{
+				taken = true;
+			}
+		}
+	}
+
+	// An interrupt-driven operation may still own the bus: wait for its release, keeping the mutex so nothing else passes meanwhile
+	if (taken && __atomic_load_n(&async_holds, __ATOMIC_SEQ_CST) != 0)
+	{
+		contended = true;
+	}
+	if (taken && !Bus_Wait_Async(start))
+	{
+		Os_Mutex_Give(&bus_mutex);
+		taken = false;
+	}
+
+	// Counters are only updated while the bus is held
+	if (taken)
+	{
+		__atomic_fetch_add(&bus_stats.transactions, 1, __ATOMIC_RELAXED);
+		if (contended)
+		{
+			bus_stats.contended++;
+		}
+	}
+	else
+	{
+		__atomic_fetch_add(&bus_stats.timeouts, 1, __ATOMIC_RELAXED);
+	}
+	return taken;
+}
+
+/**
+ * @brief Function that releases the bus
+ */
+void Bus_Unlock(void)
+{
+	__atomic_store_n(&task_holds, 0, __ATOMIC_SEQ_CST);
+	Os_Mutex_Give(&bus_mutex);
+}
+
+/**
+ * @brief Function that claims the bus for an interrupt-driven operation without waiting. Callable from a task or an interrupt handler
+ *
+ * @param priority Traffic class: a configuration claim also gives way to queued sample reads
+ * @return bool true if the bus was claimed, false if a task or another operation holds it
+ */
+bool Bus_Try_Lock_Async(BUS_PRIORITY priority)
+{
+	bool claimed = false;
+	if (priority == BUS_PRIORITY_CONFIG && __atomic_load_n(&sample_waiters, __ATOMIC_ACQUIRE) != 0)
+	{
+		claimed = false;
+	}
+	else if (__atomic_exchange_n(&async_holds, 1, __ATOMIC_SEQ_CST) != 0)
+	{
+		claimed = false;
+	}
+	else if (__atomic_load_n(&task_holds, __ATOMIC_SEQ_CST) != 0)
+	{
+		// A task owns the bus: back off, and wake it in case it saw the claim and started waiting
+		__atomic_store_n(&async_holds, 0, __ATOMIC_SEQ_CST);
+		Os_Event_Give(&async_released);
+	}
+	else
+	{
+		claimed = true;
+		__atomic_fetch_add(&bus_stats.transactions, 1, __ATOMIC_RELAXED);
+	}
+	if (!claimed)
+	{
+		__atomic_fetch_add(&bus_stats.refused, 1, __ATOMIC_RELAXED);
+	}
+	return claimed;
+}
+
+/**
+ * @brief Function that releases a claim of Bus_Try_Lock_Async, usually from the transfer complete or error interrupt
+ */
+void Bus_Unlock_Async(void)
+{
+	__atomic_store_n(&async_holds, 0, __ATOMIC_SEQ_CST);
+	Os_Event_Give(&async_released);
+}
+
+/**
+ * @brief Function that returns the arbitration counters
+ *
+ * @param stats Pointer to the counters
+ */
+void Bus_Get_Stats(t_BusStats *stats)
+{
+	*stats = bus_stats;
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef ADXL_OS_H
+#define ADXL_OS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Bus arbitration backend, selected at compile time:
+ *	ADXL_OS_FREERTOS	FreeRTOS mutex (priority inheritance), static allocation
+ *	ADXL_OS_PTHREAD		POSIX mutex with PTHREAD_PRIO_INHERIT (host builds and tests)
+ *	none				bare metal, the lock compiles to nothing
+ *
+ * Every SPI transaction of adxl.c (Register_Write, Read_Byte, Read_6Bytes, Read_Registers) holds the lock for exactly
+ * one transaction, so the hold time is bounded by the longest transfer. Sample traffic has priority: a sample read that
+ * has to wait holds a second mutex, the gate, until it owns the bus, and configuration traffic passes the gate before
+ * queueing for the bus. Both waits block on priority-inheriting mutexes.
+ *
+ * The lock is for tasks only. Called from an interrupt handler, Bus_Lock fails at once and the driver returns ERR_BUSY.
+ *
+ * Interrupt-driven transfers (adxl_async.c) start and complete outside any task, so they cannot own a mutex. They claim
+ * the bus with Bus_Try_Lock_Async, which never waits and works in interrupt context, and release it from the completion
+ * handler. A task that takes the bus mutex while such a claim is held waits on a semaphore the release gives.
+ */
+
+#ifndef BUS_LOCK_TIMEOUT_MS
+#define BUS_LOCK_TIMEOUT_MS 		10
+#endif
+
+typedef enum BUS_PRIORITY
+{
+	BUS_PRIORITY_CONFIG = 0, 		// configuration and identification traffic
+	BUS_PRIORITY_SAMPLE 			// data, INT_SOURCE and FIFO_STATUS reads
+} BUS_PRIORITY;
+
+typedef struct t_BusStats
+{
+	uint32_t transactions;
+	uint32_t contended; 			// acquisitions that had to wait
+	uint32_t yielded; 				// configuration acquisitions that gave way to sample reads
+	uint32_t timeouts;
+	uint32_t refused; 				// interrupt-driven claims that found the bus held
+} t_BusStats;
+
+/******************************************************************************************************************************************************************************/
+/*																				Bus Arbitration 																			  */
+/******************************************************************************************************************************************************************************/
+
+#if defined(ADXL_OS_FREERTOS) || defined(ADXL_OS_PTHREAD)
+
+/**
+ * @brief Function that creates the bus lock. Call it once before any other task uses the sensor
+ *
+ * @return bool true on success
+ */
+bool Bus_Lock_Init(void);
+
+/**
+ * @brief Function that takes the bus for one transaction. Every wait blocks on a priority-inheriting mutex, so a low
+ * priority holder is boosted instead of spun on. Not callable from an interrupt handler
+ *
+ * @param priority Traffic class
+ * @return bool true if the bus was taken, false on timeout (BUS_LOCK_TIMEOUT_MS) or when called from an interrupt handler
+ */
+bool Bus_Lock(BUS_PRIORITY priority);
+
+/**
+ * @brief Function that releases the bus
+ */
+void Bus_Unlock(void);
+
+/**
+ * @brief Function that claims the bus for an interrupt-driven operation without waiting. Callable from a task or an interrupt handler
+ *
+ * @param priority Traffic class: a configuration claim also gives way to queued sample reads
+ * @return bool true if the bus was claimed, false if a task or another operation holds it
+ */
+bool Bus_Try_Lock_Async(BUS_PRIORITY priority);
+
+/**
+ * @brief Function that releases a claim of Bus_Try_Lock_Async, usually from the transfer complete or error interrupt
+ */
+void Bus_Unlock_Async(void);
+
+/**
+ * @brief Function that returns the arbitration counters
+ *
+ * @param stats Pointer to the counters
+ */
+void Bus_Get_Stats(t_BusStats *stats);
+
+#else
+
+static inline bool Bus_Lock_Init(void)
+{
+	return true;
+}
+
+static inline bool Bus_Lock(BUS_PRIORITY priority)
+{
+	(void)priority;
+	return true;
+}
+
+static inline void Bus_Unlock(void)
+{
+}
+
+static inline bool Bus_Try_Lock_Async(BUS_PRIORITY priority)
+{
+	(void)priority;
+	return true;
+}
+
+static inline void Bus_Unlock_Async(void)
+{
+}
+
+static inline void Bus_Get_Stats(t_BusStats *stats)
+{
+	stats->transactions = 0;
+	stats->contended = 0;
+	stats->yielded = 0;
+	stats->timeouts = 0;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_OS_H */
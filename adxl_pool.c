@@ -0,0 +1,159 @@
+#include "adxl_pool.h"
+#include <assert.h>
+#include <stddef.h>
+
+/******************************************************************************************************************************************************************************/
+/*																				Block Pool 																					  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a pool with every block free
+ *
+ * @param pool Pointer to the pool (usually static)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Pool_Init(t_Pool *pool)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t i = 0;
+	for (i = 0; i < POOL_BLOCKS; i++)
+	{
+		pool->blocks[i].id = i;
+		pool->blocks[i].references = 0;
+		pool->blocks[i].block.samples = pool->blocks[i].data;
+		pool->blocks[i].block.count = 0;
+	}
+	pool->exhausted = 0;
+	pool->in_use_max = 0;
+	__atomic_store_n(&pool->free_mask, (POOL_BLOCKS == 32) ? 0xFFFFFFFFUL : ((1UL << POOL_BLOCKS) - 1), __ATOMIC_RELEASE);
+	return ret_val;
+}
+
+/**
+ * @brief Function that takes a free block with one reference. Lock-free, callable from interrupts
+ *
+ * @param pool Pointer to the pool
+ * @param block Pointer to the block pointer
+ * @return STATUS_ADXL ERR_NO_BUFFER if the pool is exhausted (counted in pool->exhausted)
+ */
+STATUS_ADXL Pool_Alloc(t_Pool *pool, t_PoolBlock **block)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint32_t mask = __atomic_load_n(&pool->free_mask, __ATOMIC_ACQUIRE);
+	uint32_t in_use = 0;
+	uint32_t max = 0;
+	uint8_t bit = 0;
+	*block = NULL;
+	do
+	{
+		if (mask == 0)
+		{
+			break;
+		}
+		bit = (uint8_t)__builtin_ctz(mask);
+	} while (!__atomic_compare_exchange_n(&pool->free_mask, &mask, mask & ~(1UL << bit), true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	if (mask == 0)
+	{
+		__atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+		ret_val = ERR_NO_BUFFER;
+	}
+	else
+	{
+		*block = &pool->blocks[bit];
+		__atomic_store_n(&(*block)->references, 1, __ATOMIC_RELAXED);
+		// High-water mark, for sizing POOL_BLOCKS
+		in_use = POOL_BLOCKS - (uint32_t)__builtin_popcount(__atomic_load_n(&pool->free_mask, __ATOMIC_RELAXED));
+		max = __atomic_load_n(&pool->in_use_max, __ATOMIC_RELAXED);
+		while (in_use > max && !__atomic_compare_exchange_n(&pool->in_use_max, &max, in_use, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that drains FIFO entries directly into a block. Only samples and count are set: hand &block->block to
+ * Stream_Push_Block for numbering, timestamps and gap accounting
+ *
+ * @param spi SPI interface
+ * @param block Pointer to the block
+ * @param count Number of entries (at most POOL_BLOCK_SAMPLES)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Pool_Read_FIFO(SPI_HandleTypeDef *spi, t_PoolBlock *block, uint8_t count)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (count > POOL_BLOCK_SAMPLES)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else if (Read_FIFO(spi, block->data, count))
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		block->block.count = count;
+		block->block.samples = block->data;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that adds a reference before a block is handed to one more consumer
+ *
+ * @param block Pointer to the block
+ */
+void Pool_Retain(t_PoolBlock *block)
+{
+	__atomic_fetch_add(&block->references, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Function that drops a reference. The last one returns the block to the pool. Lock-free, callable from interrupts.
+ * Releasing a free block is a bug in the caller: it asserts, and with NDEBUG it is ignored
+ *
+ * @param pool Pointer to the pool
+ * @param block Pointer to the block
+ * @return STATUS_ADXL ERR_PARAM if the block had no reference left
+ */
+STATUS_ADXL Pool_Release(t_Pool *pool, t_PoolBlock *block)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint32_t references = __atomic_load_n(&block->references, __ATOMIC_RELAXED);
+	uint32_t mask = 0;
+	// Never below zero: a double release must not free the block under its new owner
+	do
+	{
+		if (references == 0)
+		{
+			break;
+		}
+	} while (!__atomic_compare_exchange_n(&block->references, &references, references - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	if (references == 0)
+	{
+		assert(references != 0 && "Pool_Release of a free block");
+		ret_val = ERR_PARAM;
+	}
+	else if (references == 1)
+	{
+		mask = __atomic_fetch_or(&pool->free_mask, 1UL << block->id, __ATOMIC_RELEASE);
+		assert((mask & (1UL << block->id)) == 0 && "Pool_Release: block already in the free mask");
+		(void)mask;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that returns the pool block that owns a sample block handed to a consumer
+ *
+ * @param block Pointer to the sample block. Only valid for &t_PoolBlock.block as pushed with Stream_Push_Block: blocks delivered by
+ * Stream_Push or a replay are not pool blocks
+ * @return t_PoolBlock*
+ */
+t_PoolBlock *Pool_From_Block(const t_SampleBlock *block)
+{
+	return (t_PoolBlock *)((uint8_t *)block - offsetof(t_PoolBlock, block));
+}
@@ -0,0 +1,102 @@
+#ifndef ADXL_POOL_H
+#define ADXL_POOL_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef POOL_BLOCKS
+#define POOL_BLOCKS 				8 		// number of blocks (1-32)
+#endif
+
+#ifndef POOL_BLOCK_SAMPLES
+#define POOL_BLOCK_SAMPLES 			FIFO_SIZE // samples per block, one full FIFO drain
+#endif
+
+typedef struct t_PoolBlock
+{
+	t_SampleBlock block; 			// header handed to consumers, block.samples points to data
+	t_Sample data[POOL_BLOCK_SAMPLES];
+	volatile uint32_t references;
+	uint8_t id;
+} t_PoolBlock;
+
+typedef struct t_Pool
+{
+	t_PoolBlock blocks[POOL_BLOCKS];
+	volatile uint32_t free_mask; 	// bit i set: blocks[i] is free
+	volatile uint32_t exhausted; 	// failed allocations
+	volatile uint32_t in_use_max; 	// high-water mark of allocated blocks
+} t_Pool;
+
+/******************************************************************************************************************************************************************************/
+/*																				Block Pool 																					  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a pool with every block free
+ *
+ * @param pool Pointer to the pool (usually static)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Pool_Init(t_Pool *pool);
+
+/**
+ * @brief Function that takes a free block with one reference. Lock-free, callable from interrupts
+ *
+ * @param pool Pointer to the pool
+ * @param block Pointer to the block pointer
+ * @return STATUS_ADXL ERR_NO_BUFFER if the pool is exhausted (counted in pool->exhausted)
+ */
+STATUS_ADXL Pool_Alloc(t_Pool *pool, t_PoolBlock **block);
+
+/**
+ * @brief Function that drains FIFO entries directly into a block. Only samples and count are set: hand &block->block to
+ * Stream_Push_Block for numbering, timestamps and gap accounting
+ *
+ * @param spi SPI interface
+ * @param block Pointer to the block
+ * @param count Number of entries (at most POOL_BLOCK_SAMPLES)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Pool_Read_FIFO(SPI_HandleTypeDef *spi, t_PoolBlock *block, uint8_t count);
+
+/**
+ * @brief Function that adds a reference before a block is handed to one more consumer
+ *
+ * @param block Pointer to the block
+ */
+void Pool_Retain(t_PoolBlock *block);
+
+/**
+ * @brief Function that drops a reference. The last one returns the block to the pool. Lock-free, callable from interrupts.
+ * Releasing a free block is a bug in the caller: it asserts, and with NDEBUG it is ignored
+ *
+ * @param pool Pointer to the pool
+ * @param block Pointer to the block
+ * @return STATUS_ADXL ERR_PARAM if the block had no reference left
+ */
+STATUS_ADXL Pool_Release(t_Pool *pool, t_PoolBlock *block);
+
+/**
+ * @brief Function that returns the pool block that owns a sample block handed to a consumer
+ *
+ * @param block Pointer to the sample block. Only valid for &t_PoolBlock.block as pushed with Stream_Push_Block: blocks delivered by
+ * Stream_Push or a replay are not pool blocks
+ * @return t_PoolBlock*
+ */
+t_PoolBlock *Pool_From_Block(const t_SampleBlock *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_POOL_H */
@@ -0,0 +1,348 @@
+#include "adxl_power.h"
+#include <math.h>
+
+/******************************************************************************************************************************************************************************/
+/*																				Power Model 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that loads the default model: typical ADXL313 datasheet currents at 3.3 V and indicative MCU/SPI energies.
+ * Replace the MCU, SPI and noise figures with values measured on the actual board
+ *
+ * @param model Pointer to the model
+ */
+void Power_Default_Model(t_PowerModel *model)
+{
+	// 6.25, 12.5, 25, 50, 100, 200, 400, 800, 1600, 3200 Hz ODR
+	static const float normal[POWER_RATES] = {57.0f, 65.0f, 82.0f, 115.0f, 170.0f, 170.0f, 170.0f, 170.0f, 115.0f, 170.0f};
+	static const float low_power[POWER_RATES] = {0.0f, 55.0f, 57.0f, 65.0f, 82.0f, 115.0f, 170.0f, 0.0f, 0.0f, 0.0f};
+	static const float sleep[4] = {40.0f, 33.0f, 30.0f, 28.0f};
+	uint8_t i = 0;
+	model->supply = 3.3f;
+	for (i = 0; i < POWER_RATES; i++)
+	{
+		model->normal_ua[i] = normal[i];
+		model->low_power_ua[i] = low_power[i];
+	}
+	for (i = 0; i < 4; i++)
+	{
+		model->sleep_ua[i] = sleep[i];
+	}
+	model->noise_density_ug = 250.0f;
+	model->low_power_noise_factor = 1.5f;
+	model->wake_uj = 5.0f;
+	model->spi_sample_uj = 0.5f;
+	model->spi_status_uj = 0.2f;
+}
+
+/**
+ * @brief Function that returns the modeled average power of a configuration
+ *
+ * @param model Pointer to the model
+ * @param rate Rate code (BANDWIDTH)
+ * @param low_power LOW_POWER bit
+ * @param watermark FIFO samples per interrupt (1: one interrupt per sample)
+ * @return float uW, negative if the combination is not available
+ */
+float Power_Estimate(const t_PowerModel *model, uint8_t rate, bool low_power, uint8_t watermark)
+{
+	float current = 0.0f;
+	float odr = 0.0f;
+	float wakeups = 0.0f;
+	if (rate < BW_3_125_Hz || rate > BW_1600_Hz || watermark == 0 || watermark >= FIFO_SIZE)
+	{
+		return -1.0f;
+	}
+	current = low_power ? model->low_power_ua[rate - BW_3_125_Hz] : model->normal_ua[rate - BW_3_125_Hz];
+	if (current <= 0.0f)
+	{
+		return -1.0f;
+	}
+	odr = 1e9f / (float)Sample_Period_Ns(rate);
+	wakeups = odr / watermark;
+	// uA * V = uW; uJ per event * events per second = uW
+	return current * model->supply + wakeups * (model->wake_uj + model->spi_status_uj) + odr * model->spi_sample_uj;
+}
+
+/**
+ * @brief Function that fills the modeled power of a configuration: measuring power while active, sleep or measuring power at rest,
+ * and their average weighted by the activity fraction
+ *
+ * @param model Pointer to the model
+ * @param activity Fraction of the time in motion (0 to 1)
+ * @param config Pointer to the configuration (rate, low_power, watermark, auto_sleep and sleep_rate set)
+ * @return STATUS_ADXL ERR_PARAM if the combination is not available
+ */
+STATUS_ADXL Power_Evaluate(const t_PowerModel *model, float activity, t_PowerConfig *config)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	config->active_uw = Power_Estimate(model, config->rate, config->low_power, config->watermark);
+	config->inactive_uw = config->active_uw;
+	config->power_uw = -1.0f;
+	if (config->active_uw < 0.0f || config->sleep_rate > FREC_1HZ || !(activity >= 0.0f && activity <= 1.0f))
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		// Asleep the sensor only checks for activity at the wake-up rate and raises no data interrupt, so the MCU stays asleep too
+		if (config->auto_sleep)
+		{
+			config->inactive_uw = model->sleep_ua[config->sleep_rate] * model->supply;
+		}
+		config->power_uw = activity * config->active_uw + (1.0f - activity) * config->inactive_uw;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that searches every rate, power mode, watermark and sleep choice (measure at rest, or auto-sleep at each wake-up rate)
+ * for the configuration with the lowest energy at the required activity fraction
+ *
+ * @param model Pointer to the model
+ * @param requirement Pointer to the requirement
+ * @param config Pointer to the best configuration
+ * @return STATUS_ADXL ERR_PARAM if no configuration meets the requirement
+ */
+STATUS_ADXL Power_Optimize(const t_PowerModel *model, const t_PowerRequirement *requirement, t_PowerConfig *config)
+{
+	STATUS_ADXL ret_val = ERR_PARAM;
+	t_PowerConfig candidate;
+	uint8_t rate = 0;
+	uint8_t mode = 0;
+	uint8_t watermark = 0;
+	uint8_t sleep = 0;
+	float odr = 0.0f;
+	float noise = 0.0f;
+	config->power_uw = -1.0f;
+
+	for (rate = BW_3_125_Hz; rate <= BW_1600_Hz; rate++)
+	{
+		odr = 1e9f / (float)Sample_Period_Ns(rate);
+		if (odr / 2.0f < requirement->bandwidth_hz)
+		{
+			continue;
+		}
+		for (mode = 0; mode < 2; mode++)
+		{
+			noise = model->noise_density_ug * sqrtf(odr / 2.0f) * (mode ? model->low_power_noise_factor : 1.0f);
+			if (noise > requirement->noise_ug)
+			{
+				continue;
+			}
+			// The oldest sample of a FIFO batch waits watermark periods before the interrupt
+			for (watermark = 1; watermark < FIFO_SIZE && (float)watermark / odr <= requirement->latency_s; watermark++)
+			{
+				// Choice 0 keeps measuring at rest; choice n auto-sleeps at HZ_SLEEP_MODE n - 1, which notices motion within one wake-up period
+				for (sleep = 0; sleep <= FREC_1HZ + 1; sleep++)
+				{
+					if (sleep != 0 && (float)(1U << (sleep - 1)) / 8.0f > requirement->wake_s)
+					{
+						continue;
+					}
+					candidate.rate = rate;
+					candidate.low_power = mode;
+					candidate.watermark = watermark;
+					candidate.auto_sleep = sleep != 0;
+					candidate.sleep_rate = sleep != 0 ? sleep - 1 : FREC_8HZ;
+					if (Power_Evaluate(model, requirement->activity, &candidate) == STATUS_OK_ADXL &&
+						(config->power_uw < 0.0f || candidate.power_uw < config->power_uw ||
+						 (candidate.power_uw == config->power_uw && candidate.active_uw < config->active_uw)))
+					{
+						*config = candidate;
+						ret_val = STATUS_OK_ADXL;
+					}
+				}
+			}
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that estimates battery life for a recorded activity profile, repeated until the battery is empty
+ *
+ * @param model Pointer to the model
+ * @param config Configuration, evaluated by Power_Evaluate or Power_Optimize
+ * @param profile Pointer to the activity segments
+ * @param count Number of segments
+ * @param capacity_mah Battery capacity
+ * @return float Battery life in hours, 0 if the configuration is not available or the profile is empty
+ */
+float Power_Battery_Life(const t_PowerModel *model, const t_PowerConfig *config, const t_PowerSegment *profile, uint16_t count, float capacity_mah)
+{
+	float energy_uj = 0.0f;
+	float duration_s = 0.0f;
+	uint16_t i = 0;
+	if (config->power_uw < 0.0f || config->active_uw < 0.0f || config->inactive_uw < 0.0f)
+	{
+		return 0.0f;
+	}
+	for (i = 0; i < count; i++)
+	{
+		energy_uj += profile[i].duration_s * (profile[i].active ? config->active_uw : config->inactive_uw);
+		duration_s += profile[i].duration_s;
+	}
+	if (energy_uj <= 0.0f || duration_s <= 0.0f)
+	{
+		return 0.0f;
+	}
+	// mAh * V = mWh = 1000 uWh, divided by the average power in uW
+	return capacity_mah * model->supply * 1000.0f / (energy_uj / duration_s);
+}
+
+/******************************************************************************************************************************************************************************/
+/*																			Activity Profile 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that ends the open segment and starts the next one at a time
+ *
+ * @param profile Pointer to the profile
+ * @param time Time in us
+ */
+static void Power_Profile_Close(t_PowerProfile *profile, uint64_t time)
+{
+	float duration = (float)(time - profile->start) * 1e-6f;
+	if (profile->count < profile->size)
+	{
+		profile->segments[profile->count].duration_s = duration;
+		profile->segments[profile->count].active = profile->active;
+		profile->count++;
+	}
+	else
+	{
+		profile->segments[profile->size - 1].duration_s += duration;
+		profile->merged++;
+	}
+	profile->start = time;
+}
+
+/**
+ * @brief Function that returns true if a sample is outside the threshold around the reference on any axis
+ *
+ * @param profile Pointer to the profile
+ * @param sample Pointer to the sample
+ * @return bool
+ */
+static bool Power_Profile_Moved(const t_PowerProfile *profile, const t_Sample *sample)
+{
+	int32_t delta[3] = {sample->x - profile->reference[0], sample->y - profile->reference[1], sample->z - profile->reference[2]};
+	uint8_t axis = 0;
+	bool moved = false;
+	for (axis = 0; axis < 3; axis++)
+	{
+		moved = moved || delta[axis] > (int32_t)profile->threshold || -delta[axis] > (int32_t)profile->threshold;
+	}
+	return moved;
+}
+
+/**
+ * @brief Function that prepares an activity profile. Samples move it to motion when an axis leaves the threshold around the reference,
+ * and to rest after inactive_samples within it, the way the sensor's AC-coupled activity and inactivity detection would
+ *
+ * @param profile Pointer to the profile
+ * @param segments Pointer to the segment array
+ * @param size Number of segments of the array. When it is full the last segment absorbs the rest of the recording
+ * @param threshold Activity threshold in LSB of the recorded samples
+ * @param inactive_samples Samples within the threshold before rest
+ * @return STATUS_ADXL ERR_PARAM if the array is empty
+ */
+STATUS_ADXL Power_Profile_Init(t_PowerProfile *profile, t_PowerSegment *segments, uint16_t size, uint16_t threshold, uint32_t inactive_samples)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t axis = 0;
+	if (segments == NULL || size == 0)
+	{
+		ret_val = ERR_PARAM;
+	}
+	profile->segments = segments;
+	profile->size = size;
+	profile->count = 0;
+	profile->threshold = threshold;
+	profile->inactive_samples = inactive_samples;
+	for (axis = 0; axis < 3; axis++)
+	{
+		profile->reference[axis] = 0;
+	}
+	profile->quiet = 0;
+	profile->start = 0;
+	profile->last_time = 0;
+	profile->active = false;
+	profile->started = false;
+	profile->merged = 0;
+	return ret_val;
+}
+
+/**
+ * @brief Function that adds a block of samples to the profile. It has the t_StreamSink on_block signature, so a live stream or
+ * Replay_Run of a recording can feed it directly with the profile as argument
+ *
+ * @param block Pointer to the block
+ * @param arg Pointer to the profile
+ */
+void Power_Profile_Block(const t_SampleBlock *block, void *arg)
+{
+	t_PowerProfile *profile = (t_PowerProfile *)arg;
+	const t_Sample *sample = NULL;
+	uint64_t time = 0;
+	uint16_t i = 0;
+	if (profile->size == 0)
+	{
+		return;
+	}
+	for (i = 0; i < block->count; i++)
+	{
+		sample = &block->samples[i];
+		time = block->timestamp + ((uint64_t)i * block->period) / 1000;
+		// The recording starts measuring, so it starts in motion until the first rest
+		if (!profile->started)
+		{
+			profile->started = true;
+			profile->active = true;
+			profile->start = time;
+			profile->quiet = 0;
+			profile->reference[0] = sample->x;
+			profile->reference[1] = sample->y;
+			profile->reference[2] = sample->z;
+		}
+		if (Power_Profile_Moved(profile, sample))
+		{
+			profile->reference[0] = sample->x;
+			profile->reference[1] = sample->y;
+			profile->reference[2] = sample->z;
+			profile->quiet = 0;
+			if (!profile->active)
+			{
+				Power_Profile_Close(profile, time);
+				profile->active = true;
+			}
+		}
+		else if (profile->active && ++profile->quiet >= profile->inactive_samples)
+		{
+			// At rest the reference is the resting position, as the sensor takes it when activity detection starts
+			Power_Profile_Close(profile, time);
+			profile->active = false;
+			profile->reference[0] = sample->x;
+			profile->reference[1] = sample->y;
+			profile->reference[2] = sample->z;
+		}
+		profile->last_time = time + block->period / 1000;
+	}
+}
+
+/**
+ * @brief Function that closes the open segment
+ *
+ * @param profile Pointer to the profile
+ * @return uint16_t Number of segments
+ */
+uint16_t Power_Profile_Finish(t_PowerProfile *profile)
+{
+	if (profile->started && profile->size != 0)
+	{
+		Power_Profile_Close(profile, profile->last_time);
+		profile->started = false;
+	}
+	return profile->count;
+}
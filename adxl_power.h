@@ -0,0 +1,168 @@
+#ifndef ADXL_POWER_H
+#define ADXL_POWER_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define POWER_RATES 				10 		// rate codes 0x06 (6.25 Hz ODR) to 0x0F (3200 Hz ODR)
+
+typedef struct t_PowerModel
+{
+	float supply; 					// V
+	float normal_ua[POWER_RATES]; 	// sensor current in measurement mode, index rate - BW_3_125_Hz
+	float low_power_ua[POWER_RATES]; // sensor current with LOW_POWER set, 0 where the mode is not available
+	float sleep_ua[4]; 				// sensor current in sleep mode, index HZ_SLEEP_MODE
+	float noise_density_ug; 		// ug/sqrt(Hz), normal mode
+	float low_power_noise_factor; 	// noise increase with LOW_POWER set
+	float wake_uj; 					// MCU energy of one interrupt wake-up (entry, service, back to sleep)
+	float spi_sample_uj; 			// energy of one Read_6Bytes transaction (MCU + bus)
+	float spi_status_uj; 			// energy of one single-byte status read
+} t_PowerModel;
+
+typedef struct t_PowerRequirement
+{
+	float bandwidth_hz; 			// minimum signal bandwidth
+	float latency_s; 				// maximum age of a sample when the MCU reads it
+	float noise_ug; 				// maximum RMS noise over the bandwidth
+	float activity; 				// fraction of the time in motion (0 to 1): weighs the measuring and the inactive power
+	float wake_s; 					// maximum delay to notice motion while asleep, 0 never lets the sensor auto-sleep
+} t_PowerRequirement;
+
+typedef struct t_PowerConfig
+{
+	uint8_t rate; 					// BANDWIDTH
+	bool low_power;
+	uint8_t watermark; 				// FIFO samples per interrupt, 1 means DATA_READY per sample
+	bool auto_sleep; 				// sleep while inactive (AUTO_SLEEP with LINK), otherwise keep measuring
+	uint8_t sleep_rate; 			// HZ_SLEEP_MODE while asleep
+	float active_uw; 				// modeled power while in motion
+	float inactive_uw; 				// modeled power while at rest
+	float power_uw; 				// average weighted by the activity fraction, negative if the configuration is not available
+} t_PowerConfig;
+
+typedef struct t_PowerSegment
+{
+	float duration_s;
+	bool active; 					// true: in motion, measuring; false: at rest, asleep if the configuration auto-sleeps
+} t_PowerSegment;
+
+typedef struct t_PowerProfile
+{
+	t_PowerSegment *segments; 		// caller-provided array
+	uint16_t size;
+	uint16_t count;
+	uint16_t threshold; 			// activity threshold in LSB, AC coupled like THRESH_ACT
+	uint32_t inactive_samples; 		// samples within the threshold before rest, like TIME_INACT x ODR
+	int16_t reference[3]; 			// AC reference, taken at the last sample over the threshold
+	uint32_t quiet; 				// consecutive samples within the threshold
+	uint64_t start; 				// time of the open segment in us
+	uint64_t last_time; 			// time of the last sample in us
+	bool active;
+	bool started;
+	uint32_t merged; 				// transitions lost because the array was full
+} t_PowerProfile;
+
+/******************************************************************************************************************************************************************************/
+/*																				Power Model 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that loads the default model: typical ADXL313 datasheet currents at 3.3 V and indicative MCU/SPI energies.
+ * Replace the MCU, SPI and noise figures with values measured on the actual board
+ *
+ * @param model Pointer to the model
+ */
+void Power_Default_Model(t_PowerModel *model);
+
+/**
+ * @brief Function that returns the modeled average power of a configuration
+ *
+ * @param model Pointer to the model
+ * @param rate Rate code (BANDWIDTH)
+ * @param low_power LOW_POWER bit
+ * @param watermark FIFO samples per interrupt (1: one interrupt per sample)
+ * @return float uW, negative if the combination is not available
+ */
+float Power_Estimate(const t_PowerModel *model, uint8_t rate, bool low_power, uint8_t watermark);
+
+/**
+ * @brief Function that fills the modeled power of a configuration: measuring power while active, sleep or measuring power at rest,
+ * and their average weighted by the activity fraction
+ *
+ * @param model Pointer to the model
+ * @param activity Fraction of the time in motion (0 to 1)
+ * @param config Pointer to the configuration (rate, low_power, watermark, auto_sleep and sleep_rate set)
+ * @return STATUS_ADXL ERR_PARAM if the combination is not available
+ */
+STATUS_ADXL Power_Evaluate(const t_PowerModel *model, float activity, t_PowerConfig *config);
+
+/**
+ * @brief Function that searches every rate, power mode, watermark and sleep choice (measure at rest, or auto-sleep at each wake-up rate)
+ * for the configuration with the lowest energy at the required activity fraction
+ *
+ * @param model Pointer to the model
+ * @param requirement Pointer to the requirement
+ * @param config Pointer to the best configuration
+ * @return STATUS_ADXL ERR_PARAM if no configuration meets the requirement
+ */
+STATUS_ADXL Power_Optimize(const t_PowerModel *model, const t_PowerRequirement *requirement, t_PowerConfig *config);
+
+/**
+ * @brief Function that estimates battery life for a recorded activity profile, repeated until the battery is empty
+ *
+ * @param model Pointer to the model
+ * @param config Configuration, evaluated by Power_Evaluate or Power_Optimize
+ * @param profile Pointer to the activity segments
+ * @param count Number of segments
+ * @param capacity_mah Battery capacity
+ * @return float Battery life in hours, 0 if the configuration is not available or the profile is empty
+ */
+float Power_Battery_Life(const t_PowerModel *model, const t_PowerConfig *config, const t_PowerSegment *profile, uint16_t count, float capacity_mah);
+
+/******************************************************************************************************************************************************************************/
+/*																			Activity Profile 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that prepares an activity profile. Samples move it to motion when an axis leaves the threshold around the reference,
+ * and to rest after inactive_samples within it, the way the sensor's AC-coupled activity and inactivity detection would
+ *
+ * @param profile Pointer to the profile
+ * @param segments Pointer to the segment array
+ * @param size Number of segments of the array. When it is full the last segment absorbs the rest of the recording
+ * @param threshold Activity threshold in LSB of the recorded samples
+ * @param inactive_samples Samples within the threshold before rest
+ * @return STATUS_ADXL ERR_PARAM if the array is empty
+ */
+STATUS_ADXL Power_Profile_Init(t_PowerProfile *profile, t_PowerSegment *segments, uint16_t size, uint16_t threshold, uint32_t inactive_samples);
+
+/**
+ * @brief Function that adds a block of samples to the profile. It has the t_StreamSink on_block signature, so a live stream or
+ * Replay_Run of a recording can feed it directly with the profile as argument
+ *
+ * @param block Pointer to the block
+ * @param arg Pointer to the profile
+ */
+void Power_Profile_Block(const t_SampleBlock *block, void *arg);
+
+/**
+ * @brief Function that closes the open segment
+ *
+ * @param profile Pointer to the profile
+ * @return uint16_t Number of segments
+ */
+uint16_t Power_Profile_Finish(t_PowerProfile *profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_POWER_H */
@@ -0,0 +1,297 @@
+#include "adxl_replay.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that parses the block at an offset, skipping forward to the next valid block if the data is corrupted
+ *
+ * @param replay Pointer to the replay
+ * @param offset Pointer to the offset, updated with the offset of the valid block
+ * @param header Pointer to the header
+ * @param length Pointer to the length of the block
+ * @return STATUS_ADXL ERR_READING at the end of the recording
+ */
+static STATUS_ADXL Replay_Block_At(t_Replay *replay, uint32_t *offset, t_LogHeader *header, uint32_t *length)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (*offset >= replay->size)
+	{
+		ret_val = ERR_READING;
+	}
+	else if (Log_Parse_Block(&replay->data[*offset], replay->size - *offset, header, length))
+	{
+		replay->corrupted++;
+		*offset += 1;
+		if (Log_Resync(replay->data, replay->size, offset))
+		{
+			*offset = replay->size;
+			ret_val = ERR_READING;
+		}
+		else
+		{
+			ret_val = Log_Parse_Block(&replay->data[*offset], replay->size - *offset, header, length);
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that returns the last index entry that does not start after a key
+ *
+ * @param replay Pointer to the replay
+ * @param key Sequence number or time
+ * @param by_time true to search by time
+ * @return int32_t Entry position, -1 if the key is before the first entry
+ */
+static int32_t Replay_Search(const t_Replay *replay, uint64_t key, bool by_time)
+{
+	int32_t low = 0;
+	int32_t high = (int32_t)replay->index_count - 1;
+	int32_t found = -1;
+	int32_t mid = 0;
+	uint64_t value = 0;
+	while (low <= high)
+	{
+		mid = low + (high - low) / 2;
+		value = by_time ? replay->index[mid].timestamp : replay->index[mid].sequence;
+		if (value <= key)
+		{
+			found = mid;
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+	return found;
+}
+
+/**
+ * @brief Function that seeks with the index and then walks at most stride blocks
+ *
+ * @param replay Pointer to the replay
+ * @param key Sequence number or time
+ * @param by_time true to search by time
+ * @return STATUS_ADXL
+ */
+static STATUS_ADXL Replay_Seek(t_Replay *replay, uint64_t key, bool by_time)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_LogHeader header;
+	uint32_t length = 0;
+	uint32_t offset = 0;
+	uint64_t end = 0;
+	int32_t entry = Replay_Search(replay, key, by_time);
+	if (entry < 0)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		offset = replay->index[entry].offset;
+		while ((ret_val = Replay_Block_At(replay, &offset, &header, &length)) == STATUS_OK_ADXL)
+		{
+			if (by_time)
+			{
+				end = header.timestamp + ((uint64_t)header.count * Sample_Period_Ns(header.bw_rate)) / 1000;
+			}
+			else
+			{
+				end = header.sequence + header.count;
+			}
+			if (key < end)
+			{
+				break;
+			}
+			offset += length;
+		}
+		replay->offset = offset;
+	}
+	return ret_val;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Indexed Replay 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that scans a recording (headers and CRC only) and builds a sparse index. The stride doubles whenever the index is full,
+ * so any recording fits in index_size entries, and a seek walks up to stride blocks after the search
+ *
+ * @param replay Pointer to the replay
+ * @param data Pointer to the recording (adxl_log.h block format)
+ * @param size Size of the recording
+ * @param index Pointer to the index array
+ * @param index_size Number of entries of the index array (at least 2)
+ * @return STATUS_ADXL ERR_READING if the recording has no valid block
+ */
+STATUS_ADXL Replay_Open(t_Replay *replay, const uint8_t *data, uint32_t size, t_ReplayEntry *index, uint32_t index_size)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_LogHeader header;
+	uint32_t length = 0;
+	uint32_t offset = 0;
+	uint32_t i = 0;
+
+	replay->data = data;
+	replay->size = size;
+	replay->index = index;
+	replay->index_size = index_size;
+	replay->index_count = 0;
+	replay->stride = 1;
+	replay->offset = 0;
+	replay->blocks = 0;
+	replay->corrupted = 0;
+	if (index_size < 2)
+	{
+		return ERR_PARAM;
+	}
+	while (Replay_Block_At(replay, &offset, &header, &length) == STATUS_OK_ADXL)
+	{
+		if (replay->blocks % replay->stride == 0)
+		{
+			if (replay->index_count == replay->index_size)
+			{
+				// Keep every other entry, including the last one of an odd count: the index stays sorted and evenly spaced
+				for (i = 0; i < (replay->index_count + 1) / 2; i++)
+				{
+					replay->index[i] = replay->index[2 * i];
+				}
+				replay->index_count = (replay->index_count + 1) / 2;
+				replay->stride *= 2;
+			}
+			if (replay->blocks % replay->stride == 0)
+			{
+				replay->index[replay->index_count].sequence = header.sequence;
+				replay->index[replay->index_count].timestamp = header.timestamp;
+				replay->index[replay->index_count].offset = offset;
+				replay->index_count++;
+			}
+		}
+		replay->blocks++;
+		offset += length;
+	}
+	if (replay->blocks == 0)
+	{
+		ret_val = ERR_READING;
+	}
+	else
+	{
+		replay->offset = replay->index[0].offset;
+	}
+	replay->corrupted = 0;
+	return ret_val;
+}
+
+/**
+ * @brief Function that moves the read position to the block that contains a sequence number: a binary search of the index, then a walk of
+ * up to stride CRC-checked blocks. With a fixed index the stride grows as n / index_size, so the walk dominates on long recordings; an
+ * index sized to the recording (Replay_File_Open with index NULL on the host) bounds it and keeps the seek O(log n)
+ *
+ * @param replay Pointer to the replay
+ * @param sequence Sequence number
+ * @return STATUS_ADXL ERR_PARAM if the sequence is before the recording
+ */
+STATUS_ADXL Replay_Seek_Sequence(t_Replay *replay, uint32_t sequence)
+{
+	return Replay_Seek(replay, sequence, false);
+}
+
+/**
+ * @brief Function that moves the read position to the block that contains a time
+ *
+ * @param replay Pointer to the replay
+ * @param timestamp Time in us (64-bit stream clock, see Stream_Push)
+ * @return STATUS_ADXL ERR_PARAM if the time is before the recording
+ */
+STATUS_ADXL Replay_Seek_Time(t_Replay *replay, uint64_t timestamp)
+{
+	return Replay_Seek(replay, timestamp, true);
+}
+
+/**
+ * @brief Function that decodes the block at the read position and advances. Corrupted data is skipped
+ *
+ * @param replay Pointer to the replay
+ * @param block Pointer to the block. Its samples point into the replay and stay valid until the next call
+ * @return STATUS_ADXL ERR_READING at the end of the recording
+ */
+STATUS_ADXL Replay_Next(t_Replay *replay, t_SampleBlock *block)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_LogHeader header;
+	uint32_t length = 0;
+	if (Replay_Block_At(replay, &replay->offset, &header, &length))
+	{
+		ret_val = ERR_READING;
+	}
+	else if (header.count > LOG_BLOCK_SAMPLES)
+	{
+		replay->offset += length;
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		Log_Decode_Samples(&replay->data[replay->offset], &header, replay->samples);
+		block->sequence = header.sequence;
+		block->timestamp = header.timestamp;
+		block->period = Sample_Period_Ns(header.bw_rate);
+		block->count = header.count;
+		block->samples = replay->samples;
+		replay->offset += length;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that feeds the recording from the read position to a stream consumer, with gap records where sequence numbers jump
+ *
+ * @param replay Pointer to the replay
+ * @param sink Consumer callbacks (same as a live t_Stream)
+ * @param wait NULL to replay as fast as possible, otherwise called with the time to the next block
+ * @param arg User argument for wait
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Replay_Run(t_Replay *replay, const t_StreamSink *sink, REPLAY_WAIT wait, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_SampleBlock block;
+	t_Gap gap;
+	bool started = false;
+	uint32_t next_sequence = 0;
+	uint64_t last_timestamp = 0;
+	uint64_t last_end = 0;
+	uint64_t delay = 0;
+	while ((ret_val = Replay_Next(replay, &block)) != ERR_READING)
+	{
+		if (ret_val != STATUS_OK_ADXL)
+		{
+			continue;
+		}
+		if (started && wait)
+		{
+			delay = (block.timestamp > last_timestamp) ? block.timestamp - last_timestamp : 0;
+			wait((delay > UINT32_MAX) ? UINT32_MAX : (uint32_t)delay, arg);
+		}
+		if (started && block.sequence != next_sequence && sink->on_gap)
+		{
+			gap.sequence = next_sequence;
+			gap.lost = block.sequence - next_sequence;
+			gap.timestamp = last_end;
+			gap.cause = GAP_UNKNOWN;
+			sink->on_gap(&gap, sink->arg);
+		}
+		if (sink->on_block)
+		{
+			sink->on_block(&block, sink->arg);
+		}
+		next_sequence = block.sequence + block.count;
+		last_timestamp = block.timestamp;
+		last_end = block.timestamp + ((uint64_t)block.count * block.period) / 1000;
+		started = true;
+	}
+	return STATUS_OK_ADXL;
+}
@@ -0,0 +1,104 @@
+#ifndef ADXL_REPLAY_H
+#define ADXL_REPLAY_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+#include "adxl_log.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+typedef struct t_ReplayEntry
+{
+	uint32_t sequence; 				// sequence number of the first sample of the block
+	uint64_t timestamp; 			// time of the first sample of the block in us
+	uint32_t offset; 				// offset of the block in the recording
+} t_ReplayEntry;
+
+/**
+ * @brief Function used for real-time replay. It must return once delay us have elapsed since the previous call
+ */
+typedef void (*REPLAY_WAIT)(uint32_t delay, void *arg);
+
+typedef struct t_Replay
+{
+	const uint8_t *data; 			// recording, usually memory-mapped by the host (mmap/MapViewOfFile) or in flash
+	uint32_t size;
+	t_ReplayEntry *index; 			// caller-provided sparse index
+	uint32_t index_size;
+	uint32_t index_count;
+	uint32_t stride; 				// blocks between two index entries
+	uint32_t offset; 				// read position
+	uint32_t blocks; 				// valid blocks in the recording
+	uint32_t corrupted; 			// resynchronizations while reading
+	t_Sample samples[LOG_BLOCK_SAMPLES];
+} t_Replay;
+
+/******************************************************************************************************************************************************************************/
+/*																				Indexed Replay 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that scans a recording (headers and CRC only) and builds a sparse index. The stride doubles whenever the index is full,
+ * so any recording fits in index_size entries, and a seek walks up to stride blocks after the search
+ *
+ * @param replay Pointer to the replay
+ * @param data Pointer to the recording (adxl_log.h block format)
+ * @param size Size of the recording
+ * @param index Pointer to the index array
+ * @param index_size Number of entries of the index array (at least 2)
+ * @return STATUS_ADXL ERR_READING if the recording has no valid block
+ */
+STATUS_ADXL Replay_Open(t_Replay *replay, const uint8_t *data, uint32_t size, t_ReplayEntry *index, uint32_t index_size);
+
+/**
+ * @brief Function that moves the read position to the block that contains a sequence number: a binary search of the index, then a walk of
+ * up to stride CRC-checked blocks. With a fixed index the stride grows as n / index_size, so the walk dominates on long recordings; an
+ * index sized to the recording (Replay_File_Open with index NULL on the host) bounds it and keeps the seek O(log n)
+ *
+ * @param replay Pointer to the replay
+ * @param sequence Sequence number
+ * @return STATUS_ADXL ERR_PARAM if the sequence is before the recording
+ */
+STATUS_ADXL Replay_Seek_Sequence(t_Replay *replay, uint32_t sequence);
+
+/**
+ * @brief Function that moves the read position to the block that contains a time
+ *
+ * @param replay Pointer to the replay
+ * @param timestamp Time in us (64-bit stream clock, see Stream_Push)
+ * @return STATUS_ADXL ERR_PARAM if the time is before the recording
+ */
+STATUS_ADXL Replay_Seek_Time(t_Replay *replay, uint64_t timestamp);
+
+/**
+ * @brief Function that decodes the block at the read position and advances. Corrupted data is skipped
+ *
+ * @param replay Pointer to the replay
+ * @param block Pointer to the block. Its samples point into the replay and stay valid until the next call
+ * @return STATUS_ADXL ERR_READING at the end of the recording
+ */
+STATUS_ADXL Replay_Next(t_Replay *replay, t_SampleBlock *block);
+
+/**
+ * @brief Function that feeds the recording from the read position to a stream consumer, with gap records where sequence numbers jump
+ *
+ * @param replay Pointer to the replay
+ * @param sink Consumer callbacks (same as a live t_Stream)
+ * @param wait NULL to replay as fast as possible, otherwise called with the time to the next block
+ * @param arg User argument for wait
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Replay_Run(t_Replay *replay, const t_StreamSink *sink, REPLAY_WAIT wait, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_REPLAY_H */
@@ -0,0 +1,230 @@
+#include "adxl_shock.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that returns the squared magnitude of a sample (no square root; fits in 32 bits for any int16 triplet)
+ *
+ * @param sample Pointer to the sample
+ * @return uint32_t
+ */
+static inline uint32_t Magnitude2(const t_Sample *sample)
+{
+	return (uint32_t)((int32_t)sample->x * sample->x) + (uint32_t)((int32_t)sample->y * sample->y) + (uint32_t)((int32_t)sample->z * sample->z);
+}
+
+/**
+ * @brief Function that starts tracking a shock
+ *
+ * @param shock Pointer to the detector
+ * @param magnitude2 Squared magnitude of the sample
+ * @param index Sequence number of the sample
+ * @param state ABOVE or ABOVE_SECOND
+ */
+static void Shock_Start(t_Shock *shock, uint32_t magnitude2, uint32_t index, SHOCK_STATE state)
+{
+	shock->state = state;
+	shock->counter = 1;
+	shock->event.peak = magnitude2;
+	shock->event.index = index;
+}
+
+/**
+ * @brief Function that emits an event
+ *
+ * @param shock Pointer to the detector
+ * @param event Pointer to the event
+ */
+static void Shock_Emit(t_Shock *shock, const t_ShockEvent *event)
+{
+	if (shock->callback)
+	{
+		shock->callback(event, shock->arg);
+	}
+}
+
+/**
+ * @brief Function that ends the shock in progress. A double also carries the peak of the first shock held in shock->first
+ *
+ * @param shock Pointer to the detector
+ * @param type Single or double
+ */
+static void Shock_End(t_Shock *shock, SHOCK_TYPE type)
+{
+	shock->event.type = type;
+	shock->event.duration = shock->counter;
+	if (type == SHOCK_DOUBLE)
+	{
+		shock->event.first_peak = shock->first.peak;
+		shock->event.first_index = shock->first.index;
+	}
+	else
+	{
+		shock->event.first_peak = shock->event.peak;
+		shock->event.first_index = shock->event.index;
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Shock Detection 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a shock detector. The magnitude includes gravity: set the threshold above 1 g or feed gravity-free samples
+ *
+ * @param shock Pointer to the detector
+ * @param config Thresholds and timing in samples (duration >= 1, window 0 disables double shocks)
+ * @param callback Function called for every event
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Shock_Init(t_Shock *shock, const t_ShockConfig *config, SHOCK_CALLBACK callback, void *arg)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (config->threshold == 0 || config->duration == 0)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		shock->config = *config;
+		shock->threshold2 = (uint32_t)config->threshold * config->threshold;
+		shock->callback = callback;
+		shock->arg = arg;
+		Shock_Reset(shock);
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that runs the detector over a block of samples. With a window, a single shock is reported when the window closes
+ * (latency + window samples after it) and a double shock replaces it, so every shock is reported once
+ *
+ * @param shock Pointer to the detector
+ * @param block Sample block (see adxl_stream.h). Blocks must be consecutive
+ */
+void Shock_Process_Block(t_Shock *shock, const t_SampleBlock *block)
+{
+	const t_Sample *samples = block->samples;
+	const uint32_t threshold2 = shock->threshold2;
+	uint16_t count = block->count;
+	uint16_t i = 0;
+	uint32_t magnitude2 = 0;
+	bool above = false;
+
+	for (i = 0; i < count; i++)
+	{
+		if (shock->state == SHOCK_IDLE)
+		{
+			// Fast path: nothing to track until the threshold is crossed
+			while (i < count && Magnitude2(&samples[i]) <= threshold2)
+			{
+				i++;
+			}
+			if (i == count)
+			{
+				break;
+			}
+		}
+		magnitude2 = Magnitude2(&samples[i]);
+		above = magnitude2 > threshold2;
+		switch (shock->state)
+		{
+		case SHOCK_IDLE:
+			Shock_Start(shock, magnitude2, block->sequence + i, SHOCK_ABOVE);
+			break;
+		case SHOCK_ABOVE:
+		case SHOCK_ABOVE_SECOND:
+			if (above)
+			{
+				shock->counter++;
+				if (magnitude2 > shock->event.peak)
+				{
+					shock->event.peak = magnitude2;
+					shock->event.index = block->sequence + i;
+				}
+				if (shock->counter > shock->config.duration)
+				{
+					// Too long for a shock. A second one that fails this way leaves the first one single
+					if (shock->state == SHOCK_ABOVE_SECOND)
+					{
+						Shock_Emit(shock, &shock->first);
+					}
+					shock->state = SHOCK_HOLD;
+				}
+			}
+			else if (shock->state == SHOCK_ABOVE)
+			{
+				Shock_End(shock, SHOCK_SINGLE);
+				if (shock->config.window > 0)
+				{
+					// Hold the single back: a second shock in the window turns it into a double
+					shock->first = shock->event;
+					shock->state = SHOCK_LATENCY;
+				}
+				else
+				{
+					Shock_Emit(shock, &shock->event);
+					shock->state = SHOCK_IDLE;
+				}
+				shock->counter = 0;
+			}
+			else
+			{
+				Shock_End(shock, SHOCK_DOUBLE);
+				Shock_Emit(shock, &shock->event);
+				shock->state = SHOCK_IDLE;
+			}
+			break;
+		case SHOCK_LATENCY:
+			shock->counter++;
+			if (shock->counter >= shock->config.latency)
+			{
+				shock->state = SHOCK_WINDOW;
+				shock->counter = 0;
+			}
+			break;
+		case SHOCK_WINDOW:
+			shock->counter++;
+			if (above)
+			{
+				Shock_Start(shock, magnitude2, block->sequence + i, SHOCK_ABOVE_SECOND);
+			}
+			else if (shock->counter >= shock->config.window)
+			{
+				Shock_Emit(shock, &shock->first);
+				shock->state = SHOCK_IDLE;
+			}
+			break;
+		case SHOCK_HOLD:
+			if (!above)
+			{
+				shock->state = SHOCK_IDLE;
+			}
+			break;
+		default:
+			shock->state = SHOCK_IDLE;
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Function that restarts the detection (after a gap or a configuration change). A single shock held back for the window is dropped
+ *
+ * @param shock Pointer to the detector
+ */
+void Shock_Reset(t_Shock *shock)
+{
+	shock->state = SHOCK_IDLE;
+	shock->counter = 0;
+	shock->event.type = SHOCK_SINGLE;
+	shock->event.peak = 0;
+	shock->event.index = 0;
+	shock->event.duration = 0;
+	shock->event.first_peak = 0;
+	shock->event.first_index = 0;
+	shock->first = shock->event;
+}
@@ -0,0 +1,99 @@
+#ifndef ADXL_SHOCK_H
+#define ADXL_SHOCK_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+typedef enum SHOCK_TYPE
+{
+	SHOCK_SINGLE = 0,
+	SHOCK_DOUBLE
+} SHOCK_TYPE;
+
+typedef enum SHOCK_STATE
+{
+	SHOCK_IDLE = 0, 				// waiting for the first shock
+	SHOCK_ABOVE, 					// first shock in progress
+	SHOCK_LATENCY, 					// dead time after the first shock, which is held back
+	SHOCK_WINDOW, 					// waiting for the second shock, the first one is reported as single when it closes
+	SHOCK_ABOVE_SECOND, 			// second shock in progress
+	SHOCK_HOLD 						// too long above threshold, wait until it drops
+} SHOCK_STATE;
+
+typedef struct t_ShockEvent
+{
+	SHOCK_TYPE type;
+	uint32_t peak; 					// peak squared magnitude in LSB^2 (second shock of a double)
+	uint32_t index; 				// sequence number of the peak sample (second shock of a double)
+	uint16_t duration; 				// samples above threshold (second shock of a double)
+	uint32_t first_peak; 			// peak of the first shock of a double, same as peak for a single
+	uint32_t first_index; 			// sequence number of the peak of the first shock of a double, same as index for a single
+} t_ShockEvent;
+
+typedef void (*SHOCK_CALLBACK)(const t_ShockEvent *event, void *arg);
+
+typedef struct t_ShockConfig
+{
+	uint16_t threshold; 			// magnitude threshold in LSB (compared squared)
+	uint16_t duration; 				// maximum samples above threshold for a shock
+	uint16_t latency; 				// samples after the first shock before the window opens
+	uint16_t window; 				// samples in which a second shock makes a double shock
+} t_ShockConfig;
+
+typedef struct t_Shock
+{
+	uint32_t threshold2; 			// threshold squared
+	t_ShockConfig config;
+	SHOCK_STATE state;
+	uint16_t counter; 				// samples in the current state
+	t_ShockEvent event; 			// shock in progress
+	t_ShockEvent first; 			// first shock, reported as single once the window closes without a second one
+	SHOCK_CALLBACK callback;
+	void *arg;
+} t_Shock;
+
+/******************************************************************************************************************************************************************************/
+/*																				Shock Detection 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a shock detector. The magnitude includes gravity: set the threshold above 1 g or feed gravity-free samples
+ *
+ * @param shock Pointer to the detector
+ * @param config Thresholds and timing in samples (duration >= 1, window 0 disables double shocks)
+ * @param callback Function called for every event
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Shock_Init(t_Shock *shock, const t_ShockConfig *config, SHOCK_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that runs the detector over a block of samples. With a window, a single shock is reported when the window closes
+ * (latency + window samples after it) and a double shock replaces it, so every shock is reported once
+ *
+ * @param shock Pointer to the detector
+ * @param block Sample block (see adxl_stream.h). Blocks must be consecutive
+ */
+void Shock_Process_Block(t_Shock *shock, const t_SampleBlock *block);
+
+/**
+ * @brief Function that restarts the detection (after a gap or a configuration change). A single shock held back for the window is dropped
+ *
+ * @param shock Pointer to the detector
+ */
+void Shock_Reset(t_Shock *shock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_SHOCK_H */
@@ -0,0 +1,172 @@
+#include "adxl_stream.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Sample Stream 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a sample stream
+ *
+ * @param stream Pointer to the stream
+ * @param rate Rate code written to BW_RATE (BANDWIDTH)
+ * @param sink Consumer callbacks
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Init(t_Stream *stream, uint8_t rate, const t_StreamSink *sink)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	stream->sink = *sink;
+	stream->sequence = 0;
+	stream->period = Sample_Period_Ns(rate);
+	stream->jitter = 0;
+	stream->last_int = 0;
+	stream->clock = 0;
+	stream->last_time = 0;
+	stream->started = false;
+	stream->gaps = 0;
+	stream->lost = 0;
+	return ret_val;
+}
+
+/**
+ * @brief Function that updates the sample period after Set_Bandwidth_Rate. The sequence numbering continues
+ *
+ * @param stream Pointer to the stream
+ * @param rate Rate code (BANDWIDTH)
+ */
+void Stream_Set_Rate(t_Stream *stream, uint8_t rate)
+{
+	stream->period = Sample_Period_Ns(rate);
+}
+
+/**
+ * @brief Function that sets how far the interrupt time may wander from the sample clock before a time difference counts as lost samples.
+ * It only matters when the FIFO cannot tell (no int_source, or a full FIFO)
+ *
+ * @param stream Pointer to the stream
+ * @param jitter Tolerance in us, 0 for half a sample period
+ */
+void Stream_Set_Jitter(t_Stream *stream, uint32_t jitter)
+{
+	stream->jitter = jitter;
+}
+
+/**
+ * @brief Function that numbers, timestamps and delivers a block of samples. Missing samples are reported as a gap record before the block.
+ * Loss is decided from the FIFO: with int_source, samples are only missing after an overrun or when the whole FIFO was drained;
+ * the time since the last block then estimates how many. Without int_source the time difference decides, within the jitter tolerance
+ *
+ * @param stream Pointer to the stream
+ * @param int_source Interrupt source read before the samples (NULL if not available)
+ * @param samples Samples in acquisition order, the last one being the newest
+ * @param count Number of samples
+ * @param int_time Time of the interrupt that announced the samples in us from a free-running 32-bit counter. It may wrap; blocks
+ * carry it extended to 64 bits, so pushes must come less than 2^32 us (71 min) apart
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Push(t_Stream *stream, const t_IntSource *int_source, const t_Sample *samples, uint16_t count, uint32_t int_time)
+{
+	t_SampleBlock block;
+	block.count = count;
+	block.samples = samples;
+	return Stream_Push_Block(stream, int_source, &block, int_time);
+}
+
+/**
+ * @brief Function that numbers, timestamps and delivers a block owned by the caller, as Stream_Push does. The sink receives this very
+ * block, so a block embedded in a larger buffer (t_PoolBlock) can be recovered from it
+ *
+ * @param stream Pointer to the stream
+ * @param int_source Interrupt source read before the samples (NULL if not available)
+ * @param block Pointer to the block with samples and count set. sequence, timestamp and period are filled in
+ * @param int_time Time of the interrupt that announced the samples in us (see Stream_Push)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Push_Block(t_Stream *stream, const t_IntSource *int_source, t_SampleBlock *block, uint32_t int_time)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	t_Gap gap;
+	uint16_t count = block->count;
+	uint64_t span = 0;
+	uint64_t first_time = 0;
+	uint64_t elapsed = 0;
+	uint64_t tolerance = 0;
+	uint32_t missing = 0;
+	bool overrun = (int_source != NULL) && int_source->overrun;
+	bool full = count >= FIFO_SIZE;
+
+	if (count == 0)
+	{
+		return ret_val;
+	}
+
+	// Extend the 32-bit interrupt clock: the modular difference is exact as long as pushes are less than one wrap apart
+	stream->clock = stream->started ? stream->clock + (uint32_t)(int_time - stream->last_int) : int_time;
+	stream->last_int = int_time;
+
+	// The newest sample was converted when the interrupt fired, the older ones one period apart before it
+	span = ((uint64_t)(count - 1) * stream->period) / 1000;
+	first_time = (stream->clock > span) ? stream->clock - span : 0;
+
+	if (stream->started)
+	{
+		// The FIFO keeps every sample between two drains unless it overran or was full. Only then, or without the interrupt
+		// source, does the time since the last delivered sample decide, and only beyond the jitter tolerance
+		if (first_time > stream->last_time && (int_source == NULL || overrun || full))
+		{
+			elapsed = (first_time - stream->last_time) * 1000;
+			tolerance = stream->jitter ? (uint64_t)stream->jitter * 1000 : stream->period / 2;
+			if (overrun || elapsed > stream->period + tolerance)
+			{
+				missing = (uint32_t)((elapsed + stream->period / 2) / stream->period);
+				missing = (missing > 1) ? missing - 1 : 0;
+			}
+		}
+		if (overrun && missing == 0)
+		{
+			missing = 1; // overrun guarantees that at least one sample was replaced
+		}
+		if (missing > 0)
+		{
+			gap.sequence = stream->sequence;
+			gap.lost = missing;
+			gap.timestamp = stream->last_time + stream->period / 1000;
+			if (overrun)
+			{
+				gap.cause = GAP_OVERRUN;
+			}
+			else if (full)
+			{
+				gap.cause = GAP_FIFO_FULL;
+			}
+			else
+			{
+				gap.cause = GAP_MISSED_EDGE;
+			}
+			stream->sequence += missing;
+			stream->gaps++;
+			stream->lost += missing;
+			if (stream->sink.on_gap)
+			{
+				stream->sink.on_gap(&gap, stream->sink.arg);
+			}
+		}
+		// Keep timestamps monotonic when the interrupt time jitters backwards
+		if (first_time <= stream->last_time)
+		{
+			first_time = stream->last_time + 1;
+		}
+	}
+
+	block->sequence = stream->sequence;
+	block->timestamp = first_time;
+	block->period = stream->period;
+	stream->sequence += count;
+	stream->last_time = first_time + span;
+	stream->started = true;
+	if (stream->sink.on_block)
+	{
+		stream->sink.on_block(block, stream->sink.arg);
+	}
+	return ret_val;
+}
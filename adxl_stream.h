@@ -0,0 +1,116 @@
+#ifndef ADXL_STREAM_H
+#define ADXL_STREAM_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+typedef enum GAP_CAUSE
+{
+	GAP_MISSED_EDGE = 0, 			// a DATA_READY/watermark interrupt was not serviced in time
+	GAP_FIFO_FULL, 					// the FIFO was full when it was drained
+	GAP_OVERRUN, 					// the sensor reported overrun (new data replaced unread data)
+	GAP_UNKNOWN 					// the cause is not known (gap found in a recording)
+} GAP_CAUSE;
+
+// t_SampleBlock is declared in adxl_types.h
+
+typedef struct t_Gap
+{
+	uint32_t sequence; 				// first sequence number that is missing
+	uint32_t lost; 					// estimated number of lost samples
+	uint64_t timestamp; 			// estimated time of the first lost sample in us
+	GAP_CAUSE cause;
+} t_Gap;
+
+typedef struct t_StreamSink
+{
+	void (*on_block)(const t_SampleBlock *block, void *arg);
+	void (*on_gap)(const t_Gap *gap, void *arg);
+	void *arg;
+} t_StreamSink;
+
+typedef struct t_Stream
+{
+	t_StreamSink sink;
+	uint32_t sequence; 				// next sequence number
+	uint32_t period; 				// sample period in ns
+	uint32_t jitter; 				// interrupt time tolerance in us, 0: half a period
+	uint32_t last_int; 				// last interrupt time as passed in (32-bit clock)
+	uint64_t clock; 				// last interrupt time extended to 64 bits
+	uint64_t last_time; 			// time of the last delivered sample in us
+	bool started;
+	uint32_t gaps; 					// number of gap records
+	uint32_t lost; 					// total of estimated lost samples
+} t_Stream;
+
+/******************************************************************************************************************************************************************************/
+/*																				Sample Stream 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a sample stream
+ *
+ * @param stream Pointer to the stream
+ * @param rate Rate code written to BW_RATE (BANDWIDTH)
+ * @param sink Consumer callbacks
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Init(t_Stream *stream, uint8_t rate, const t_StreamSink *sink);
+
+/**
+ * @brief Function that updates the sample period after Set_Bandwidth_Rate. The sequence numbering continues
+ *
+ * @param stream Pointer to the stream
+ * @param rate Rate code (BANDWIDTH)
+ */
+void Stream_Set_Rate(t_Stream *stream, uint8_t rate);
+
+/**
+ * @brief Function that sets how far the interrupt time may wander from the sample clock before a time difference counts as lost samples.
+ * It only matters when the FIFO cannot tell (no int_source, or a full FIFO)
+ *
+ * @param stream Pointer to the stream
+ * @param jitter Tolerance in us, 0 for half a sample period
+ */
+void Stream_Set_Jitter(t_Stream *stream, uint32_t jitter);
+
+/**
+ * @brief Function that numbers, timestamps and delivers a block of samples. Missing samples are reported as a gap record before the block.
+ * Loss is decided from the FIFO: with int_source, samples are only missing after an overrun or when the whole FIFO was drained;
+ * the time since the last block then estimates how many. Without int_source the time difference decides, within the jitter tolerance
+ *
+ * @param stream Pointer to the stream
+ * @param int_source Interrupt source read before the samples (NULL if not available)
+ * @param samples Samples in acquisition order, the last one being the newest
+ * @param count Number of samples
+ * @param int_time Time of the interrupt that announced the samples in us from a free-running 32-bit counter. It may wrap; blocks
+ * carry it extended to 64 bits, so pushes must come less than 2^32 us (71 min) apart
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Push(t_Stream *stream, const t_IntSource *int_source, const t_Sample *samples, uint16_t count, uint32_t int_time);
+
+/**
+ * @brief Function that numbers, timestamps and delivers a block owned by the caller, as Stream_Push does. The sink receives this very
+ * block, so a block embedded in a larger buffer (t_PoolBlock) can be recovered from it
+ *
+ * @param stream Pointer to the stream
+ * @param int_source Interrupt source read before the samples (NULL if not available)
+ * @param block Pointer to the block with samples and count set. sequence, timestamp and period are filled in
+ * @param int_time Time of the interrupt that announced the samples in us (see Stream_Push)
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Stream_Push_Block(t_Stream *stream, const t_IntSource *int_source, t_SampleBlock *block, uint32_t int_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_STREAM_H */
@@ -0,0 +1,240 @@
+#include "adxl_tilt.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes atan(num / den) for 0 <= num <= den
+ *
+ * @param num Numerator
+ * @param den Denominator
+ * @return int32_t Angle in 0.01 degree (0 to 4500)
+ */
+static int32_t Atan_Octant(uint32_t num, uint32_t den)
+{
+	int32_t x = 0;
+	int32_t t = 0;
+	int32_t c = 0;
+	if (den == 0)
+	{
+		return 0;
+	}
+	x = (int32_t)(((uint64_t)num << 15) / den); // Q15 ratio
+	t = (int32_t)(((int64_t)x * (32768 - x)) >> 15); // x (1 - x)
+	c = 1402 + ((380 * x) >> 15); // (0.2447 + 0.0663 x) rad in 0.01 degree
+	return (int32_t)(((int64_t)4500 * x + (int64_t)t * c + 16384) >> 15);
+}
+
+/**
+ * @brief Function that computes the pitch, roll and face of the current gravity estimate
+ *
+ * @param tilt Pointer to the estimator
+ */
+static void Tilt_Evaluate(t_Tilt *tilt)
+{
+	int32_t gx = tilt->gravity[0] >> TILT_FRACTION_BITS;
+	int32_t gy = tilt->gravity[1] >> TILT_FRACTION_BITS;
+	int32_t gz = tilt->gravity[2] >> TILT_FRACTION_BITS;
+	int32_t value[7];
+	uint8_t face = 0;
+	ORIENTATION candidate = FACE_UNKNOWN;
+
+	tilt->roll = Tilt_Atan2(gy, gz);
+	tilt->pitch = Tilt_Atan2(-gx, Tilt_Isqrt((uint32_t)(gy * gy) + (uint32_t)(gz * gz)));
+
+	// Signed gravity component along every face normal; the face with the largest one is on top
+	value[FACE_UNKNOWN] = 0;
+	value[FACE_X_UP] = gx;
+	value[FACE_X_DOWN] = -gx;
+	value[FACE_Y_UP] = gy;
+	value[FACE_Y_DOWN] = -gy;
+	value[FACE_Z_UP] = gz;
+	value[FACE_Z_DOWN] = -gz;
+	candidate = FACE_X_UP;
+	for (face = FACE_X_DOWN; face <= FACE_Z_DOWN; face++)
+	{
+		if (value[face] > value[candidate])
+		{
+			candidate = (ORIENTATION)face;
+		}
+	}
+	if (tilt->face == FACE_UNKNOWN || value[candidate] > value[tilt->face] + tilt->hysteresis)
+	{
+		tilt->face = candidate;
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																			Fixed-point Math 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes atan2 in integer arithmetic. Polynomial pi/4 x - x (x - 1)(0.2447 + 0.0663 x) on the first octant,
+ * maximum error 0.1 degree (10 units) over the whole circle
+ *
+ * @param y Y coordinate
+ * @param x X coordinate
+ * @return int16_t Angle in 0.01 degree (-18000 to 18000)
+ */
+int16_t Tilt_Atan2(int32_t y, int32_t x)
+{
+	uint32_t ax = (x < 0) ? (uint32_t)-x : (uint32_t)x;
+	uint32_t ay = (y < 0) ? (uint32_t)-y : (uint32_t)y;
+	int32_t angle = 0;
+	if (ax >= ay)
+	{
+		angle = Atan_Octant(ay, ax);
+	}
+	else
+	{
+		angle = 9000 - Atan_Octant(ax, ay);
+	}
+	if (x < 0)
+	{
+		angle = 18000 - angle;
+	}
+	if (y < 0)
+	{
+		angle = -angle;
+	}
+	return (int16_t)angle;
+}
+
+/**
+ * @brief Function that computes the integer square root, rounded to the nearest integer
+ *
+ * @param value Input value
+ * @return uint16_t
+ */
+uint16_t Tilt_Isqrt(uint32_t value)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+	while (bit > value)
+	{
+		bit >>= 2;
+	}
+	while (bit)
+	{
+		if (value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	if (value > root && root < 0xFFFF)
+	{
+		root++; // remainder above root means value is closer to (root + 1)^2
+	}
+	return (uint16_t)root;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Tilt and Orientation 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes pitch and roll of a single raw sample, without filtering. Maximum error against libm 0.2 degree at 256 LSB/g
+ *
+ * @param sample Pointer to the sample
+ * @param pitch Pointer to the pitch in 0.01 degree (rotation about Y, -9000 to 9000)
+ * @param roll Pointer to the roll in 0.01 degree (rotation about X, -18000 to 18000)
+ */
+void Tilt_Angles(const t_Sample *sample, int16_t *pitch, int16_t *roll)
+{
+	int32_t y = sample->y;
+	int32_t z = sample->z;
+	*roll = Tilt_Atan2(y, z);
+	// Each square fits in int32, their sum (up to 2^31) only in uint32
+	*pitch = Tilt_Atan2(-(int32_t)sample->x, Tilt_Isqrt((uint32_t)(y * y) + (uint32_t)(z * z)));
+}
+
+/**
+ * @brief Function that initializes the tilt estimator
+ *
+ * @param tilt Pointer to the estimator
+ * @param shift Gravity low-pass coefficient 2^-shift (0: no filtering, 4: ~16 samples time constant)
+ * @param hysteresis LSB by which a new face must exceed the current one before the orientation changes
+ * @return STATUS_ADXL ERR_PARAM if shift is too large
+ */
+STATUS_ADXL Tilt_Init(t_Tilt *tilt, uint8_t shift, uint16_t hysteresis)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (shift > 15)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		tilt->gravity[0] = 0;
+		tilt->gravity[1] = 0;
+		tilt->gravity[2] = 0;
+		tilt->shift = shift;
+		tilt->hysteresis = hysteresis;
+		tilt->started = false;
+		tilt->face = FACE_UNKNOWN;
+		tilt->pitch = 0;
+		tilt->roll = 0;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that feeds one sample and updates gravity, pitch, roll and orientation
+ *
+ * @param tilt Pointer to the estimator
+ * @param sample Pointer to the sample
+ */
+void Tilt_Update(t_Tilt *tilt, const t_Sample *sample)
+{
+	t_SampleBlock block;
+	block.sequence = 0;
+	block.timestamp = 0;
+	block.period = 0;
+	block.count = 1;
+	block.samples = sample;
+	Tilt_Process_Block(tilt, &block);
+}
+
+/**
+ * @brief Function that filters a whole block and updates pitch, roll and orientation once at the end of the block
+ *
+ * @param tilt Pointer to the estimator
+ * @param block Sample block (see adxl_stream.h)
+ */
+void Tilt_Process_Block(t_Tilt *tilt, const t_SampleBlock *block)
+{
+	int32_t gx = tilt->gravity[0];
+	int32_t gy = tilt->gravity[1];
+	int32_t gz = tilt->gravity[2];
+	const uint8_t shift = tilt->shift;
+	uint16_t i = 0;
+
+	if (block->count == 0)
+	{
+		return;
+	}
+	if (!tilt->started)
+	{
+		gx = (int32_t)block->samples[0].x << TILT_FRACTION_BITS;
+		gy = (int32_t)block->samples[0].y << TILT_FRACTION_BITS;
+		gz = (int32_t)block->samples[0].z << TILT_FRACTION_BITS;
+		tilt->started = true;
+	}
+	for (i = 0; i < block->count; i++)
+	{
+		gx += (((int32_t)block->samples[i].x << TILT_FRACTION_BITS) - gx) >> shift;
+		gy += (((int32_t)block->samples[i].y << TILT_FRACTION_BITS) - gy) >> shift;
+		gz += (((int32_t)block->samples[i].z << TILT_FRACTION_BITS) - gz) >> shift;
+	}
+	tilt->gravity[0] = gx;
+	tilt->gravity[1] = gy;
+	tilt->gravity[2] = gz;
+	Tilt_Evaluate(tilt);
+}
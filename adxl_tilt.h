@@ -0,0 +1,105 @@
+#ifndef ADXL_TILT_H
+#define ADXL_TILT_H
+
+#include "adxl.h"
+#include "adxl_stream.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define TILT_FRACTION_BITS 			8 		// fractional bits of the gravity estimate
+
+typedef enum ORIENTATION
+{
+	FACE_UNKNOWN = 0,
+	FACE_X_UP,
+	FACE_X_DOWN,
+	FACE_Y_UP,
+	FACE_Y_DOWN,
+	FACE_Z_UP,
+	FACE_Z_DOWN
+} ORIENTATION;
+
+typedef struct t_Tilt
+{
+	int32_t gravity[3]; 			// low-pass gravity in LSB << TILT_FRACTION_BITS
+	uint8_t shift; 					// filter coefficient 2^-shift
+	uint16_t hysteresis; 			// LSB a new face must exceed the current one by
+	bool started;
+	ORIENTATION face;
+	int16_t pitch; 					// 0.01 degree
+	int16_t roll; 					// 0.01 degree
+} t_Tilt;
+
+/******************************************************************************************************************************************************************************/
+/*																			Fixed-point Math 																				  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes atan2 in integer arithmetic. Polynomial pi/4 x - x (x - 1)(0.2447 + 0.0663 x) on the first octant,
+ * maximum error 0.1 degree (10 units) over the whole circle
+ *
+ * @param y Y coordinate
+ * @param x X coordinate
+ * @return int16_t Angle in 0.01 degree (-18000 to 18000)
+ */
+int16_t Tilt_Atan2(int32_t y, int32_t x);
+
+/**
+ * @brief Function that computes the integer square root, rounded to the nearest integer
+ *
+ * @param value Input value
+ * @return uint16_t
+ */
+uint16_t Tilt_Isqrt(uint32_t value);
+
+/******************************************************************************************************************************************************************************/
+/*																				Tilt and Orientation 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes pitch and roll of a single raw sample, without filtering. Maximum error against libm 0.2 degree at 256 LSB/g
+ *
+ * @param sample Pointer to the sample
+ * @param pitch Pointer to the pitch in 0.01 degree (rotation about Y, -9000 to 9000)
+ * @param roll Pointer to the roll in 0.01 degree (rotation about X, -18000 to 18000)
+ */
+void Tilt_Angles(const t_Sample *sample, int16_t *pitch, int16_t *roll);
+
+/**
+ * @brief Function that initializes the tilt estimator
+ *
+ * @param tilt Pointer to the estimator
+ * @param shift Gravity low-pass coefficient 2^-shift (0: no filtering, 4: ~16 samples time constant)
+ * @param hysteresis LSB by which a new face must exceed the current one before the orientation changes
+ * @return STATUS_ADXL ERR_PARAM if shift is too large
+ */
+STATUS_ADXL Tilt_Init(t_Tilt *tilt, uint8_t shift, uint16_t hysteresis);
+
+/**
+ * @brief Function that feeds one sample and updates gravity, pitch, roll and orientation
+ *
+ * @param tilt Pointer to the estimator
+ * @param sample Pointer to the sample
+ */
+void Tilt_Update(t_Tilt *tilt, const t_Sample *sample);
+
+/**
+ * @brief Function that filters a whole block and updates pitch, roll and orientation once at the end of the block
+ *
+ * @param tilt Pointer to the estimator
+ * @param block Sample block (see adxl_stream.h)
+ */
+void Tilt_Process_Block(t_Tilt *tilt, const t_SampleBlock *block);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_TILT_H */
@@ -0,0 +1,88 @@
+#ifndef ADXL_TYPES_H
+#define ADXL_TYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Status codes and sample types shared by the driver and the processing modules. Nothing here depends on the HAL, so
+ * host-side code (host/adxl_pipeline, adxl_gravity) can be built on a gateway without the CubeMX main.h.
+ */
+
+#define FIFO_SIZE 					32 		// FIFO depth in samples
+
+#define DATA_FORMAT_FULL_RES 		0x08 	// FULL_RES bit of DATA_FORMAT
+#define DATA_FORMAT_JUSTIFY 		0x04 	// JUSTIFY bit of DATA_FORMAT
+#define DATA_FORMAT_RANGE 			0x03 	// RANGE_SETTINGS bits of DATA_FORMAT
+
+typedef enum STATUS_ADXL
+{
+	STATUS_OK_ADXL = 0x00,
+	ERR_SPI,
+	ERR_TRANSMIT,
+	ERR_RECEIVE,
+	ERR_READING,
+	ERR_WRITE,
+	ERR_ID,
+	ERR_BUSY,
+	ERR_PARAM,
+	ERR_NO_BUFFER
+} STATUS_ADXL;
+
+typedef struct t_IntSource
+{
+	bool data_ready;
+	bool activity;
+	bool inactivity;
+	bool watermark;
+	bool overrun;
+} t_IntSource;
+
+typedef struct t_Sample
+{
+	int16_t x;
+	int16_t y;
+	int16_t z;
+} t_Sample;
+
+typedef struct t_SampleBlock
+{
+	uint32_t sequence; 				// sequence number of samples[0]
+	uint64_t timestamp; 			// time of samples[0] in us, extended past the 32-bit interrupt clock wrap
+	uint32_t period; 				// sample period in ns
+	uint16_t count;
+	const t_Sample *samples;
+} t_SampleBlock;
+
+/**
+ * @brief Function that returns the output scale of a DATA_FORMAT value: full resolution keeps 1024 LSB/g at every range, 10-bit mode halves
+ * it with every range step, and left justified data is shifted so the MSB of the 10 to 13-bit result sits at bit 15
+ *
+ * @param data_format DATA_FORMAT register value
+ * @return uint32_t LSB per g
+ */
+static inline uint32_t Format_Lsb_Per_G(uint8_t data_format)
+{
+	uint8_t range = data_format & DATA_FORMAT_RANGE;
+	uint32_t lsb_per_g = (data_format & DATA_FORMAT_FULL_RES) ? 1024 : (1024 >> range);
+	if (data_format & DATA_FORMAT_JUSTIFY)
+	{
+		lsb_per_g <<= 6 - ((data_format & DATA_FORMAT_FULL_RES) ? range : 0);
+	}
+	return lsb_per_g;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_TYPES_H */
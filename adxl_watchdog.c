@@ -0,0 +1,310 @@
+#include "adxl_watchdog.h"
+#include "adxl_crc.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+typedef struct t_WatchdogBurst
+{
+	uint8_t address;
+	uint8_t count;
+	uint8_t index; 					// position of the first register in the watchdog arrays
+} t_WatchdogBurst;
+
+static const t_WatchdogBurst Watchdog_Bursts[WATCHDOG_BURSTS] = {
+	{X_AXIS_OFFSET, 10, 0},
+	{BW_RATE, 4, 10},
+	{DATA_FORMAT, 1, 14},
+	{FIFO_CTL, 1, 15}};
+
+#define WATCHDOG_POWER_INDEX 		11 		// POWER_CTL in the watchdog arrays
+#define WATCHDOG_AUTO_SLEEP 		0x10
+#define WATCHDOG_SLEEP 				0x04
+
+/**
+ * @brief Function that returns the register address of a position in the watchdog arrays
+ *
+ * @param index Position
+ * @return uint8_t Register address
+ */
+static uint8_t Watchdog_Address(uint8_t index)
+{
+	uint8_t i = WATCHDOG_BURSTS - 1;
+	while (Watchdog_Bursts[i].index > index)
+	{
+		i--;
+	}
+	return Watchdog_Bursts[i].address + (index - Watchdog_Bursts[i].index);
+}
+
+/**
+ * @brief Function that returns the position of the n-th register to restore. POWER_CTL comes last so the other registers are written in standby
+ *
+ * @param n Restore order
+ * @return uint8_t Position in the watchdog arrays
+ */
+static uint8_t Watchdog_Restore_Index(uint8_t n)
+{
+	if (n == WATCHDOG_REGISTERS - 1)
+	{
+		return WATCHDOG_POWER_INDEX;
+	}
+	return (n >= WATCHDOG_POWER_INDEX) ? n + 1 : n;
+}
+
+/**
+ * @brief Function that computes the CRC of the compared bits
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param values Register values
+ * @return uint16_t
+ */
+static uint16_t Watchdog_Crc(const t_Watchdog *watchdog, const uint8_t *values)
+{
+	uint8_t masked[WATCHDOG_REGISTERS];
+	uint8_t i = 0;
+	for (i = 0; i < WATCHDOG_REGISTERS; i++)
+	{
+		masked[i] = values[i] & watchdog->mask[i];
+	}
+	return Crc16_Update(CRC16_INIT, masked, WATCHDOG_REGISTERS);
+}
+
+/**
+ * @brief Function that updates the masks and the expected CRC after the expected configuration changes
+ *
+ * @param watchdog Pointer to the watchdog
+ */
+static void Watchdog_Update(t_Watchdog *watchdog)
+{
+	uint8_t i = 0;
+	for (i = 0; i < WATCHDOG_REGISTERS; i++)
+	{
+		watchdog->mask[i] = 0xFF;
+	}
+	// 0x21 - 0x23 are reserved
+	watchdog->mask[3] = 0x00;
+	watchdog->mask[4] = 0x00;
+	watchdog->mask[5] = 0x00;
+	// With auto-sleep the device sets and clears SLEEP on its own
+	if (watchdog->expected[WATCHDOG_POWER_INDEX] & WATCHDOG_AUTO_SLEEP)
+	{
+		watchdog->mask[WATCHDOG_POWER_INDEX] = (uint8_t)~WATCHDOG_SLEEP;
+	}
+	watchdog->expected_crc = Watchdog_Crc(watchdog, watchdog->expected);
+}
+
+/**
+ * @brief Function that estimates the bus time of a transaction
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param bytes Bytes on the bus, address included
+ * @return uint32_t Time in us
+ */
+static uint32_t Watchdog_Cost(const t_Watchdog *watchdog, uint8_t bytes)
+{
+	return watchdog->overhead + (uint32_t)(((uint64_t)bytes * 8 * 1000000 + watchdog->spi_hz - 1) / watchdog->spi_hz);
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Configuration Watchdog 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the watchdog
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param spi_hz SPI clock in Hz
+ * @param overhead Fixed cost of a transaction in us
+ * @param callback Function called for every drifted register (NULL if not used)
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watchdog_Init(t_Watchdog *watchdog, uint32_t spi_hz, uint32_t overhead, WATCHDOG_CALLBACK callback, void *arg)
+{
+	uint8_t i = 0;
+	if (spi_hz == 0)
+	{
+		return ERR_PARAM;
+	}
+	for (i = 0; i < WATCHDOG_REGISTERS; i++)
+	{
+		watchdog->expected[i] = 0;
+		watchdog->actual[i] = 0;
+	}
+	watchdog->captured = false;
+	watchdog->spi_hz = spi_hz;
+	watchdog->overhead = overhead;
+	watchdog->phase = WATCHDOG_IDLE;
+	watchdog->position = 0;
+	watchdog->callback = callback;
+	watchdog->arg = arg;
+	watchdog->checks = 0;
+	watchdog->drifts = 0;
+	watchdog->restored = 0;
+	Watchdog_Update(watchdog);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that reads the current configuration of a sensor known to be good and keeps it as the expected one. The expected values
+ * and their CRC only change once every burst has been read
+ *
+ * @param spi SPI interface
+ * @param watchdog Pointer to the watchdog
+ * @return STATUS_ADXL ERR_READING if a burst fails, the previous expected configuration is kept
+ */
+STATUS_ADXL Watchdog_Capture(SPI_HandleTypeDef *spi, t_Watchdog *watchdog)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	uint8_t values[WATCHDOG_REGISTERS] = {0};
+	uint8_t i = 0;
+	for (i = 0; i < WATCHDOG_BURSTS && ret_val == STATUS_OK_ADXL; i++)
+	{
+		if (Read_Registers(spi, Watchdog_Bursts[i].address, &values[Watchdog_Bursts[i].index], Watchdog_Bursts[i].count))
+		{
+			ret_val = ERR_READING;
+		}
+	}
+	if (ret_val == STATUS_OK_ADXL)
+	{
+		for (i = 0; i < WATCHDOG_REGISTERS; i++)
+		{
+			watchdog->expected[i] = values[i];
+		}
+		Watchdog_Update(watchdog);
+		watchdog->captured = true;
+		watchdog->phase = WATCHDOG_IDLE;
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that updates one expected register after the firmware writes it on purpose
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param address Register address
+ * @param value New value
+ * @return STATUS_ADXL ERR_PARAM if the register is not checked
+ */
+STATUS_ADXL Watchdog_Set_Expected(t_Watchdog *watchdog, uint8_t address, uint8_t value)
+{
+	uint8_t i = 0;
+	for (i = 0; i < WATCHDOG_REGISTERS; i++)
+	{
+		if (Watchdog_Address(i) == address)
+		{
+			watchdog->expected[i] = value;
+			Watchdog_Update(watchdog);
+			// A check in progress may hold the old value: start over
+			watchdog->phase = WATCHDOG_IDLE;
+			return STATUS_OK_ADXL;
+		}
+	}
+	return ERR_PARAM;
+}
+
+/**
+ * @brief Function that runs the check for at most a bus-time budget, so it can be called in the idle time between FIFO drains.
+ * A check reads the bursts, compares their CRC against the expected one, then rewrites only the registers that differ (POWER_CTL last)
+ *
+ * @param spi SPI interface
+ * @param watchdog Pointer to the watchdog
+ * @param budget Bus time allowed for this call in us
+ * @return STATUS_ADXL ERR_PARAM before the first successful Watchdog_Capture, ERR_BUSY if the budget does not cover the next transaction
+ */
+STATUS_ADXL Watchdog_Step(SPI_HandleTypeDef *spi, t_Watchdog *watchdog, uint32_t budget)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	const t_WatchdogBurst *burst = NULL;
+	uint32_t used = 0;
+	uint32_t cost = 0;
+	uint8_t index = 0;
+	bool progress = false;
+
+	// Without a captured baseline a check would restore the zeros of Watchdog_Init
+	if (!watchdog->captured)
+	{
+		return ERR_PARAM;
+	}
+	if (watchdog->phase == WATCHDOG_IDLE)
+	{
+		watchdog->phase = WATCHDOG_READ;
+		watchdog->position = 0;
+	}
+	while (ret_val == STATUS_OK_ADXL && watchdog->phase != WATCHDOG_IDLE)
+	{
+		if (watchdog->phase == WATCHDOG_READ)
+		{
+			burst = &Watchdog_Bursts[watchdog->position];
+			cost = Watchdog_Cost(watchdog, burst->count + 1);
+			if (used + cost > budget)
+			{
+				break;
+			}
+			if (Read_Registers(spi, burst->address, &watchdog->actual[burst->index], burst->count))
+			{
+				ret_val = ERR_READING;
+				watchdog->phase = WATCHDOG_IDLE;
+				break;
+			}
+			used += cost;
+			progress = true;
+			if (++watchdog->position == WATCHDOG_BURSTS)
+			{
+				watchdog->position = 0;
+				if (Watchdog_Crc(watchdog, watchdog->actual) == watchdog->expected_crc)
+				{
+					watchdog->checks++;
+					watchdog->phase = WATCHDOG_IDLE;
+				}
+				else
+				{
+					watchdog->drifts++;
+					watchdog->phase = WATCHDOG_RESTORE;
+				}
+			}
+		}
+		else
+		{
+			index = Watchdog_Restore_Index(watchdog->position);
+			if (((watchdog->actual[index] ^ watchdog->expected[index]) & watchdog->mask[index]) == 0)
+			{
+				watchdog->position++;
+			}
+			else
+			{
+				cost = Watchdog_Cost(watchdog, 2);
+				if (used + cost > budget)
+				{
+					break;
+				}
+				if (watchdog->callback)
+				{
+					watchdog->callback(Watchdog_Address(index), watchdog->expected[index], watchdog->actual[index], watchdog->arg);
+				}
+				if (Register_Write(spi, Watchdog_Address(index), watchdog->expected[index]))
+				{
+					ret_val = ERR_WRITE;
+					watchdog->phase = WATCHDOG_IDLE;
+					break;
+				}
+				used += cost;
+				progress = true;
+				watchdog->restored++;
+				watchdog->position++;
+			}
+			if (watchdog->position == WATCHDOG_REGISTERS)
+			{
+				watchdog->checks++;
+				watchdog->phase = WATCHDOG_IDLE;
+			}
+		}
+	}
+	if (ret_val == STATUS_OK_ADXL && !progress && watchdog->phase != WATCHDOG_IDLE)
+	{
+		ret_val = ERR_BUSY;
+	}
+	return ret_val;
+}
@@ -0,0 +1,108 @@
+#ifndef ADXL_WATCHDOG_H
+#define ADXL_WATCHDOG_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Checked registers, read in four bursts:
+ *
+ *	0x1E - 0x27		offsets, thresholds, TIME_INACT, ACT_INACT_CTL (0x21 - 0x23 are reserved and ignored)
+ *	0x2C - 0x2F		BW_RATE, POWER_CTL, INT_ENABLE, INT_MAP
+ *	0x31			DATA_FORMAT (0x30 INT_SOURCE is skipped: reading it clears the interrupt latches)
+ *	0x38			FIFO_CTL
+ */
+
+#define WATCHDOG_REGISTERS 			16
+#define WATCHDOG_BURSTS 			4
+
+typedef enum WATCHDOG_PHASE
+{
+	WATCHDOG_READ = 0, 				// reading the bursts
+	WATCHDOG_RESTORE, 				// rewriting the registers that differ
+	WATCHDOG_IDLE 					// check finished
+} WATCHDOG_PHASE;
+
+/**
+ * @brief Function called for every register found different from the expected configuration
+ */
+typedef void (*WATCHDOG_CALLBACK)(uint8_t address, uint8_t expected, uint8_t actual, void *arg);
+
+typedef struct t_Watchdog
+{
+	uint8_t expected[WATCHDOG_REGISTERS];
+	uint8_t mask[WATCHDOG_REGISTERS]; 	// bits that are compared
+	uint8_t actual[WATCHDOG_REGISTERS];
+	uint16_t expected_crc; 			// CRC-16 of the masked expected values
+	bool captured; 					// expected values read from the sensor by Watchdog_Capture
+	uint32_t spi_hz; 				// SPI clock, used to estimate the bus time of a transaction
+	uint32_t overhead; 				// fixed cost of a transaction in us (CS, driver, bus lock)
+	WATCHDOG_PHASE phase;
+	uint8_t position; 				// next burst or next register to restore
+	WATCHDOG_CALLBACK callback;
+	void *arg;
+	uint32_t checks; 				// completed checks
+	uint32_t drifts; 				// checks that found a difference
+	uint32_t restored; 				// registers rewritten
+} t_Watchdog;
+
+/******************************************************************************************************************************************************************************/
+/*																				Configuration Watchdog 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the watchdog
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param spi_hz SPI clock in Hz
+ * @param overhead Fixed cost of a transaction in us
+ * @param callback Function called for every drifted register (NULL if not used)
+ * @param arg User argument for the callback
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watchdog_Init(t_Watchdog *watchdog, uint32_t spi_hz, uint32_t overhead, WATCHDOG_CALLBACK callback, void *arg);
+
+/**
+ * @brief Function that reads the current configuration of a sensor known to be good and keeps it as the expected one. The expected values
+ * and their CRC only change once every burst has been read
+ *
+ * @param spi SPI interface
+ * @param watchdog Pointer to the watchdog
+ * @return STATUS_ADXL ERR_READING if a burst fails, the previous expected configuration is kept
+ */
+STATUS_ADXL Watchdog_Capture(SPI_HandleTypeDef *spi, t_Watchdog *watchdog);
+
+/**
+ * @brief Function that updates one expected register after the firmware writes it on purpose
+ *
+ * @param watchdog Pointer to the watchdog
+ * @param address Register address
+ * @param value New value
+ * @return STATUS_ADXL ERR_PARAM if the register is not checked
+ */
+STATUS_ADXL Watchdog_Set_Expected(t_Watchdog *watchdog, uint8_t address, uint8_t value);
+
+/**
+ * @brief Function that runs the check for at most a bus-time budget, so it can be called in the idle time between FIFO drains.
+ * A check reads the bursts, compares their CRC against the expected one, then rewrites only the registers that differ (POWER_CTL last)
+ *
+ * @param spi SPI interface
+ * @param watchdog Pointer to the watchdog
+ * @param budget Bus time allowed for this call in us
+ * @return STATUS_ADXL ERR_PARAM before the first successful Watchdog_Capture, ERR_BUSY if the budget does not cover the next transaction
+ */
+STATUS_ADXL Watchdog_Step(SPI_HandleTypeDef *spi, t_Watchdog *watchdog, uint32_t budget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_WATCHDOG_H */
@@ -0,0 +1,173 @@
+#include "adxl_watermark.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that computes the largest watermark that meets the age target and leaves enough FIFO room to absorb the peak latency
+ *
+ * @param control Pointer to the controller
+ * @return uint8_t
+ */
+static uint8_t Watermark_Target(const t_Watermark *control)
+{
+	// Oldest sample at the end of the drain: (w - 1) * period + latency + w * read_cost <= max_age
+	uint64_t period = control->period;
+	uint64_t cost = ((uint64_t)control->read_cost * 1000) >> 8;
+	uint64_t budget = (uint64_t)control->config.max_age * 1000 + period;
+	uint64_t target = 0;
+	uint64_t room = 0;
+	if (budget > (uint64_t)control->latency * 1000)
+	{
+		target = (budget - (uint64_t)control->latency * 1000) / (period + cost);
+	}
+	// Samples arriving while the interrupt waits must still fit in the FIFO
+	room = ((uint64_t)control->latency * 1000 + period - 1) / period + 1;
+	if (target + room > FIFO_SIZE)
+	{
+		target = (room < FIFO_SIZE) ? FIFO_SIZE - room : 0;
+	}
+	if (target > control->config.max_watermark)
+	{
+		target = control->config.max_watermark;
+	}
+	if (target < control->config.min_watermark)
+	{
+		target = control->config.min_watermark;
+	}
+	return (uint8_t)target;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Watermark Control 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the watermark controller. It starts at the minimum watermark and grows towards the target. The measured
+ * latency peak is forgotten after one to two windows, so without worst_latency the target is soft: a spike rarer than that can make a drain late.
+ * With worst_latency set to the bound of the system, no drain is late while the latency stays within it
+ *
+ * @param control Pointer to the controller
+ * @param config Pointer to the configuration
+ * @param rate Rate code written to BW_RATE (BANDWIDTH)
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Watermark_Init(t_Watermark *control, const t_WatermarkConfig *config, uint8_t rate)
+{
+	if (config->min_watermark == 0 || config->max_watermark >= FIFO_SIZE || config->min_watermark > config->max_watermark)
+	{
+		return ERR_PARAM;
+	}
+	control->config = *config;
+	control->watermark = config->min_watermark;
+	control->applied = 0;
+	control->clean = 0;
+	control->latency = config->worst_latency;
+	control->latency_current = 0;
+	control->latency_previous = 0;
+	control->read_cost = 0;
+	control->last_age = 0;
+	control->drains = 0;
+	control->overruns = 0;
+	control->late = 0;
+	Watermark_Set_Rate(control, rate);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that updates the sample period after Set_Bandwidth_Rate. A watermark above the new target is lowered at the next drain
+ *
+ * @param control Pointer to the controller
+ * @param rate Rate code (BANDWIDTH)
+ */
+void Watermark_Set_Rate(t_Watermark *control, uint8_t rate)
+{
+	control->period = Sample_Period_Ns(rate);
+	control->target = Watermark_Target(control);
+}
+
+/**
+ * @brief Function that updates the controller after each FIFO drain (AIMD): overruns and late samples halve the watermark,
+ * clean drains add one sample every WATERMARK_PROBE drains up to the target
+ *
+ * @param control Pointer to the controller
+ * @param int_source Interrupt source read before the drain
+ * @param entries Samples read by the drain
+ * @param latency Time from the interrupt to the start of the drain in us
+ * @param drain Time spent reading the samples in us
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watermark_Update(t_Watermark *control, const t_IntSource *int_source, uint8_t entries, uint32_t latency, uint32_t drain)
+{
+	uint8_t watermark = 0;
+	// Sliding peak over two windows: a rare latency spike keeps limiting the watermark until it has not been seen for a full window
+	if (control->drains % WATERMARK_WINDOW == 0)
+	{
+		control->latency_previous = control->latency_current;
+		control->latency_current = 0;
+	}
+	control->drains++;
+	control->latency_current = latency > control->latency_current ? latency : control->latency_current;
+	control->latency = control->latency_current > control->latency_previous ? control->latency_current : control->latency_previous;
+	control->latency = control->latency > control->config.worst_latency ? control->latency : control->config.worst_latency;
+	if (entries > 0)
+	{
+		// Per-sample drain cost, Q8, smoothed over 8 drains
+		control->read_cost += (int32_t)(((drain << 8) / entries) - control->read_cost) / 8;
+	}
+	// The interrupt fires with the watermark-th sample: the oldest one is (watermark - 1) periods older
+	watermark = control->applied ? control->applied : control->watermark;
+	control->last_age = (uint32_t)(((uint64_t)(watermark - 1) * control->period) / 1000) + latency + drain;
+	control->target = Watermark_Target(control);
+
+	if ((int_source && int_source->overrun) || control->last_age > control->config.max_age)
+	{
+		if (int_source && int_source->overrun)
+		{
+			control->overruns++;
+		}
+		else
+		{
+			control->late++;
+		}
+		control->watermark = control->watermark / 2 > control->config.min_watermark ? control->watermark / 2 : control->config.min_watermark;
+		control->clean = 0;
+	}
+	else if (control->watermark > control->target)
+	{
+		control->watermark = control->target;
+		control->clean = 0;
+	}
+	else if (control->watermark < control->target && ++control->clean >= WATERMARK_PROBE)
+	{
+		control->watermark++;
+		control->clean = 0;
+	}
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that writes the watermark to FIFO_CTL if it changed
+ *
+ * @param spi SPI interface
+ * @param control Pointer to the controller
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watermark_Apply(SPI_HandleTypeDef *spi, t_Watermark *control)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	if (control->watermark == control->applied)
+	{
+		ret_val = STATUS_OK_ADXL;
+	}
+	else if (Set_FIFO_Control(spi, control->config.mode, false, control->watermark))
+	{
+		ret_val = ERR_WRITE;
+	}
+	else
+	{
+		control->applied = control->watermark;
+	}
+	return ret_val;
+}
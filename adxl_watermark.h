@@ -0,0 +1,97 @@
+#ifndef ADXL_WATERMARK_H
+#define ADXL_WATERMARK_H
+
+#include "adxl.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#define WATERMARK_PROBE 			8 		// clean drains before the watermark grows by one sample
+#ifndef WATERMARK_WINDOW
+#define WATERMARK_WINDOW 			256 	// drains a latency peak is remembered for (between one and two windows)
+#endif
+
+typedef struct t_WatermarkConfig
+{
+	uint32_t max_age; 				// maximum age of a sample when its drain completes, in us
+	uint8_t min_watermark; 			// 1 - 31
+	uint8_t max_watermark; 			// 1 - 31
+	uint8_t mode; 					// FIFO_MODE written with the watermark (FIFO_STREAM or FIFO_FIFO)
+	uint32_t worst_latency; 		// worst-case interrupt latency in us the target always allows for, 0 to rely on the measured peak only
+} t_WatermarkConfig;
+
+typedef struct t_Watermark
+{
+	t_WatermarkConfig config;
+	uint32_t period; 				// sample period in ns
+	uint8_t watermark; 				// current setting
+	uint8_t applied; 				// setting last written by Watermark_Apply, 0 if never
+	uint8_t target; 				// largest watermark that meets the age target with the current estimates
+	uint8_t clean; 					// drains without overrun or late sample since the last change
+	uint32_t latency; 				// latency the target allows for in us: the larger of worst_latency and the peak of the last one to two windows
+	uint32_t latency_current; 		// peak of the window in progress
+	uint32_t latency_previous; 		// peak of the previous window
+	uint32_t read_cost; 			// drain time per sample in us, Q8
+	uint32_t last_age; 				// age of the oldest sample of the last drain in us
+	uint32_t drains;
+	uint32_t overruns;
+	uint32_t late; 					// drains whose oldest sample exceeded max_age
+} t_Watermark;
+
+/******************************************************************************************************************************************************************************/
+/*																				Watermark Control 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes the watermark controller. It starts at the minimum watermark and grows towards the target. The measured
+ * latency peak is forgotten after one to two windows, so without worst_latency the target is soft: a spike rarer than that can make a drain late.
+ * With worst_latency set to the bound of the system, no drain is late while the latency stays within it
+ *
+ * @param control Pointer to the controller
+ * @param config Pointer to the configuration
+ * @param rate Rate code written to BW_RATE (BANDWIDTH)
+ * @return STATUS_ADXL ERR_PARAM if the configuration is not valid
+ */
+STATUS_ADXL Watermark_Init(t_Watermark *control, const t_WatermarkConfig *config, uint8_t rate);
+
+/**
+ * @brief Function that updates the sample period after Set_Bandwidth_Rate. A watermark above the new target is lowered at the next drain
+ *
+ * @param control Pointer to the controller
+ * @param rate Rate code (BANDWIDTH)
+ */
+void Watermark_Set_Rate(t_Watermark *control, uint8_t rate);
+
+/**
+ * @brief Function that updates the controller after each FIFO drain (AIMD): overruns and late samples halve the watermark,
+ * clean drains add one sample every WATERMARK_PROBE drains up to the target
+ *
+ * @param control Pointer to the controller
+ * @param int_source Interrupt source read before the drain
+ * @param entries Samples read by the drain
+ * @param latency Time from the interrupt to the start of the drain in us
+ * @param drain Time spent reading the samples in us
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watermark_Update(t_Watermark *control, const t_IntSource *int_source, uint8_t entries, uint32_t latency, uint32_t drain);
+
+/**
+ * @brief Function that writes the watermark to FIFO_CTL if it changed
+ *
+ * @param spi SPI interface
+ * @param control Pointer to the controller
+ * @return STATUS_ADXL
+ */
+STATUS_ADXL Watermark_Apply(SPI_HandleTypeDef *spi, t_Watermark *control);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_WATERMARK_H */
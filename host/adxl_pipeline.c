@@ -0,0 +1,298 @@
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "adxl_pipeline.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that processes up to PIPELINE_BATCH blocks of a claimed stream
+ *
+ * @param stream Pointer to the stream
+ * @return uint32_t Blocks processed
+ */
+static uint32_t Pipeline_Drain(t_PipelineStream *stream)
+{
+	t_PipelineItem *item = NULL;
+	uint32_t tail = stream->tail;
+	uint32_t head = __atomic_load_n(&stream->head, __ATOMIC_ACQUIRE);
+	uint32_t done = 0;
+	uint8_t i = 0;
+	while (tail != head && done < PIPELINE_BATCH)
+	{
+		item = &stream->items[tail & (PIPELINE_QUEUE - 1)];
+		for (i = 0; i < stream->stages; i++)
+		{
+			if (stream->stage[i](&item->block, item->samples, &item->int_source, stream->state[i]) != STATUS_OK_ADXL)
+			{
+				stream->errors++;
+				break;
+			}
+		}
+		tail++;
+		done++;
+		// Give the slot back to the producer
+		__atomic_store_n(&stream->tail, tail, __ATOMIC_RELEASE);
+	}
+	stream->processed += done;
+	return done;
+}
+
+/**
+ * @brief Function that puts a worker to sleep until a push or Pipeline_Stop bumps the epoch past the value it read before its last scan
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param seen Epoch read before the scan that found no work
+ */
+static void Pipeline_Wait(t_Pipeline *pipeline, uint32_t seen)
+{
+	pthread_mutex_lock(&pipeline->lock);
+	// Announce the sleeper before checking the epoch, a push bumps the epoch before checking sleepers: one of the two sees the other
+	__atomic_add_fetch(&pipeline->sleepers, 1, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&pipeline->epoch, __ATOMIC_SEQ_CST) == seen && __atomic_load_n(&pipeline->running, __ATOMIC_ACQUIRE))
+	{
+		pipeline->waits++;
+		pthread_cond_wait(&pipeline->wake, &pipeline->lock);
+	}
+	__atomic_sub_fetch(&pipeline->sleepers, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&pipeline->lock);
+}
+
+/**
+ * @brief Function that bumps the epoch and wakes sleeping workers, taking the mutex only when one may be asleep
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param all true to wake every worker, false for one
+ */
+static void Pipeline_Wake(t_Pipeline *pipeline, bool all)
+{
+	__atomic_add_fetch(&pipeline->epoch, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&pipeline->sleepers, __ATOMIC_SEQ_CST) != 0)
+	{
+		// Taking the mutex orders the signal after a sleeper's epoch check: it is either awake already or inside pthread_cond_wait
+		pthread_mutex_lock(&pipeline->lock);
+		if (all)
+		{
+			pthread_cond_broadcast(&pipeline->wake);
+		}
+		else
+		{
+			pthread_cond_signal(&pipeline->wake);
+		}
+		pthread_mutex_unlock(&pipeline->lock);
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Processing Pipeline 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a pipeline over caller-allocated streams
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param streams Pointer to the streams
+ * @param count Number of streams
+ * @param workers Number of threads that will call Pipeline_Worker
+ * @return STATUS_ADXL ERR_PARAM if the counts are 0 or the mutex or condition variable cannot be created
+ */
+STATUS_ADXL Pipeline_Init(t_Pipeline *pipeline, t_PipelineStream *streams, uint16_t count, uint8_t workers)
+{
+	uint16_t s = 0;
+	uint8_t i = 0;
+	if (count == 0 || workers == 0)
+	{
+		return ERR_PARAM;
+	}
+	if (pthread_mutex_init(&pipeline->lock, NULL) != 0)
+	{
+		return ERR_PARAM;
+	}
+	if (pthread_cond_init(&pipeline->wake, NULL) != 0)
+	{
+		pthread_mutex_destroy(&pipeline->lock);
+		return ERR_PARAM;
+	}
+	for (s = 0; s < count; s++)
+	{
+		for (i = 0; i < PIPELINE_QUEUE; i++)
+		{
+			streams[s].items[i].block.samples = streams[s].items[i].samples;
+		}
+		streams[s].stages = 0;
+		streams[s].head = 0;
+		streams[s].tail = 0;
+		streams[s].claimed = 0;
+		streams[s].rejected = 0;
+		streams[s].processed = 0;
+		streams[s].errors = 0;
+	}
+	pipeline->streams = streams;
+	pipeline->count = count;
+	pipeline->workers = workers;
+	pipeline->epoch = 0;
+	pipeline->sleepers = 0;
+	pipeline->waits = 0;
+	__atomic_store_n(&pipeline->running, 1, __ATOMIC_RELEASE);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that appends a stage to a stream. Stages run in the order they were added. Call before the workers start
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param stream Stream number
+ * @param stage Stage function
+ * @param state Stage state (one per stream, only touched by the worker that holds the stream)
+ * @return STATUS_ADXL ERR_PARAM if the stream has PIPELINE_MAX_STAGES stages
+ */
+STATUS_ADXL Pipeline_Add_Stage(t_Pipeline *pipeline, uint16_t stream, PIPELINE_STAGE stage, void *state)
+{
+	t_PipelineStream *s = NULL;
+	if (stream >= pipeline->count || stage == NULL || pipeline->streams[stream].stages == PIPELINE_MAX_STAGES)
+	{
+		return ERR_PARAM;
+	}
+	s = &pipeline->streams[stream];
+	s->stage[s->stages] = stage;
+	s->state[s->stages] = state;
+	s->stages++;
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that queues a block on a stream (one producer thread per stream). The block is copied and a sleeping worker is woken
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param stream Stream number
+ * @param block Sample block (at most PIPELINE_BLOCK_SAMPLES samples)
+ * @param int_source Interrupt source of the block (NULL if not available)
+ * @return STATUS_ADXL ERR_BUSY if the queue is full (backpressure), ERR_PARAM if the block does not fit
+ */
+STATUS_ADXL Pipeline_Push(t_Pipeline *pipeline, uint16_t stream, const t_SampleBlock *block, const t_IntSource *int_source)
+{
+	t_PipelineStream *s = NULL;
+	t_PipelineItem *item = NULL;
+	uint32_t head = 0;
+	uint16_t i = 0;
+	if (stream >= pipeline->count || block->count > PIPELINE_BLOCK_SAMPLES)
+	{
+		return ERR_PARAM;
+	}
+	s = &pipeline->streams[stream];
+	head = s->head;
+	if (head - __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE) == PIPELINE_QUEUE)
+	{
+		s->rejected++;
+		return ERR_BUSY;
+	}
+	item = &s->items[head & (PIPELINE_QUEUE - 1)];
+	item->block.sequence = block->sequence;
+	item->block.timestamp = block->timestamp;
+	item->block.period = block->period;
+	item->block.count = block->count;
+	for (i = 0; i < block->count; i++)
+	{
+		item->samples[i] = block->samples[i];
+	}
+	if (int_source)
+	{
+		item->int_source = *int_source;
+	}
+	else
+	{
+		item->int_source = (t_IntSource){0};
+	}
+	// Publish the item after its content
+	__atomic_store_n(&s->head, head + 1, __ATOMIC_RELEASE);
+	Pipeline_Wake(pipeline, false);
+	return STATUS_OK_ADXL;
+}
+
+/**
+ * @brief Function that runs one scan: the worker's own share of streams first, then the others (work stealing). A stream is claimed
+ * before it is processed, so its blocks stay in order
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param worker Worker number (0 - workers-1)
+ * @return uint32_t Blocks processed
+ */
+uint32_t Pipeline_Run_Once(t_Pipeline *pipeline, uint8_t worker)
+{
+	t_PipelineStream *s = NULL;
+	uint32_t done = 0;
+	uint16_t start = (uint16_t)(((uint32_t)worker * pipeline->count) / pipeline->workers);
+	uint16_t n = 0;
+	uint16_t index = 0;
+	uint8_t expected = 0;
+	for (n = 0; n < pipeline->count; n++)
+	{
+		index = (uint16_t)((start + n) % pipeline->count);
+		s = &pipeline->streams[index];
+		// Cheap checks first: empty or already claimed streams are skipped without a locked operation
+		if (__atomic_load_n(&s->head, __ATOMIC_ACQUIRE) == __atomic_load_n(&s->tail, __ATOMIC_RELAXED) || __atomic_load_n(&s->claimed, __ATOMIC_RELAXED))
+		{
+			continue;
+		}
+		expected = 0;
+		if (__atomic_compare_exchange_n(&s->claimed, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		{
+			done += Pipeline_Drain(s);
+			__atomic_store_n(&s->claimed, 0, __ATOMIC_RELEASE);
+		}
+	}
+	return done;
+}
+
+/**
+ * @brief Function that is the body of a worker thread. It sleeps on the pipeline condition variable while there is no work and returns
+ * after Pipeline_Stop once the queues are empty
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param worker Worker number (0 - workers-1)
+ */
+void Pipeline_Worker(t_Pipeline *pipeline, uint8_t worker)
+{
+	uint32_t seen = 0;
+	uint8_t running = 1;
+	while (true)
+	{
+		// Read the epoch and the flag before the scan: a block pushed after them wakes the wait below, and an empty scan after
+		// Pipeline_Stop means no block can be left behind
+		seen = __atomic_load_n(&pipeline->epoch, __ATOMIC_SEQ_CST);
+		running = __atomic_load_n(&pipeline->running, __ATOMIC_ACQUIRE);
+		if (Pipeline_Run_Once(pipeline, worker) == 0)
+		{
+			if (!running)
+			{
+				break;
+			}
+			Pipeline_Wait(pipeline, seen);
+		}
+	}
+}
+
+/**
+ * @brief Function that asks the workers to finish the queued blocks and return, waking the ones that sleep
+ *
+ * @param pipeline Pointer to the pipeline
+ */
+void Pipeline_Stop(t_Pipeline *pipeline)
+{
+	__atomic_store_n(&pipeline->running, 0, __ATOMIC_RELEASE);
+	Pipeline_Wake(pipeline, true);
+}
+
+/**
+ * @brief Function that releases the mutex and condition variable of a pipeline whose workers have returned
+ *
+ * @param pipeline Pointer to the pipeline
+ */
+void Pipeline_Deinit(t_Pipeline *pipeline)
+{
+	pthread_cond_destroy(&pipeline->wake);
+	pthread_mutex_destroy(&pipeline->lock);
+}
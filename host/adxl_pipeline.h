@@ -0,0 +1,140 @@
+#ifndef ADXL_PIPELINE_H
+#define ADXL_PIPELINE_H
+
+#include "adxl_types.h"
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+#ifndef PIPELINE_QUEUE
+#define PIPELINE_QUEUE 				8 		// blocks queued per stream, power of two
+#endif
+#ifndef PIPELINE_BLOCK_SAMPLES
+#define PIPELINE_BLOCK_SAMPLES 		FIFO_SIZE
+#endif
+#define PIPELINE_MAX_STAGES 		4 		// decode, filter, features, detection
+#define PIPELINE_BATCH 				4 		// blocks a worker processes from one stream before it moves on
+#define PIPELINE_CACHE_LINE 		64
+
+/**
+ * @brief Function of one processing stage. samples is block->samples, writable so the stage can modify it in place; a status other than
+ * STATUS_OK_ADXL ends the chain for the block
+ */
+typedef STATUS_ADXL (*PIPELINE_STAGE)(const t_SampleBlock *block, t_Sample *samples, const t_IntSource *int_source, void *state);
+
+typedef struct t_PipelineItem
+{
+	t_SampleBlock block; 			// block.samples points to samples
+	t_Sample samples[PIPELINE_BLOCK_SAMPLES];
+	t_IntSource int_source;
+} t_PipelineItem;
+
+typedef struct t_PipelineStream
+{
+	t_PipelineItem items[PIPELINE_QUEUE];
+	PIPELINE_STAGE stage[PIPELINE_MAX_STAGES];
+	void *state[PIPELINE_MAX_STAGES];
+	uint8_t stages;
+	uint32_t head __attribute__((aligned(PIPELINE_CACHE_LINE))); // written by the producer only
+	uint32_t rejected; 				// blocks refused because the queue was full
+	uint32_t tail __attribute__((aligned(PIPELINE_CACHE_LINE))); // written by the worker that holds the claim
+	uint8_t claimed; 				// 1 while a worker processes the stream: blocks of a stream never run in parallel
+	uint32_t processed;
+	uint32_t errors; 				// blocks whose chain ended early
+} t_PipelineStream;
+
+typedef struct t_Pipeline
+{
+	t_PipelineStream *streams;
+	uint16_t count;
+	uint8_t workers;
+	uint8_t running;
+	uint32_t epoch; 				// bumped by every push and by Pipeline_Stop
+	uint32_t sleepers; 				// workers in Pipeline_Wait: a push only takes the mutex when one may be asleep
+	uint32_t waits; 				// times a worker went to sleep
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+} t_Pipeline;
+
+/******************************************************************************************************************************************************************************/
+/*																				Processing Pipeline 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that initializes a pipeline over caller-allocated streams
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param streams Pointer to the streams
+ * @param count Number of streams
+ * @param workers Number of threads that will call Pipeline_Worker
+ * @return STATUS_ADXL ERR_PARAM if the counts are 0 or the mutex or condition variable cannot be created
+ */
+STATUS_ADXL Pipeline_Init(t_Pipeline *pipeline, t_PipelineStream *streams, uint16_t count, uint8_t workers);
+
+/**
+ * @brief Function that appends a stage to a stream. Stages run in the order they were added. Call before the workers start
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param stream Stream number
+ * @param stage Stage function
+ * @param state Stage state (one per stream, only touched by the worker that holds the stream)
+ * @return STATUS_ADXL ERR_PARAM if the stream has PIPELINE_MAX_STAGES stages
+ */
+STATUS_ADXL Pipeline_Add_Stage(t_Pipeline *pipeline, uint16_t stream, PIPELINE_STAGE stage, void *state);
+
+/**
+ * @brief Function that queues a block on a stream (one producer thread per stream). The block is copied and a sleeping worker is woken
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param stream Stream number
+ * @param block Sample block (at most PIPELINE_BLOCK_SAMPLES samples)
+ * @param int_source Interrupt source of the block (NULL if not available)
+ * @return STATUS_ADXL ERR_BUSY if the queue is full (backpressure), ERR_PARAM if the block does not fit
+ */
+STATUS_ADXL Pipeline_Push(t_Pipeline *pipeline, uint16_t stream, const t_SampleBlock *block, const t_IntSource *int_source);
+
+/**
+ * @brief Function that runs one scan: the worker's own share of streams first, then the others (work stealing). A stream is claimed
+ * before it is processed, so its blocks stay in order
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param worker Worker number (0 - workers-1)
+ * @return uint32_t Blocks processed
+ */
+uint32_t Pipeline_Run_Once(t_Pipeline *pipeline, uint8_t worker);
+
+/**
+ * @brief Function that is the body of a worker thread. It sleeps on the pipeline condition variable while there is no work and returns
+ * after Pipeline_Stop once the queues are empty
+ *
+ * @param pipeline Pointer to the pipeline
+ * @param worker Worker number (0 - workers-1)
+ */
+void Pipeline_Worker(t_Pipeline *pipeline, uint8_t worker);
+
+/**
+ * @brief Function that asks the workers to finish the queued blocks and return, waking the ones that sleep
+ *
+ * @param pipeline Pointer to the pipeline
+ */
+void Pipeline_Stop(t_Pipeline *pipeline);
+
+/**
+ * @brief Function that releases the mutex and condition variable of a pipeline whose workers have returned
+ *
+ * @param pipeline Pointer to the pipeline
+ */
+void Pipeline_Deinit(t_Pipeline *pipeline);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_PIPELINE_H */
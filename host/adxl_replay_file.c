@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "adxl_replay_file.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Mapped Recording 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that maps a recording and indexes it with Replay_Open. With index NULL the index is allocated for the file size, so it
+ * keeps at most REPLAY_FILE_STRIDE blocks between entries and a seek stays O(log n) however long the recording is
+ *
+ * @param file Pointer to the mapped recording
+ * @param path Path of the recording (adxl_log.h block format, at most 4 GiB)
+ * @param index Pointer to the index array, NULL to allocate one
+ * @param index_size Number of entries of the index array (at least 2), ignored when index is NULL
+ * @return STATUS_ADXL ERR_PARAM if the file cannot be opened, mapped or indexed, ERR_READING if it has no valid block
+ */
+STATUS_ADXL Replay_File_Open(t_ReplayFile *file, const char *path, t_ReplayEntry *index, uint32_t index_size)
+{
+	STATUS_ADXL ret_val = STATUS_OK_ADXL;
+	struct stat info;
+	void *map = MAP_FAILED;
+	int fd = open(path, O_RDONLY);
+
+	file->map = NULL;
+	file->size = 0;
+	file->owned = NULL;
+	if (fd < 0)
+	{
+		return ERR_PARAM;
+	}
+	if (fstat(fd, &info) != 0 || info.st_size == 0 || (uint64_t)info.st_size > UINT32_MAX)
+	{
+		ret_val = ERR_PARAM;
+	}
+	else
+	{
+		map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		ret_val = (map == MAP_FAILED) ? ERR_PARAM : STATUS_OK_ADXL;
+	}
+	// The mapping keeps the file referenced on its own
+	close(fd);
+	if (ret_val == STATUS_OK_ADXL)
+	{
+		file->map = (const uint8_t *)map;
+		file->size = (uint32_t)info.st_size;
+		if (index == NULL)
+		{
+			// Sized for the smallest possible blocks (one sample each), so the stride never grows past REPLAY_FILE_STRIDE
+			index_size = file->size / (LOG_HEADER_SIZE + 6 + LOG_CRC_SIZE) / REPLAY_FILE_STRIDE + 2;
+			file->owned = (t_ReplayEntry *)malloc((size_t)index_size * sizeof(t_ReplayEntry));
+			index = file->owned;
+		}
+		ret_val = (index == NULL) ? ERR_PARAM : Replay_Open(&file->replay, file->map, file->size, index, index_size);
+		if (ret_val != STATUS_OK_ADXL)
+		{
+			Replay_File_Close(file);
+		}
+	}
+	return ret_val;
+}
+
+/**
+ * @brief Function that unmaps a recording and frees the index it allocated
+ *
+ * @param file Pointer to the mapped recording
+ */
+void Replay_File_Close(t_ReplayFile *file)
+{
+	if (file->map != NULL)
+	{
+		munmap((void *)file->map, file->size);
+		file->map = NULL;
+		file->size = 0;
+	}
+	free(file->owned);
+	file->owned = NULL;
+}
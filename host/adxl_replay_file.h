@@ -0,0 +1,59 @@
+#ifndef ADXL_REPLAY_FILE_H
+#define ADXL_REPLAY_FILE_H
+
+#include "adxl_replay.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Host side of adxl_replay: the recording is mapped read-only with mmap and handed to Replay_Open as it is, so the
+ * file is never copied or read ahead; the page cache serves the blocks the replay touches.
+ */
+
+#ifndef REPLAY_FILE_STRIDE
+#define REPLAY_FILE_STRIDE 			16 		// most blocks between two entries of an index allocated by Replay_File_Open
+#endif
+
+typedef struct t_ReplayFile
+{
+	t_Replay replay;
+	const uint8_t *map; 			// mapping of the whole file, NULL when closed
+	uint32_t size;
+	t_ReplayEntry *owned; 			// index allocated by Replay_File_Open, NULL when the caller provided one
+} t_ReplayFile;
+
+/******************************************************************************************************************************************************************************/
+/*																				Mapped Recording 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that maps a recording and indexes it with Replay_Open. With index NULL the index is allocated for the file size, so it
+ * keeps at most REPLAY_FILE_STRIDE blocks between entries and a seek stays O(log n) however long the recording is
+ *
+ * @param file Pointer to the mapped recording
+ * @param path Path of the recording (adxl_log.h block format, at most 4 GiB)
+ * @param index Pointer to the index array, NULL to allocate one
+ * @param index_size Number of entries of the index array (at least 2), ignored when index is NULL
+ * @return STATUS_ADXL ERR_PARAM if the file cannot be opened, mapped or indexed, ERR_READING if it has no valid block
+ */
+STATUS_ADXL Replay_File_Open(t_ReplayFile *file, const char *path, t_ReplayEntry *index, uint32_t index_size);
+
+/**
+ * @brief Function that unmaps a recording and frees the index it allocated
+ *
+ * @param file Pointer to the mapped recording
+ */
+void Replay_File_Close(t_ReplayFile *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_REPLAY_FILE_H */
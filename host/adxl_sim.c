@@ -0,0 +1,763 @@
+#include "adxl_sim.h"
+#include "adxl.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal State 																			  */
+/******************************************************************************************************************************************************************************/
+
+#define SIM_POWER_MEASURE 			0x08
+#define SIM_ACT_ENABLE 				0x10
+#define SIM_INACT_ENABLE 			0x08
+#define SIM_THRESHOLD_UG 			15625 	// THRESH_ACT/THRESH_INACT scale
+
+static GPIO_TypeDef gpio_b;
+static DWT_Type dwt;
+static CoreDebug_Type core_debug;
+GPIO_TypeDef *GPIOB = &gpio_b;
+DWT_Type *DWT = &dwt;
+CoreDebug_Type *CoreDebug = &core_debug;
+
+static t_SimConfig sim_config;
+static t_SimStats sim_stats;
+static uint64_t now;
+static uint64_t edge_time;
+static uint32_t random_state;
+
+static uint8_t regs[64];
+static t_Sample fifo[FIFO_SIZE];
+static uint8_t fifo_head;
+static uint8_t fifo_entries;
+static bool unread; 						// bypass mode: the data registers hold a sample that was not read
+static bool overrun;
+static bool activity;
+static bool inactivity;
+static bool triggered;
+static int32_t reference[3]; 			// ac-coupled activity reference in ug
+static uint64_t quiet_since; 			// start of the current below-THRESH_INACT period
+static uint64_t next_sample; 			// ps
+static uint64_t period; 				// ps
+
+static volatile uint32_t cs_low;
+static uint8_t command; 				// first byte of the open transaction, 0 before it
+static uint8_t address;
+static bool data_read; 					// the open transaction read the data registers
+
+static SPI_HandleTypeDef *it_spi;
+static uint64_t it_done; 				// completion time of the interrupt-driven transfer, 0 when idle
+static uint32_t fail_receive; 			// receive calls until the injected failure, counting the failing one, 0 when none
+static uint32_t fail_transmit; 			// same for transmit calls
+
+/******************************************************************************************************************************************************************************/
+/*																				 Internal Functions 																		  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that returns the sample period in ps for the current BW_RATE and oscillator error
+ *
+ * @return uint64_t
+ */
+static uint64_t Sim_Period(void)
+{
+	uint8_t rate = regs[BW_RATE] & 0x0F;
+	uint64_t nominal = 0;
+	if (rate < 0x06)
+	{
+		rate = 0x06;
+	}
+	nominal = 312500000ULL << (0x0F - rate); // 3200 Hz at 0x0F, halved per code
+	return (nominal * 1000000ULL) / (uint64_t)(1000000 + sim_config.ppm);
+}
+
+/**
+ * @brief Function that converts an acceleration to the output format selected by DATA_FORMAT
+ *
+ * @param ug Acceleration in ug
+ * @return int16_t
+ */
+static int16_t Sim_Format(int32_t ug)
+{
+	uint8_t format = regs[DATA_FORMAT];
+	uint8_t range = format & 0x03;
+	bool full_res = (format & 0x08) != 0;
+	int32_t lsb_per_g = full_res ? 1024 : (1024 >> range);
+	int32_t limit = 512 << (full_res ? range : 0);
+	int64_t counts = ((int64_t)ug * lsb_per_g + (ug >= 0 ? 500000 : -500000)) / 1000000;
+	if (counts > limit - 1)
+	{
+		counts = limit - 1;
+	}
+	else if (counts < -limit)
+	{
+		counts = -limit;
+	}
+	if (format & 0x04)
+	{
+		counts *= 1 << (6 - (full_res ? range : 0)); // left justified: MSB of the result at bit 15
+	}
+	return (int16_t)counts;
+}
+
+/**
+ * @brief Function that returns the current INT_SOURCE value
+ *
+ * @return uint8_t
+ */
+static uint8_t Sim_Int_Source(void)
+{
+	uint8_t mode = regs[FIFO_CTL] >> 6;
+	uint8_t watermark = regs[FIFO_CTL] & 0x1F;
+	uint8_t source = 0;
+	if (mode == FIFO_BYPASS ? unread : fifo_entries > 0)
+	{
+		source |= 1 << DATA_READY_BIT;
+	}
+	if (activity)
+	{
+		source |= 1 << ACTIVITY_BIT;
+	}
+	if (inactivity)
+	{
+		source |= 1 << INACTIVITY_BIT;
+	}
+	if (mode != FIFO_BYPASS && fifo_entries >= watermark)
+	{
+		source |= 1 << WATERMARK_BIT;
+	}
+	if (overrun)
+	{
+		source |= 1 << OVERRUN_BIT;
+	}
+	return source;
+}
+
+/**
+ * @brief Function that stores a converted sample according to the FIFO mode
+ *
+ * @param sample Sample
+ */
+static void Sim_Store(const t_Sample *sample)
+{
+	uint8_t mode = regs[FIFO_CTL] >> 6;
+	bool keep_oldest = (mode == FIFO_FIFO) || (mode == FIFO_TRIGGER && triggered);
+	if (mode == FIFO_BYPASS)
+	{
+		if (unread)
+		{
+			overrun = true;
+			sim_stats.lost++;
+		}
+		fifo[0] = *sample;
+		fifo_head = 0;
+		unread = true;
+		return;
+	}
+	if (fifo_entries == FIFO_SIZE)
+	{
+		overrun = true;
+		sim_stats.lost++;
+		if (keep_oldest)
+		{
+			return;
+		}
+		fifo_head = (fifo_head + 1) % FIFO_SIZE;
+		fifo_entries--;
+	}
+	fifo[(fifo_head + fifo_entries) % FIFO_SIZE] = *sample;
+	fifo_entries++;
+}
+
+/**
+ * @brief Function that starts trigger mode collection: the FIFO keeps the newest FIFO_CTL samples and fills up from there
+ */
+static void Sim_Trigger(void)
+{
+	uint8_t keep = regs[FIFO_CTL] & 0x1F;
+	if (triggered)
+	{
+		return;
+	}
+	triggered = true;
+	while (fifo_entries > keep)
+	{
+		fifo_head = (fifo_head + 1) % FIFO_SIZE;
+		fifo_entries--;
+	}
+}
+
+/**
+ * @brief Function that runs the activity and inactivity functions on a new sample
+ *
+ * @param ug Acceleration in ug
+ */
+static void Sim_Detect(const int32_t ug[3])
+{
+	uint8_t control = regs[ACT_INACT_CNT];
+	int64_t act = (int64_t)regs[THRESHOLD_ACTIVITY] * SIM_THRESHOLD_UG;
+	int64_t inact = (int64_t)regs[THRESHOLD_INACTIVITY] * SIM_THRESHOLD_UG;
+	bool above = false;
+	bool quiet = true;
+	int64_t delta = 0;
+	uint8_t axis = 0;
+	for (axis = 0; axis < 3; axis++)
+	{
+		delta = (control & 0x80) ? (int64_t)ug[axis] - reference[axis] : ug[axis];
+		if ((control & (0x40 >> axis)) && (delta > act || -delta > act))
+		{
+			above = true;
+		}
+		delta = (control & 0x08) ? (int64_t)ug[axis] - reference[axis] : ug[axis];
+		if ((control & (0x04 >> axis)) && (delta > inact || -delta > inact))
+		{
+			quiet = false;
+		}
+	}
+	if (above && (regs[INTERRUPT_ENABLE] & SIM_ACT_ENABLE) && !activity)
+	{
+		activity = true;
+		for (axis = 0; axis < 3; axis++)
+		{
+			reference[axis] = ug[axis];
+		}
+		if ((regs[FIFO_CTL] >> 6) == FIFO_TRIGGER && ((regs[INTERRUPT_MAP] >> ACTIVITY_BIT) & 1) == ((regs[FIFO_CTL] >> 5) & 1))
+		{
+			Sim_Trigger();
+		}
+	}
+	if (!quiet || !(control & 0x07))
+	{
+		quiet_since = now;
+	}
+	else if ((regs[INTERRUPT_ENABLE] & SIM_INACT_ENABLE) && !inactivity && now - quiet_since >= (uint64_t)regs[TIME_INACTIVITY] * 1000000000ULL)
+	{
+		inactivity = true;
+		for (axis = 0; axis < 3; axis++)
+		{
+			reference[axis] = ug[axis];
+		}
+	}
+}
+
+/**
+ * @brief Function that converts one sample at the current time
+ */
+static void Sim_Convert(void)
+{
+	int32_t ug[3] = {0, 0, 1000000};
+	t_Sample sample;
+	if (sim_config.signal)
+	{
+		sim_config.signal(now, ug, sim_config.arg);
+	}
+	sample.x = Sim_Format(ug[0]);
+	sample.y = Sim_Format(ug[1]);
+	sample.z = Sim_Format(ug[2]);
+	sim_stats.samples++;
+	// Detection first, so a trigger keeps the history before this sample and this one becomes the first after it
+	Sim_Detect(ug);
+	Sim_Store(&sample);
+}
+
+/**
+ * @brief Function that pops the oldest FIFO entry after a data register read
+ */
+static void Sim_Pop(void)
+{
+	if ((regs[FIFO_CTL] >> 6) == FIFO_BYPASS)
+	{
+		unread = false;
+	}
+	else if (fifo_entries > 0)
+	{
+		fifo_head = (fifo_head + 1) % FIFO_SIZE;
+		fifo_entries--;
+	}
+	overrun = false;
+}
+
+/**
+ * @brief Function that applies the side effects of a register write
+ *
+ * @param reg Register address
+ * @param value Value
+ */
+static void Sim_Write(uint8_t reg, uint8_t value)
+{
+	uint8_t previous = regs[reg];
+	switch (reg)
+	{
+	case SOFT_RESET:
+		if (value == 0x52)
+		{
+			// Registers and FIFO go back to power-on, the clock and the open transaction carry on
+			t_SimConfig config = sim_config;
+			uint64_t time = now;
+			t_SimStats stats = sim_stats;
+			uint8_t open = command;
+			Sim_Init(&config);
+			now = time;
+			dwt.CYCCNT = (uint32_t)now;
+			sim_stats = stats;
+			cs_low = 1;
+			command = open;
+		}
+		return;
+	case DEVID_0:
+	case DEVID_1:
+	case PARTID:
+	case REVID:
+	case XID:
+	case INT_SOURCE:
+	case FIFO_STATUS:
+		return;
+	default:
+		break;
+	}
+	if (reg >= MEASUREMENTS_DATA && reg < MEASUREMENTS_DATA + 6)
+	{
+		return;
+	}
+	regs[reg] = value;
+	if (reg == FIFO_CTL && (value >> 6) == FIFO_BYPASS)
+	{
+		fifo_entries = 0;
+		fifo_head = 0;
+		triggered = false;
+	}
+	if (reg == BW_RATE)
+	{
+		period = Sim_Period();
+	}
+	if (reg == PWR_CNTRL && (value & SIM_POWER_MEASURE) && !(previous & SIM_POWER_MEASURE))
+	{
+		next_sample = now * 1000 + period;
+	}
+	if (reg == INTERRUPT_ENABLE && (value & SIM_ACT_ENABLE) && !(previous & SIM_ACT_ENABLE))
+	{
+		activity = false;
+	}
+}
+
+/**
+ * @brief Function that exchanges one byte of the open transaction
+ *
+ * @param byte Byte from the master
+ * @return uint8_t Byte to the master
+ */
+static uint8_t Sim_Exchange(uint8_t byte)
+{
+	uint8_t out = 0;
+	const t_Sample *head = &fifo[fifo_head];
+	sim_stats.bytes++;
+	if (command == 0)
+	{
+		command = byte | 0x01; // never 0 once the command byte is in
+		address = byte & 0x3F;
+		return 0;
+	}
+	if (command & 0x80)
+	{
+		switch (address)
+		{
+		case INT_SOURCE:
+			out = Sim_Int_Source();
+			activity = false;
+			inactivity = false;
+			break;
+		case FIFO_STATUS:
+			out = (uint8_t)((triggered ? 0x80 : 0x00) | (((regs[FIFO_CTL] >> 6) == FIFO_BYPASS) ? (unread ? 1 : 0) : fifo_entries));
+			break;
+		case MEASUREMENTS_DATA:
+			out = (uint8_t)head->x;
+			break;
+		case MEASUREMENTS_DATA + 1:
+			out = (uint8_t)((uint16_t)head->x >> 8);
+			break;
+		case MEASUREMENTS_DATA + 2:
+			out = (uint8_t)head->y;
+			break;
+		case MEASUREMENTS_DATA + 3:
+			out = (uint8_t)((uint16_t)head->y >> 8);
+			break;
+		case MEASUREMENTS_DATA + 4:
+			out = (uint8_t)head->z;
+			break;
+		case MEASUREMENTS_DATA + 5:
+			out = (uint8_t)((uint16_t)head->z >> 8);
+			break;
+		default:
+			out = regs[address & 0x3F];
+			break;
+		}
+		if (address >= MEASUREMENTS_DATA && address < MEASUREMENTS_DATA + 6)
+		{
+			data_read = true;
+		}
+	}
+	else
+	{
+		Sim_Write(address, byte);
+	}
+	if (command & 0x40)
+	{
+		address = (address + 1) & 0x3F;
+	}
+	return out;
+}
+
+/**
+ * @brief Function that returns the bus time of a number of bytes
+ *
+ * @param bytes Number of bytes
+ * @return uint64_t Time in ns
+ */
+static uint64_t Sim_Bus_Time(uint32_t bytes)
+{
+	return ((uint64_t)bytes * 8ULL * 1000000000ULL) / sim_config.bus_hz;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Simulated Sensor 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that resets the sensor to its power-on registers and the clock to 0
+ *
+ * @param config Bus, jitter, oscillator and signal settings
+ */
+void Sim_Init(const t_SimConfig *config)
+{
+	uint8_t i = 0;
+	sim_config = *config;
+	if (sim_config.bus_hz == 0)
+	{
+		sim_config.bus_hz = 5000000;
+	}
+	random_state = sim_config.seed ? sim_config.seed : 0x2545F491;
+	fail_receive = 0;
+	fail_transmit = 0;
+	for (i = 0; i < sizeof(regs); i++)
+	{
+		regs[i] = 0;
+	}
+	regs[DEVID_0] = 0xAD;
+	regs[DEVID_1] = 0x1D;
+	regs[PARTID] = 0xCB;
+	regs[REVID] = 0x02;
+	regs[BW_RATE] = 0x0A;
+	sim_stats = (t_SimStats){0};
+	now = 0;
+	dwt.CYCCNT = 0;
+	edge_time = 0;
+	fifo_head = 0;
+	fifo_entries = 0;
+	unread = false;
+	overrun = false;
+	activity = false;
+	inactivity = false;
+	triggered = false;
+	reference[0] = reference[1] = reference[2] = 0;
+	quiet_since = 0;
+	period = Sim_Period();
+	next_sample = 0;
+	cs_low = 0;
+	command = 0;
+	data_read = false;
+	it_spi = NULL;
+	it_done = 0;
+}
+
+/**
+ * @brief Function that returns the simulated time
+ *
+ * @return uint64_t Time in ns
+ */
+uint64_t Sim_Now(void)
+{
+	return now;
+}
+
+/**
+ * @brief Function that advances the simulated time. Samples are converted and interrupt-driven transfers complete on the way
+ *
+ * @param time Absolute time in ns
+ */
+void Sim_Run_Until(uint64_t time)
+{
+	uint64_t sample_time = 0;
+	SPI_HandleTypeDef *spi = NULL;
+	while (now < time)
+	{
+		sample_time = (regs[PWR_CNTRL] & SIM_POWER_MEASURE) ? next_sample / 1000 : UINT64_MAX;
+		if (it_done != 0 && it_done <= time && it_done <= sample_time)
+		{
+			now = it_done;
+			dwt.CYCCNT = (uint32_t)now;
+			it_done = 0;
+			spi = it_spi;
+			it_spi = NULL;
+			sim_stats.cpu_time += sim_config.isr_ns;
+			HAL_SPI_TxRxCpltCallback(spi);
+		}
+		else if (sample_time <= time)
+		{
+			now = sample_time > now ? sample_time : now;
+			next_sample += period;
+			Sim_Convert();
+		}
+		else
+		{
+			now = time;
+		}
+	}
+	dwt.CYCCNT = (uint32_t)now;
+}
+
+/**
+ * @brief Function that returns the completion time of the interrupt-driven transfer in flight
+ *
+ * @return uint64_t Time in ns, 0 when no transfer is in flight
+ */
+uint64_t Sim_Transfer_End(void)
+{
+	return it_done;
+}
+
+/**
+ * @brief Function that returns the level of an interrupt line
+ *
+ * @param pin SIM_INT1 or SIM_INT2
+ * @return bool true while an enabled source mapped to the pin is set
+ */
+bool Sim_Interrupt_Line(uint8_t pin)
+{
+	uint8_t active = Sim_Int_Source() & regs[INTERRUPT_ENABLE];
+	uint8_t mapped = pin == SIM_INT2 ? regs[INTERRUPT_MAP] : (uint8_t)~regs[INTERRUPT_MAP];
+	return (active & mapped) != 0;
+}
+
+/**
+ * @brief Function that advances the time until an interrupt line is set, plus the configured entry jitter for a new edge
+ *
+ * @param pin SIM_INT1 or SIM_INT2
+ * @param timeout Maximum wait in ns
+ * @return bool false on timeout
+ */
+bool Sim_Wait_Interrupt(uint8_t pin, uint64_t timeout)
+{
+	uint64_t deadline = now + timeout;
+	uint64_t step = 0;
+	if (Sim_Interrupt_Line(pin))
+	{
+		// Level still set from before: the handler runs again straight away
+		edge_time = now;
+		sim_stats.interrupts++;
+		return true;
+	}
+	while (now < deadline)
+	{
+		// Lines only change on a conversion or a transfer completion: step to the next one
+		step = (regs[PWR_CNTRL] & SIM_POWER_MEASURE) ? next_sample / 1000 : deadline;
+		if (it_done != 0 && it_done < step)
+		{
+			step = it_done;
+		}
+		if (step <= now)
+		{
+			step = now + 1;
+		}
+		Sim_Run_Until(step < deadline ? step : deadline);
+		if (Sim_Interrupt_Line(pin))
+		{
+			edge_time = now;
+			if (sim_config.jitter_ns)
+			{
+				Sim_Run_Until(now + Sim_Random() % (sim_config.jitter_ns + 1));
+			}
+			sim_stats.interrupts++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @brief Function that returns the time of the rising edge behind the last Sim_Wait_Interrupt, before the jitter
+ *
+ * @return uint64_t Time in ns
+ */
+uint64_t Sim_Edge_Time(void)
+{
+	return edge_time;
+}
+
+/**
+ * @brief Function that reads a register without side effects or bus time
+ *
+ * @param address Register address
+ * @return uint8_t
+ */
+uint8_t Sim_Peek(uint8_t address)
+{
+	return regs[address & 0x3F];
+}
+
+/**
+ * @brief Function that writes a register without bus time, as a brown-out or ESD event would
+ *
+ * @param address Register address
+ * @param value Value
+ */
+void Sim_Poke(uint8_t address, uint8_t value)
+{
+	Sim_Write(address & 0x3F, value);
+}
+
+/**
+ * @brief Function that makes a later HAL_SPI_Receive fail with HAL_TIMEOUT, as a stalled bus would. The failing call shifts the first half
+ * of its bytes and leaves 0xFF in the rest of the buffer
+ *
+ * @param calls Receive calls that still succeed before the failing one
+ */
+void Sim_Fail_Receive(uint32_t calls)
+{
+	fail_receive = calls + 1;
+}
+
+/**
+ * @brief Function that makes a later HAL_SPI_Transmit fail with HAL_TIMEOUT before any byte reaches the sensor, so a register write is lost
+ *
+ * @param calls Transmit calls that still succeed before the failing one
+ */
+void Sim_Fail_Transmit(uint32_t calls)
+{
+	fail_transmit = calls + 1;
+}
+
+/**
+ * @brief Function that returns a pseudo-random number from the simulation generator
+ *
+ * @return uint32_t
+ */
+uint32_t Sim_Random(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return random_state;
+}
+
+/**
+ * @brief Function that returns the counters
+ *
+ * @param stats Pointer to the counters
+ */
+void Sim_Get_Stats(t_SimStats *stats)
+{
+	*stats = sim_stats;
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				HAL Stub 																					  */
+/******************************************************************************************************************************************************************************/
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	(void)GPIOx;
+	if (GPIO_Pin != CS_Pin)
+	{
+		return;
+	}
+	if (PinState == GPIO_PIN_RESET)
+	{
+		if (__atomic_exchange_n(&cs_low, 1, __ATOMIC_ACQ_REL))
+		{
+			__atomic_fetch_add(&sim_stats.interleaved, 1, __ATOMIC_RELAXED);
+		}
+		command = 0;
+		data_read = false;
+		sim_stats.transactions++;
+	}
+	else
+	{
+		if (data_read)
+		{
+			Sim_Pop();
+		}
+		command = 0;
+		data_read = false;
+		__atomic_store_n(&cs_low, 0, __ATOMIC_RELEASE);
+	}
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+	uint16_t i = 0;
+	uint64_t cost = sim_config.call_ns + Sim_Bus_Time(Size);
+	(void)hspi;
+	(void)Timeout;
+	if (fail_transmit != 0 && --fail_transmit == 0)
+	{
+		Sim_Run_Until(now + cost);
+		return HAL_TIMEOUT;
+	}
+	for (i = 0; i < Size; i++)
+	{
+		(void)Sim_Exchange(pData[i]);
+	}
+	sim_stats.bus_time += Sim_Bus_Time(Size);
+	sim_stats.cpu_time += cost;
+	Sim_Run_Until(now + cost);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+	uint16_t i = 0;
+	uint64_t cost = sim_config.call_ns + Sim_Bus_Time(Size);
+	(void)hspi;
+	(void)Timeout;
+	if (fail_receive != 0 && --fail_receive == 0)
+	{
+		for (i = 0; i < Size; i++)
+		{
+			pData[i] = (i < Size / 2) ? Sim_Exchange(0x00) : 0xFF;
+		}
+		Sim_Run_Until(now + cost);
+		return HAL_TIMEOUT;
+	}
+	for (i = 0; i < Size; i++)
+	{
+		pData[i] = Sim_Exchange(0x00);
+	}
+	sim_stats.bus_time += Sim_Bus_Time(Size);
+	sim_stats.cpu_time += cost;
+	Sim_Run_Until(now + cost);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size)
+{
+	uint16_t i = 0;
+	if (it_done != 0)
+	{
+		return HAL_BUSY;
+	}
+	for (i = 0; i < Size; i++)
+	{
+		pRxData[i] = Sim_Exchange(pTxData[i]);
+	}
+	sim_stats.bus_time += Sim_Bus_Time(Size);
+	it_spi = hspi;
+	it_done = now + Sim_Bus_Time(Size) + 1;
+	return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void)
+{
+	return (uint32_t)(now / 1000000ULL);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+	Sim_Run_Until(now + (uint64_t)Delay * 1000000ULL);
+}
@@ -0,0 +1,162 @@
+#ifndef ADXL_SIM_H
+#define ADXL_SIM_H
+
+#include "main.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Registers and Variables 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Simulated ADXL313 behind the host HAL stub. It models the register file, the output data rate with an oscillator
+ * error, DATA_FORMAT scaling, the 32-entry FIFO in its four modes (with watermark, overrun and trigger), DC/AC
+ * activity, the INT1/INT2 lines with interrupt entry jitter, and the SPI bus time of every byte.
+ *
+ * Time is simulated in ns. Blocking HAL calls advance it by the bus time of their bytes plus a fixed per-call cost;
+ * interrupt-driven transfers complete later, from Sim_Run_Until, through HAL_SPI_TxRxCpltCallback. Nothing runs in
+ * real time, so results only depend on the configuration and the seed. DWT->CYCCNT follows the simulated time (one cycle
+ * per ns), so LATENCY_NOW reads it unchanged.
+ */
+
+#define SIM_INT1 					0
+#define SIM_INT2 					1
+
+typedef void (*SIM_SIGNAL)(uint64_t time, int32_t acceleration[3], void *arg); // time in ns, acceleration in ug
+
+typedef struct t_SimConfig
+{
+	uint32_t bus_hz; 				// SPI clock
+	uint32_t call_ns; 				// fixed cost of each blocking HAL_SPI_Transmit/Receive call
+	uint32_t isr_ns; 				// CPU cost of each transfer complete interrupt
+	uint32_t jitter_ns; 			// interrupt entry delay, uniform in 0..jitter_ns
+	int32_t ppm; 					// sensor oscillator error
+	uint32_t seed;
+	SIM_SIGNAL signal; 				// NULL: 1 g on Z
+	void *arg;
+} t_SimConfig;
+
+typedef struct t_SimStats
+{
+	uint32_t transactions; 			// CS assertions
+	uint32_t bytes;
+	uint64_t bus_time; 				// ns spent shifting bytes
+	uint64_t cpu_time; 				// ns the CPU spent in blocking calls and transfer interrupts
+	uint32_t samples; 				// converted samples
+	uint32_t lost; 					// samples dropped or replaced before they were read
+	uint32_t interrupts; 			// interrupt entries returned by Sim_Wait_Interrupt
+	uint32_t interleaved; 			// CS asserted while another transaction was open
+} t_SimStats;
+
+/******************************************************************************************************************************************************************************/
+/*																				Simulated Sensor 																			  */
+/******************************************************************************************************************************************************************************/
+
+/**
+ * @brief Function that resets the sensor to its power-on registers and the clock to 0
+ *
+ * @param config Bus, jitter, oscillator and signal settings
+ */
+void Sim_Init(const t_SimConfig *config);
+
+/**
+ * @brief Function that returns the simulated time
+ *
+ * @return uint64_t Time in ns
+ */
+uint64_t Sim_Now(void);
+
+/**
+ * @brief Function that advances the simulated time. Samples are converted and interrupt-driven transfers complete on the way
+ *
+ * @param time Absolute time in ns
+ */
+void Sim_Run_Until(uint64_t time);
+
+/**
+ * @brief Function that returns the completion time of the interrupt-driven transfer in flight
+ *
+ * @return uint64_t Time in ns, 0 when no transfer is in flight
+ */
+uint64_t Sim_Transfer_End(void);
+
+/**
+ * @brief Function that returns the level of an interrupt line
+ *
+ * @param pin SIM_INT1 or SIM_INT2
+ * @return bool true while an enabled source mapped to the pin is set
+ */
+bool Sim_Interrupt_Line(uint8_t pin);
+
+/**
+ * @brief Function that advances the time until an interrupt line is set, plus the configured entry jitter for a new edge
+ *
+ * @param pin SIM_INT1 or SIM_INT2
+ * @param timeout Maximum wait in ns
+ * @return bool false on timeout
+ */
+bool Sim_Wait_Interrupt(uint8_t pin, uint64_t timeout);
+
+/**
+ * @brief Function that returns the time of the rising edge behind the last Sim_Wait_Interrupt, before the jitter
+ *
+ * @return uint64_t Time in ns
+ */
+uint64_t Sim_Edge_Time(void);
+
+/**
+ * @brief Function that reads a register without side effects or bus time
+ *
+ * @param address Register address
+ * @return uint8_t
+ */
+uint8_t Sim_Peek(uint8_t address);
+
+/**
+ * @brief Function that writes a register without bus time, as a brown-out or ESD event would
+ *
+ * @param address Register address
+ * @param value Value
+ */
+void Sim_Poke(uint8_t address, uint8_t value);
+
+/**
+ * @brief Function that makes a later HAL_SPI_Receive fail with HAL_TIMEOUT, as a stalled bus would. The failing call shifts the first half
+ * of its bytes and leaves 0xFF in the rest of the buffer
+ *
+ * @param calls Receive calls that still succeed before the failing one
+ */
+void Sim_Fail_Receive(uint32_t calls);
+
+/**
+ * @brief Function that makes a later HAL_SPI_Transmit fail with HAL_TIMEOUT before any byte reaches the sensor, so a register write is lost
+ *
+ * @param calls Transmit calls that still succeed before the failing one
+ */
+void Sim_Fail_Transmit(uint32_t calls);
+
+/**
+ * @brief Function that returns a pseudo-random number from the simulation generator
+ *
+ * @return uint32_t
+ */
+uint32_t Sim_Random(void);
+
+/**
+ * @brief Function that returns the counters
+ *
+ * @param stats Pointer to the counters
+ */
+void Sim_Get_Stats(t_SimStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADXL_SIM_H */
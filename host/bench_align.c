@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "adxl_align.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Alignment Benchmark 																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Three 800 Hz sensors at +300, -500 and +1000 ppm see the same 5 Hz, 10000 LSB tone on X. Each delivers 16-sample blocks
+ * stamped with the interrupt time in us, with +/-20 us of entry jitter, for 75 minutes: past the 35.8 minute wrap of a
+ * signed 32-bit us difference and past the 71.6 minute wrap of a 32-bit us timestamp. Sensor 2 stalls at 1200 s and comes
+ * back at 2400 s with its numbering restarted, as after a re-initialization: its frames are forced for 20 minutes, far
+ * beyond the 549 s at which the Q24 position offset used to overflow, and it restarts after the 35.8 minute mark.
+ *
+ * Every valid sample of every frame is compared with the tone at the grid time (frame timestamps must be epoch +
+ * n * 1250 us exactly, n signed). The harness checks the interpolation error outside the first second of each track,
+ * that the stalled sensor is never marked valid while it is away and always valid once it is back, and the rate
+ * estimates. It prints the host time per frame.
+ */
+
+#define CHANNELS 					3
+#define BLOCK 						16
+#define PERIOD_NS 					1250000
+#define RUN_S 						4500.0
+#define STALL_S 					1200.0
+#define RESUME_S 					2400.0
+#define SETTLE_S 					1.0
+#define AMPLITUDE 					10000.0
+#define TONE_HZ 					5.0
+#define ERROR_LIMIT 				8.0 	// LSB
+#define PI 							3.14159265358979323846
+
+static const double ppm[CHANNELS] = {300, -500, 1000};
+static double start[CHANNELS] = {0.0001, 0.0004, 0.0007}; // time of sample 0 in s
+static uint64_t epoch_us = 0;
+static bool epoch_set = false;
+static uint32_t frames = 0;
+static uint32_t checked = 0;
+static uint32_t bad = 0;
+static uint32_t bad_timestamp = 0;
+static uint32_t stale = 0;
+static uint32_t missing = 0;
+static double worst = 0;
+static double square_sum = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static double Tone(double time)
+{
+	return AMPLITUDE * sin(2 * PI * TONE_HZ * time);
+}
+
+static void On_Frame(const t_AlignedFrame *frame, void *arg)
+{
+	// The first frames sit before the epoch (the newest sample of the first block): n is signed
+	int32_t n = (int32_t)frame->sequence;
+	double time = epoch_us * 1e-6 + n * (PERIOD_NS * 1e-9);
+	double error = 0;
+	uint8_t i = 0;
+	(void)arg;
+	frames++;
+	if (frame->timestamp != (uint64_t)((int64_t)epoch_us + (int64_t)n * (PERIOD_NS / 1000)))
+	{
+		bad_timestamp++;
+	}
+	for (i = 0; i < CHANNELS; i++)
+	{
+		bool away = i == 2 && time > STALL_S + 0.1 && time < RESUME_S;
+		bool settling = time < start[i] + SETTLE_S || (i == 2 && time >= RESUME_S && time < RESUME_S + SETTLE_S);
+		if (!(frame->valid & (1 << i)))
+		{
+			missing += !away && !settling;
+			continue;
+		}
+		if (away)
+		{
+			stale++;
+			continue;
+		}
+		if (settling)
+		{
+			continue;
+		}
+		error = fabs(frame->samples[i].x - Tone(time));
+		worst = (error > worst) ? error : worst;
+		square_sum += error * error;
+		bad += error > ERROR_LIMIT;
+		checked++;
+	}
+}
+
+int main(void)
+{
+	t_Align align;
+	t_Sample samples[BLOCK] = {{0}};
+	t_SampleBlock block;
+	uint32_t sequence[CHANNELS] = {0};
+	double period[CHANNELS];
+	double next[CHANNELS];
+	double interrupt = 0;
+	uint64_t interrupt_us = 0;
+	uint64_t host = 0;
+	uint32_t pushes = 0;
+	uint32_t j = 0;
+	uint8_t i = 0;
+	uint8_t k = 0;
+	bool rates_ok = true;
+
+	Sim_Init(&(t_SimConfig){.seed = 17});
+	Align_Init(&align, CHANNELS, PERIOD_NS, On_Frame, NULL);
+	for (i = 0; i < CHANNELS; i++)
+	{
+		period[i] = PERIOD_NS * 1e-9 * (1 + ppm[i] * 1e-6);
+		next[i] = start[i] + (BLOCK - 1) * period[i];
+	}
+
+	host = Host_Ns();
+	while (true)
+	{
+		// Blocks arrive in interrupt order
+		k = 0;
+		for (i = 1; i < CHANNELS; i++)
+		{
+			k = (next[i] < next[k]) ? i : k;
+		}
+		if (next[k] > RUN_S)
+		{
+			break;
+		}
+		if (k == 2 && next[k] > STALL_S && next[k] < RESUME_S)
+		{
+			start[k] = RESUME_S;
+			sequence[k] = 0;
+			next[k] = start[k] + (BLOCK - 1) * period[k];
+			continue;
+		}
+		for (j = 0; j < BLOCK; j++)
+		{
+			samples[j].x = (int16_t)lround(Tone(start[k] + (sequence[k] + j) * period[k]));
+		}
+		interrupt = next[k] + ((int32_t)(Sim_Random() % 41) - 20) * 1e-6;
+		interrupt_us = (uint64_t)llround(interrupt * 1e6);
+		if (!epoch_set)
+		{
+			epoch_us = interrupt_us;
+			epoch_set = true;
+		}
+		block.sequence = sequence[k];
+		block.timestamp = interrupt_us - (uint64_t)(BLOCK - 1) * (PERIOD_NS / 1000);
+		block.period = PERIOD_NS;
+		block.count = BLOCK;
+		block.samples = samples;
+		Align_Push(&align, k, &block);
+		pushes++;
+		sequence[k] += BLOCK;
+		next[k] += BLOCK * period[k];
+	}
+	host = Host_Ns() - host;
+
+	printf("%u blocks, %u frames over %.0f s (last timestamp past 2^32 us: %s), %u forced\n", pushes, frames, RUN_S,
+		   align.frame.timestamp > UINT32_MAX ? "yes" : "no", align.forced);
+	printf("interpolation error %.2f LSB rms, %.1f LSB max over %u samples, %u over %.0f LSB\n", sqrt(square_sum / checked), worst, checked, bad, ERROR_LIMIT);
+	printf("stalled sensor: %u stale samples while away, %u frames missing a sensor outside the stall; %u wrong timestamps\n", stale, missing, bad_timestamp);
+	for (i = 0; i < CHANNELS; i++)
+	{
+		printf("sensor %u: rate %+d ppm (true %+.0f)\n", i, Align_Rate_Ppm(&align, i), ppm[i]);
+		rates_ok = rates_ok && fabs(Align_Rate_Ppm(&align, i) - ppm[i]) <= 5;
+	}
+	printf("host %.0f ns/frame including the pushes\n", (double)host / frames);
+
+	return (bad == 0 && stale == 0 && missing == 0 && bad_timestamp == 0 && rates_ok && align.frame.timestamp > UINT32_MAX) ? 0 : 1;
+}
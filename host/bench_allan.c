@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "adxl_allan.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Allan Deviation Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * A 2 h capture at 100 Hz (BW_50_Hz, full resolution, 1024 LSB/g) fed to Allan_On_Block in 32-sample blocks:
+ *	- X: white noise of 10 LSB rms plus a random walk of 0.02 LSB rms per sample
+ *	- Y: the same white noise only
+ *	- Z: the same white noise, with a 5000 LSB offset step behind a 64-sample gap at the one hour mark
+ * The expected figures follow from the generator: N = 10 LSB * sqrt(0.01 s) and K = 0.02 LSB / sqrt(0.01 s), in ug. The
+ * harness checks that:
+ *	- the noise density of every axis is within 5 % of N, so the step behind the gap does not leak into Z
+ *	- the rate random walk of X is within 15 % of K, and Y shows less than a tenth of it
+ * The tolerances cover the spread between generator seeds: few long clusters fit in 2 h, so K scatters by about 10 %.
+ *	- the output scale follows DATA_FORMAT: 1024 LSB/g at full resolution, 256 and 16384 LSB/g for 10-bit +/-2 g right and
+ *	  left justified
+ *	- Allan_Sweep_Next visits the 10 normal rates and the 6 low power ones, writes each to BW_RATE, then returns ERR_PARAM
+ * It prints the curve and the host time per 3-axis sample.
+ */
+
+#define RATE_HZ 					100
+#define RUN_S 						7200
+#define BLOCK 						32
+#define LSB_PER_G 					1024.0
+#define WHITE_LSB 					10.0
+#define WALK_LSB 					0.02
+#define STEP_LSB 					5000.0
+#define GAP_LOST 					64
+#define PI 							3.14159265358979323846
+
+static SPI_HandleTypeDef hspi;
+static t_Allan allan;
+static t_Allan scale;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+// Standard normal deviate (Box-Muller) on the simulator generator, so every run is the same
+static double Gaussian(void)
+{
+	double u = (Sim_Random() + 1.0) / 4294967297.0;
+	double v = (Sim_Random() + 1.0) / 4294967297.0;
+	return sqrt(-2 * log(u)) * cos(2 * PI * v);
+}
+
+static bool Check_Sweep(void)
+{
+	t_AllanSweep sweep = {0};
+	t_Allan swept;
+	uint8_t value = 0;
+	uint32_t settings = 0;
+	uint32_t low_power = 0;
+	uint32_t wrong = 0;
+	sweep.data_format = 0x0B;
+	while (Allan_Sweep_Next(&hspi, &sweep, &swept) == STATUS_OK_ADXL && settings < 32)
+	{
+		settings++;
+		low_power += sweep.low_power;
+		Read_Byte(&hspi, BW_RATE, &value);
+		wrong += value != ((sweep.low_power ? 0x10 : 0) | sweep.rate);
+	}
+	printf("sweep: %u settings (%u low power), %u BW_RATE read-backs wrong\n", settings, low_power, wrong);
+	return settings == 16 && low_power == 6 && wrong == 0;
+}
+
+int main(void)
+{
+	t_Sample samples[BLOCK];
+	t_SampleBlock block = {0, 0, 1000000000 / RATE_HZ, BLOCK, samples};
+	t_Gap gap = {0};
+	t_AllanReport report;
+	double walk = 0;
+	double offset = 0;
+	double density = WHITE_LSB / LSB_PER_G * 1e6 * sqrt(1.0 / RATE_HZ);
+	double random_walk = WALK_LSB / LSB_PER_G * 1e6 / sqrt(1.0 / RATE_HZ);
+	uint64_t host = 0;
+	uint32_t total = RATE_HZ * RUN_S;
+	uint32_t n = 0;
+	uint32_t j = 0;
+	uint32_t right = 0;
+	uint8_t i = 0;
+	bool ok = true;
+
+	Sim_Init(&(t_SimConfig){.seed = 41});
+	Allan_Init(&allan, BW_50_Hz, 0x0B);
+	host = Host_Ns();
+	for (n = 0; n < total; n += BLOCK)
+	{
+		if (n == total / 2)
+		{
+			gap.sequence = n;
+			gap.lost = GAP_LOST;
+			gap.cause = GAP_OVERRUN;
+			Allan_On_Gap(&gap, &allan);
+			offset = STEP_LSB;
+		}
+		for (j = 0; j < BLOCK; j++)
+		{
+			walk += WALK_LSB * Gaussian();
+			samples[j].x = (int16_t)lround(WHITE_LSB * Gaussian() + walk);
+			samples[j].y = (int16_t)lround(WHITE_LSB * Gaussian());
+			samples[j].z = (int16_t)lround(WHITE_LSB * Gaussian() + offset);
+		}
+		block.sequence = n + (offset != 0 ? GAP_LOST : 0);
+		Allan_On_Block(&block, &allan);
+	}
+	host = Host_Ns() - host;
+	Allan_Report(&allan, &report);
+
+	for (i = 0; i < report.levels; i++)
+	{
+		printf("tau %9.2f s  x %8.1f  y %8.1f  z %8.1f ug\n", report.tau[i], report.deviation[0][i], report.deviation[1][i], report.deviation[2][i]);
+	}
+	printf("noise density %.1f / %.1f / %.1f ug/rtHz (expected %.1f)\n", report.noise_density[0], report.noise_density[1], report.noise_density[2], density);
+	printf("rate random walk x %.1f ug/rts (expected %.1f), y %.1f; bias instability x %.1f ug at %.0f s\n", report.random_walk[0], random_walk,
+		   report.random_walk[1], report.bias_instability[0], report.bias_tau[0]);
+	printf("%u samples, %u gap, host %.0f ns per 3-axis sample (generator included), %zu bytes of state\n", (uint32_t)allan.samples, allan.gaps,
+		   (double)host / total, sizeof(allan));
+	for (i = 0; i < 3; i++)
+	{
+		ok = ok && fabs(report.noise_density[i] - density) <= 0.05 * density;
+	}
+	ok = ok && fabs(report.random_walk[0] - random_walk) <= 0.15 * random_walk && report.random_walk[1] < 0.1 * random_walk;
+	ok = Check_Sweep() && ok;
+	Allan_Init(&scale, BW_50_Hz, 0x02);
+	right = scale.lsb_per_g;
+	Allan_Init(&scale, BW_50_Hz, 0x06);
+	printf("output scale: full resolution %u LSB/g, 10-bit +/-2 g right justified %u, left justified %u\n", allan.lsb_per_g, right, scale.lsb_per_g);
+	ok = ok && allan.lsb_per_g == 1024 && right == 256 && scale.lsb_per_g == 16384;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <time.h>
+#include "adxl_async.hpp"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Async Front-end Benchmark 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Drains a 1600 Hz FIFO at a watermark of 16 on the simulated sensor, once with the blocking functions and once with
+ * coroutines on a host event loop, and compares:
+ *	latency		interrupt entry to samples in the consumer (simulated time), and the bus-bound throughput it allows
+ *	CPU			simulated CPU time per drain: blocking calls spin for the whole transfer, the async path only pays the
+ *				transfer complete interrupts
+ *	host		real host time per drain, i.e. the cost of the driver, the coroutine machinery and the simulator
+ * It also checks that a co_await on a busy device fails with ERR_BUSY without disturbing the operation in flight.
+ */
+
+#define DRAINS 						2000
+#define WATERMARK 					16
+
+static SPI_HandleTypeDef hspi;
+static adxl::Device device(&hspi);
+
+// Coroutine frames come from a static arena: no heap allocation per coroutine or per operation
+alignas(std::max_align_t) static unsigned char arena[4096];
+static size_t arena_used = 0;
+
+struct Task
+{
+	struct promise_type
+	{
+		static void *operator new(size_t size)
+		{
+			size = (size + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+			if (arena_used + size > sizeof(arena))
+			{
+				std::abort();
+			}
+			arena_used += size;
+			return &arena[arena_used - size];
+		}
+		static void operator delete(void *, size_t) {}
+		Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::abort(); }
+	};
+};
+
+extern "C" void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+	device.transfer_complete();
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static int Compare(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void Setup(void)
+{
+	t_SimConfig config = {};
+	config.bus_hz = 5000000;
+	config.call_ns = 1500; 	// HAL_SPI_Transmit/Receive state checks and timeout polling
+	config.isr_ns = 800; 	// HAL SPI interrupt handler plus the completion callback
+	config.jitter_ns = 2000;
+	config.seed = 1;
+	Sim_Init(&config);
+	Set_Bandwidth_Rate(&hspi, false, BW_800_Hz);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, false);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+}
+
+static void Report(const char *name, uint64_t *latency, uint64_t cpu, uint64_t span, uint64_t host)
+{
+	qsort(latency, DRAINS, sizeof(latency[0]), Compare);
+	// Back to back drains are bus bound: the throughput ceiling is one watermark per drain latency
+	printf("%-10s latency p50 %6.1f us  p99 %6.1f us  max %6.0f samples/s  CPU %6.1f us/drain (%4.1f %% of the CPU)  host %5.0f ns/drain\n", name,
+		   latency[DRAINS / 2] / 1000.0, latency[DRAINS * 99 / 100] / 1000.0, WATERMARK * 1e9 / latency[DRAINS / 2], cpu / 1000.0 / DRAINS, 100.0 * cpu / span,
+		   (double)host / DRAINS);
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Blocking Path 																				  */
+/******************************************************************************************************************************************************************************/
+
+static void Run_Blocking(void)
+{
+	static uint64_t latency[DRAINS];
+	t_Sample samples[FIFO_SIZE];
+	t_IntSource source;
+	t_SimStats before;
+	t_SimStats after;
+	uint64_t start = 0;
+	uint64_t host = 0;
+	uint32_t i = 0;
+
+	Setup();
+	Sim_Get_Stats(&before);
+	start = Sim_Now();
+	host = Host_Ns();
+	for (i = 0; i < DRAINS; i++)
+	{
+		Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL);
+		uint64_t entry = Sim_Now();
+		Get_Interrupt_Source(&hspi, &source);
+		Read_FIFO(&hspi, samples, WATERMARK);
+		latency[i] = Sim_Now() - entry;
+	}
+	host = Host_Ns() - host;
+	Sim_Get_Stats(&after);
+	Report("blocking", latency, after.cpu_time - before.cpu_time, Sim_Now() - start, host);
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Coroutine Path 																				  */
+/******************************************************************************************************************************************************************************/
+
+static uint64_t co_latency[DRAINS];
+static uint32_t co_drains = 0;
+static uint64_t co_entry = 0;
+static bool co_failed = false;
+
+static Task Consumer(void)
+{
+	t_Sample samples[FIFO_SIZE];
+	t_IntSource source;
+	while (co_drains < DRAINS)
+	{
+		if (co_await device.next_event(&source) != STATUS_OK_ADXL || co_await device.read_fifo(samples, WATERMARK) != STATUS_OK_ADXL)
+		{
+			co_failed = true;
+		}
+		co_latency[co_drains++] = Sim_Now() - co_entry;
+	}
+}
+
+/**
+ * @brief Host event loop: resume what is ready, otherwise let simulated time pass until the transfer in flight ends or the sensor interrupts
+ */
+static void Event_Loop(void)
+{
+	while (co_drains < DRAINS)
+	{
+		if (device.poll())
+		{
+			continue;
+		}
+		if (Sim_Transfer_End() != 0)
+		{
+			Sim_Run_Until(Sim_Transfer_End());
+		}
+		else if (device.busy() && Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+		{
+			co_entry = Sim_Now();
+			device.interrupt();
+		}
+	}
+}
+
+static void Run_Coroutines(void)
+{
+	t_SimStats before;
+	t_SimStats after;
+	uint64_t start = 0;
+	uint64_t host = 0;
+
+	Setup();
+	Sim_Get_Stats(&before);
+	start = Sim_Now();
+	host = Host_Ns();
+	Consumer();
+	Event_Loop();
+	host = Host_Ns() - host;
+	Sim_Get_Stats(&after);
+	Report("coroutine", co_latency, after.cpu_time - before.cpu_time, Sim_Now() - start, host);
+	if (co_failed)
+	{
+		printf("coroutine  an operation failed\n");
+	}
+}
+
+/******************************************************************************************************************************************************************************/
+/*																				Busy Device 																				  */
+/******************************************************************************************************************************************************************************/
+
+static STATUS_ADXL busy_first = ERR_SPI;
+static STATUS_ADXL busy_second = ERR_SPI;
+static bool busy_first_done = false;
+static t_Sample busy_samples[4];
+
+static Task Busy_First(void)
+{
+	busy_first = co_await device.read_fifo(busy_samples, 4);
+	busy_first_done = true;
+}
+
+static Task Busy_Second(void)
+{
+	t_Sample samples[4];
+	busy_second = co_await device.read_fifo(samples, 4);
+}
+
+static bool Run_Busy_Check(void)
+{
+	Setup();
+	Sim_Run_Until(Sim_Now() + 20000000ULL);
+	Busy_First();
+	Busy_Second(); // device busy: must fail at once without stealing the first completion
+	while (!busy_first_done && Sim_Transfer_End() != 0)
+	{
+		Sim_Run_Until(Sim_Transfer_End());
+		device.poll();
+	}
+	return busy_first_done && busy_first == STATUS_OK_ADXL && busy_second == ERR_BUSY;
+}
+
+int main(void)
+{
+	bool busy_ok = false;
+	printf("1600 Hz ODR, watermark %d, 5 MHz SPI, %d drains\n", WATERMARK, DRAINS);
+	Run_Blocking();
+	Run_Coroutines();
+	busy_ok = Run_Busy_Check();
+	printf("busy device: %s\n", busy_ok ? "second co_await got ERR_BUSY, first completed" : "FAILED");
+	printf("coroutine arena: %zu bytes\n", arena_used);
+	return (busy_ok && !co_failed) ? 0 : 1;
+}
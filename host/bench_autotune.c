@@ -0,0 +1,233 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include "adxl_autotune.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Threshold Tuning Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Autotune_Measure on the simulated sensor (800 Hz, full resolution +/-2 g, FIFO in stream mode, watermark 16): the
+ * sensor is carried (0.3 g at 3 Hz on X and Y) for the first half second, then rests with about 1 mg rms of noise. The
+ * windows taken while it moves must be rejected against the 5 mg noise floor and the thresholds must come from the rest.
+ * It runs once sleeping on the watermark interrupt and once in HAL_Delay; both must read FIFO_STATUS at most once per 8
+ * samples drained instead of polling it. Then, on synthetic windows:
+ *	- automatic coupling starts in AC, turns DC (both thresholds above 1 g) after AUTOTUNE_STABLE_WINDOWS windows at rest,
+ *	  and back to AC at the first quiet window after the sensor is tilted by 90 degrees; Autotune_Apply writes each
+ *	  change to ACT_INACT_CTL
+ *	- DC_SET forces DC from the first window, AC_SET keeps AC however stable the mount
+ *	- int16 extremes at 128 LSB/g with the largest margins saturate the thresholds instead of wrapping the int32 math
+ *	- left justified 10-bit data at +/-4 g (8192 LSB/g) gives the same thresholds as right justified data
+ *	- a coupling value other than AUTOTUNE_COUPLING_AUTO, AC_SET or DC_SET is refused by Autotune_Init
+ */
+
+#define WINDOW 						400
+#define WATERMARK 					16
+#define MOVING_NS 					500000000ULL
+#define PI 							3.14159265358979323846
+
+static SPI_HandleTypeDef hspi;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void Carried_Then_Rest(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	double phase = 2 * PI * 3.0 * time * 1e-9;
+	(void)arg;
+	if (time < MOVING_NS)
+	{
+		acceleration[0] = (int32_t)(300000 * sin(phase));
+		acceleration[1] = (int32_t)(300000 * cos(phase));
+	}
+	else
+	{
+		acceleration[0] = (int32_t)(Sim_Random() % 4001) - 2000;
+		acceleration[1] = (int32_t)(Sim_Random() % 4001) - 2000;
+	}
+	acceleration[2] = 1000000 + (int32_t)(Sim_Random() % 4001) - 2000;
+}
+
+static t_AutotuneConfig Config(uint8_t coupling)
+{
+	t_AutotuneConfig config = {0};
+	config.window = WINDOW;
+	config.axes = AUTOTUNE_AXIS_X | AUTOTUNE_AXIS_Y | AUTOTUNE_AXIS_Z;
+	config.coupling = coupling;
+	config.noise_floor = 5000;
+	config.activity_margin = 32;
+	config.inactivity_margin = 20;
+	config.time_inactivity = 5;
+	config.adapt_shift = 4;
+	return config;
+}
+
+// One window at rest: 1 g on Z (on X when tilted), +/-2 mg uniform noise, scaled to lsb_per_g
+static void Window(t_Autotune *tune, uint32_t lsb_per_g, bool tilted)
+{
+	t_Sample samples[WINDOW];
+	t_SampleBlock block = {0, 0, 1250000, WINDOW, samples};
+	int32_t gravity = 0;
+	uint32_t i = 0;
+	for (i = 0; i < WINDOW; i++)
+	{
+		gravity = 1000000 + (int32_t)(Sim_Random() % 4001) - 2000;
+		samples[i].x = (int16_t)lround((tilted ? gravity : (int32_t)(Sim_Random() % 4001) - 2000) * 1e-6 * lsb_per_g);
+		samples[i].y = (int16_t)lround(((int32_t)(Sim_Random() % 4001) - 2000) * 1e-6 * lsb_per_g);
+		samples[i].z = (int16_t)lround((tilted ? (int32_t)(Sim_Random() % 4001) - 2000 : gravity) * 1e-6 * lsb_per_g);
+	}
+	Autotune_Process_Block(tune, &block);
+}
+
+static void Rest_Window(t_Autotune *tune, uint32_t lsb_per_g)
+{
+	Window(tune, lsb_per_g, false);
+}
+
+static void Wait_Watermark(uint32_t timeout, void *arg)
+{
+	(void)arg;
+	Sim_Wait_Interrupt(SIM_INT1, (uint64_t)timeout * 1000000ULL);
+}
+
+/**
+ * @return bool true if tuned from the rest after rejecting the carried windows, without polling FIFO_STATUS
+ */
+static bool Measure_Carried(const char *name, AUTOTUNE_WAIT wait)
+{
+	t_SimConfig sim = {0};
+	t_AutotuneConfig config = Config(AC_SET);
+	t_Autotune tune;
+	t_SimStats stats;
+	STATUS_ADXL measured = STATUS_OK_ADXL;
+	uint32_t drained = 0;
+	uint32_t polls = 0;
+
+	sim.signal = Carried_Then_Rest;
+	sim.seed = 21;
+	Sim_Init(&sim);
+	Set_Bandwidth_Rate(&hspi, false, BW_400_Hz);
+	Set_Data_Format(&hspi, false, false, false, true, false, RANGE_2_G);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, false);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+	Sim_Get_Stats(&stats);
+	polls = stats.transactions;
+	Autotune_Init(&tune, &config, 0x0A);
+	measured = Autotune_Measure(&hspi, &tune, 3000, wait, NULL);
+	Sim_Get_Stats(&stats);
+	drained = stats.samples - stats.lost - (Sim_Peek(FIFO_STATUS) & 0x3F);
+	polls = stats.transactions - polls - drained;
+	printf("carried then at rest, %s: %s after %.2f s, %u windows rejected, noise %u/%u/%u ug rms, THRESH_ACT %u, THRESH_INACT %u, "
+		   "%u status reads for %u samples\n",
+		   name, measured == STATUS_OK_ADXL ? "tuned" : "FAILED", Sim_Now() * 1e-9, tune.skipped, tune.noise[0], tune.noise[1], tune.noise[2],
+		   tune.thresh_act, tune.thresh_inact, polls, drained);
+	return measured == STATUS_OK_ADXL && tune.skipped >= 1 && Sim_Now() > MOVING_NS && tune.thresh_act <= 2 && polls <= drained / 8;
+}
+
+/**
+ * @return bool true if the automatic coupling follows the mount and the overrides hold
+ */
+static bool Check_Coupling(void)
+{
+	t_SimConfig sim = {0};
+	t_AutotuneConfig config = Config(AUTOTUNE_COUPLING_AUTO);
+	t_Autotune tune;
+	t_Autotune forced;
+	uint8_t before = 0;
+	uint8_t stable = 0;
+	uint8_t tilted = 0;
+	uint8_t dc_act = 0;
+	uint8_t i = 0;
+	bool ok = true;
+
+	Sim_Init(&sim);
+	Autotune_Init(&tune, &config, 0x0A);
+	for (i = 0; i < AUTOTUNE_STABLE_WINDOWS - 1; i++)
+	{
+		Rest_Window(&tune, 1024);
+	}
+	ok = ok && Autotune_Apply(&hspi, &tune) == STATUS_OK_ADXL;
+	before = Sim_Peek(ACT_INACT_CNT);
+	ok = ok && tune.coupling == AC_SET && tune.thresh_act <= 2;
+	Rest_Window(&tune, 1024);
+	dc_act = tune.thresh_act;
+	ok = ok && tune.coupling == DC_SET && tune.thresh_inact >= 64 && tune.changed && Autotune_Apply(&hspi, &tune) == STATUS_OK_ADXL;
+	stable = Sim_Peek(ACT_INACT_CNT);
+	Window(&tune, 1024, true);
+	ok = ok && tune.coupling == AC_SET && tune.thresh_act <= 2 && Autotune_Apply(&hspi, &tune) == STATUS_OK_ADXL;
+	tilted = Sim_Peek(ACT_INACT_CNT);
+	printf("automatic coupling: ACT_INACT_CTL 0x%02X after %u windows, 0x%02X (THRESH_ACT %u) after %u, 0x%02X (THRESH_ACT %u) once tilted\n", before,
+		   AUTOTUNE_STABLE_WINDOWS - 1, stable, dc_act, AUTOTUNE_STABLE_WINDOWS, tilted, tune.thresh_act);
+	ok = ok && (before & 0x88) == 0x88 && (stable & 0x88) == 0 && (tilted & 0x88) == 0x88;
+
+	config = Config(AC_SET);
+	Autotune_Init(&forced, &config, 0x0A);
+	for (i = 0; i < 2 * AUTOTUNE_STABLE_WINDOWS; i++)
+	{
+		Rest_Window(&forced, 1024);
+	}
+	printf("AC_SET after %u stable windows: %s\n", 2 * AUTOTUNE_STABLE_WINDOWS, forced.coupling == AC_SET ? "AC" : "DC");
+	return ok && forced.coupling == AC_SET;
+}
+
+int main(void)
+{
+	t_AutotuneConfig config = Config(AC_SET);
+	t_Autotune tune;
+	t_Autotune dc;
+	t_Autotune extreme;
+	t_Autotune right;
+	t_Autotune left;
+	t_Sample samples[WINDOW];
+	t_SampleBlock block = {0, 0, 1250000, WINDOW, samples};
+	STATUS_ADXL automatic = STATUS_OK_ADXL;
+	uint32_t i = 0;
+	bool ok = true;
+
+	ok = Measure_Carried("watermark wait", Wait_Watermark) && ok;
+	ok = Measure_Carried("HAL_Delay", NULL) && ok;
+	ok = Check_Coupling() && ok;
+
+	config = Config(DC_SET);
+	Autotune_Init(&dc, &config, 0x0A);
+	Rest_Window(&dc, 1024);
+	printf("DC coupling at rest: THRESH_ACT %u, THRESH_INACT %u (1 g = 64)\n", dc.thresh_act, dc.thresh_inact);
+	ok = ok && dc.tuned && dc.thresh_inact >= 64 && dc.thresh_act > dc.thresh_inact;
+
+	config = Config(AC_SET);
+	config.activity_margin = 255;
+	config.inactivity_margin = 255;
+	config.noise_floor = UINT32_MAX;
+	Autotune_Init(&extreme, &config, 0x03);
+	for (i = 0; i < WINDOW; i++)
+	{
+		samples[i].x = (i & 1) ? INT16_MAX : -INT16_MAX;
+		samples[i].y = 0;
+		samples[i].z = 0;
+	}
+	Autotune_Process_Block(&extreme, &block);
+	printf("int16 extremes at 128 LSB/g, margin 255: THRESH_ACT %u, THRESH_INACT %u\n", extreme.thresh_act, extreme.thresh_inact);
+	ok = ok && extreme.tuned && extreme.thresh_act == 255;
+
+	config = Config(AC_SET);
+	Autotune_Init(&right, &config, 0x03);
+	Autotune_Init(&left, &config, 0x07);
+	Rest_Window(&right, 128);
+	Rest_Window(&left, 8192);
+	printf("+/-4 g 10-bit: %u LSB/g right justified, %u LSB/g left justified, THRESH_ACT %u vs %u\n", right.lsb_per_g, left.lsb_per_g, right.thresh_act,
+		   left.thresh_act);
+	ok = ok && left.lsb_per_g == 8192 && right.tuned && left.tuned && left.thresh_act <= right.thresh_act;
+
+	config.coupling = 0xFF;
+	automatic = Autotune_Init(&tune, &config, 0x0A);
+	printf("coupling 0xFF: %s\n", automatic == ERR_PARAM ? "ERR_PARAM" : "accepted");
+	ok = ok && automatic == ERR_PARAM;
+	return ok ? 0 : 1;
+}
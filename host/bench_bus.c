@@ -0,0 +1,284 @@
+#define _POSIX_C_SOURCE 200809L
+#define ADXL_OS_PTHREAD
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "adxl.h"
+#include "adxl_async.h"
+#include "adxl_os.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Bus Lock Stress Test 																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * The driver and the bus lock are built with the pthread backend (adxl_pthread.o, adxl_os_pthread.o) and a 100 ms lock
+ * timeout, so a host scheduling hiccup does not read as a lost arbitration. Two sample threads (Get_Interrupt_Source,
+ * Read_6Bytes) and two configuration threads (Register_Write then Read_Byte of a threshold register each one owns) hammer
+ * one simulated sensor. A bus hook yields the CPU with CS asserted, so the others queue on the lock even on one core.
+ * The harness checks that:
+ *	- no transaction overlaps another (the simulator counts CS asserted while another transaction is open)
+ *	- every configuration write reads back, and every failed call is an ERR_BUSY counted as a timeout
+ *	- the lock counted exactly the transactions the sensor saw
+ *	- a sample read queued behind a held bus gets it before a configuration call queued after it, every round
+ *	- an interrupt-driven read (adxl_async.c) started while a task holds the bus returns ERR_BUSY without touching it, and
+ *	  a blocking write issued while one is in flight waits for its completion instead of asserting CS in the middle of it
+ * It also prints the uncontended Bus_Lock/Bus_Unlock cost. Priority inheritance itself needs real-time scheduling and is
+ * not exercised here.
+ */
+
+#define OPERATIONS 					20000 	// per thread
+#define ORDER_ROUNDS 				20
+#define HOLD_NS 					2000000
+#define ASYNC_SAMPLES 				8
+
+static SPI_HandleTypeDef hspi;
+static uint32_t mismatches = 0;
+static uint32_t busy = 0;
+static uint32_t other_errors = 0;
+static uint32_t order = 0;
+static uint32_t sample_rank = 0;
+static uint32_t config_rank = 0;
+static t_Async async;
+static volatile uint32_t async_done = 0;
+static volatile uint32_t write_done = 0;
+static STATUS_ADXL write_status = STATUS_OK_ADXL;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+	Async_Transfer_Complete(&async);
+}
+
+static void Yield_In_Transaction(SPI_HandleTypeDef *spi, bool complete, void *arg)
+{
+	(void)spi;
+	(void)arg;
+	if (!complete)
+	{
+		sched_yield();
+	}
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void Sleep_Ns(uint64_t ns)
+{
+	struct timespec delay = {(time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL)};
+	nanosleep(&delay, NULL);
+}
+
+static void Count(STATUS_ADXL status)
+{
+	if (status == ERR_BUSY)
+	{
+		__atomic_fetch_add(&busy, 1, __ATOMIC_RELAXED);
+	}
+	else if (status != STATUS_OK_ADXL)
+	{
+		__atomic_fetch_add(&other_errors, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void *Sample_Thread(void *arg)
+{
+	t_IntSource source;
+	t_Sample sample;
+	uint32_t i = 0;
+	(void)arg;
+	for (i = 0; i < OPERATIONS; i++)
+	{
+		Count((i & 1) ? Read_6Bytes(&hspi, MEASUREMENTS_DATA, &sample.x, &sample.y, &sample.z) : Get_Interrupt_Source(&hspi, &source));
+	}
+	return NULL;
+}
+
+static void *Config_Thread(void *arg)
+{
+	uint8_t reg = (uint8_t)(uintptr_t)arg;
+	uint8_t value = 0;
+	uint32_t i = 0;
+	STATUS_ADXL status = STATUS_OK_ADXL;
+	for (i = 0; i < OPERATIONS; i++)
+	{
+		status = Register_Write(&hspi, reg, (uint8_t)i);
+		Count(status);
+		if (status == STATUS_OK_ADXL)
+		{
+			status = Read_Byte(&hspi, reg, &value);
+			Count(status);
+			if (status == STATUS_OK_ADXL && value != (uint8_t)i)
+			{
+				__atomic_fetch_add(&mismatches, 1, __ATOMIC_RELAXED);
+			}
+		}
+	}
+	return NULL;
+}
+
+static void *Queued_Sample(void *arg)
+{
+	(void)arg;
+	if (Bus_Lock(BUS_PRIORITY_SAMPLE))
+	{
+		sample_rank = ++order;
+		Bus_Unlock();
+	}
+	return NULL;
+}
+
+static void *Queued_Config(void *arg)
+{
+	(void)arg;
+	if (Bus_Lock(BUS_PRIORITY_CONFIG))
+	{
+		config_rank = ++order;
+		Bus_Unlock();
+	}
+	return NULL;
+}
+
+static uint32_t Check_Order(void)
+{
+	pthread_t sample;
+	pthread_t config;
+	uint32_t round = 0;
+	uint32_t wrong = 0;
+	for (round = 0; round < ORDER_ROUNDS; round++)
+	{
+		order = 0;
+		sample_rank = 0;
+		config_rank = 0;
+		Bus_Lock(BUS_PRIORITY_CONFIG);
+		pthread_create(&sample, NULL, Queued_Sample, NULL);
+		Sleep_Ns(HOLD_NS);
+		pthread_create(&config, NULL, Queued_Config, NULL);
+		Sleep_Ns(HOLD_NS);
+		Bus_Unlock();
+		pthread_join(sample, NULL);
+		pthread_join(config, NULL);
+		wrong += !(sample_rank == 1 && config_rank == 2);
+	}
+	return wrong;
+}
+
+static void Async_Done(STATUS_ADXL status, void *arg)
+{
+	(void)status;
+	(void)arg;
+	__atomic_store_n(&async_done, 1, __ATOMIC_RELEASE);
+}
+
+static void *Blocking_Write(void *arg)
+{
+	(void)arg;
+	write_status = Register_Write(&hspi, THRESHOLD_ACTIVITY, 0x5A);
+	__atomic_store_n(&write_done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+/**
+ * @return bool true if the interrupt-driven read and the blocking calls never shared the bus
+ */
+static bool Check_Async(void)
+{
+	t_Sample samples[ASYNC_SAMPLES];
+	t_SimStats before;
+	t_SimStats after;
+	pthread_t writer;
+	STATUS_ADXL held = STATUS_OK_ADXL;
+	STATUS_ADXL started = STATUS_OK_ADXL;
+	bool waited = false;
+
+	Async_Init(&async, &hspi);
+	Sim_Get_Stats(&before);
+	Bus_Lock(BUS_PRIORITY_CONFIG);
+	held = Async_Read_Samples(&async, samples, ASYNC_SAMPLES, Async_Done, NULL);
+	Bus_Unlock();
+	Sim_Get_Stats(&after);
+	held = (held == ERR_BUSY && !Async_Is_Busy(&async) && after.transactions == before.transactions) ? ERR_BUSY : ERR_SPI;
+
+	// Nothing advances the simulated clock but this thread, so the read stays in flight until it runs the transfers out
+	async_done = 0;
+	write_done = 0;
+	started = Async_Read_Samples(&async, samples, ASYNC_SAMPLES, Async_Done, NULL);
+	pthread_create(&writer, NULL, Blocking_Write, NULL);
+	Sleep_Ns(HOLD_NS);
+	waited = __atomic_load_n(&write_done, __ATOMIC_ACQUIRE) == 0;
+	while (started == STATUS_OK_ADXL && !__atomic_load_n(&async_done, __ATOMIC_ACQUIRE))
+	{
+		Sim_Run_Until(Sim_Transfer_End());
+	}
+	pthread_join(writer, NULL);
+	Sim_Get_Stats(&after);
+
+	printf("async read with the bus held: %s; blocking write during an async read: %s, %s, %u interleaved\n",
+		   held == ERR_BUSY ? "ERR_BUSY" : "NOT refused", waited ? "waited" : "did NOT wait", write_status == STATUS_OK_ADXL ? "ok" : "failed",
+		   after.interleaved - before.interleaved);
+	return held == ERR_BUSY && started == STATUS_OK_ADXL && waited && write_status == STATUS_OK_ADXL && after.interleaved == before.interleaved;
+}
+
+int main(void)
+{
+	pthread_t threads[4];
+	t_SimConfig config = {0};
+	t_SimStats sim_stats;
+	t_BusStats before;
+	t_BusStats stats;
+	uint64_t start = 0;
+	double lock_ns = 0;
+	uint32_t wrong_order = 0;
+	uint32_t i = 0;
+	bool async_ok = false;
+	bool ok = false;
+
+	config.seed = 1;
+	Sim_Init(&config);
+	if (!Bus_Lock_Init())
+	{
+		printf("Bus_Lock_Init failed\n");
+		return 1;
+	}
+
+	start = Host_Ns();
+	for (i = 0; i < 1000000; i++)
+	{
+		Bus_Lock(BUS_PRIORITY_SAMPLE);
+		Bus_Unlock();
+	}
+	lock_ns = (double)(Host_Ns() - start) / 1000000;
+	Bus_Get_Stats(&before);
+
+	Set_Bus_Hook(Yield_In_Transaction, NULL);
+	pthread_create(&threads[0], NULL, Sample_Thread, NULL);
+	pthread_create(&threads[1], NULL, Sample_Thread, NULL);
+	pthread_create(&threads[2], NULL, Config_Thread, (void *)(uintptr_t)THRESHOLD_ACTIVITY);
+	pthread_create(&threads[3], NULL, Config_Thread, (void *)(uintptr_t)THRESHOLD_INACTIVITY);
+	for (i = 0; i < 4; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+	Set_Bus_Hook(NULL, NULL);
+	Bus_Get_Stats(&stats);
+	Sim_Get_Stats(&sim_stats);
+	wrong_order = Check_Order();
+	async_ok = Check_Async();
+
+	printf("4 threads x %u operations: %u transactions (sensor saw %u), %u interleaved, %u contended, %u yielded to sample reads\n", OPERATIONS,
+		   stats.transactions - before.transactions, sim_stats.transactions, sim_stats.interleaved, stats.contended - before.contended, stats.yielded);
+	printf("%u ERR_BUSY (%u lock timeouts), %u other errors, %u read-back mismatches\n", busy, stats.timeouts, other_errors, mismatches);
+	printf("queued sample read served before the configuration call in %u of %u rounds\n", ORDER_ROUNDS - wrong_order, ORDER_ROUNDS);
+	printf("uncontended Bus_Lock + Bus_Unlock %.1f ns\n", lock_ns);
+
+	ok = sim_stats.interleaved == 0 && stats.transactions - before.transactions == sim_stats.transactions && busy == stats.timeouts && other_errors == 0 &&
+		 mismatches == 0 && wrong_order == 0 && async_ok;
+	return ok ? 0 : 1;
+}
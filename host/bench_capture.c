@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include "adxl_capture.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Event Capture Benchmark 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Shocks of 2 g on X (5 ms every 250 ms) over 1 g on Z, 1600 Hz, activity above 1 g on X mapped to INT1 as the trigger.
+ * The handler reads INT_SOURCE and calls Capture_Process on every INT1 interrupt (activity or watermark); optionally
+ * it also polls every millisecond while collecting. For each capture the harness checks that the sample at
+ * Capture_Trigger_Index is the first one of the shock, and measures:
+ *	window		trigger interrupt entry to capture ready (includes the post-trigger samples themselves)
+ *	ready		conversion of the last post-trigger sample to capture ready, i.e. what the driver adds
+ *	trigger		trigger_time less the conversion time of the first shock sample, which must stay under two sample periods
+ * Halfway through each run the write that re-arms the capture after the callback fails once: the capture must retry the
+ * arming on the next call and deliver no capture that was not triggered.
+ */
+
+#define PRE_TRIGGER 				16
+#define POST_TRIGGER 				64
+#define SHOCK_PERIOD_NS 			250000000ULL
+#define SHOCK_LENGTH_NS 			5000000ULL
+#define CAPTURES 					200
+#define SAMPLE_NS 					625000ULL
+
+static SPI_HandleTypeDef hspi;
+static t_Capture capture;
+static uint32_t aligned = 0;
+static uint32_t completed = 0;
+static uint64_t window_max = 0;
+static uint64_t window_sum = 0;
+static uint64_t ready_max = 0;
+static uint64_t ready_sum = 0;
+static uint64_t trigger_max = 0;
+static uint64_t shock_start = 0; 			// conversion time of the first sample of the current shock
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void Signal(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	(void)arg;
+	acceleration[0] = (int32_t)(Sim_Random() % 20000) - 10000;
+	acceleration[1] = (int32_t)(Sim_Random() % 20000) - 10000;
+	acceleration[2] = 1000000;
+	if (time % SHOCK_PERIOD_NS < SHOCK_LENGTH_NS)
+	{
+		if (time % SHOCK_PERIOD_NS < SAMPLE_NS)
+		{
+			shock_start = time;
+		}
+		acceleration[0] += 2000000;
+	}
+}
+
+static void On_Capture(const t_Capture *done, void *arg)
+{
+	uint16_t index = Capture_Trigger_Index(done);
+	uint64_t last = shock_start + (POST_TRIGGER - 1) * SAMPLE_NS;
+	uint64_t ready = Sim_Now() - last;
+	uint64_t window = Sim_Now() - *(const uint64_t *)arg;
+	uint64_t trigger = done->trigger_time * 1000 > shock_start ? done->trigger_time * 1000 - shock_start : shock_start - done->trigger_time * 1000;
+	if (done->samples[index].x > 600 && done->samples[index - 1].x < 100)
+	{
+		aligned++;
+	}
+	ready_sum += ready;
+	ready_max = ready > ready_max ? ready : ready_max;
+	window_sum += window;
+	window_max = window > window_max ? window : window_max;
+	trigger_max = trigger > trigger_max ? trigger : trigger_max;
+	completed++;
+	if (completed == CAPTURES / 2)
+	{
+		Sim_Fail_Transmit(0); // the first write of the re-arm that follows
+	}
+}
+
+static bool Run(uint64_t poll_ns)
+{
+	t_SimConfig config = {0};
+	t_IntSource source;
+	uint64_t trigger_entry = 0;
+	uint64_t next_poll = 0;
+	CAPTURE_STATE before = CAPTURE_IDLE;
+
+	config.bus_hz = 5000000;
+	config.call_ns = 1500;
+	config.jitter_ns = 5000;
+	config.seed = 7;
+	config.signal = Signal;
+	Sim_Init(&config);
+	aligned = completed = 0;
+	window_max = window_sum = ready_max = ready_sum = trigger_max = 0;
+
+	Set_Bandwidth_Rate(&hspi, false, BW_800_Hz);
+	Set_Data_Format(&hspi, false, false, false, true, false, RANGE_4_G);
+	Set_Threshold_Activity(&hspi, 64); // 1 g
+	Set_Activity_Inactivity_Control(&hspi, DC_SET, DC_SET, true, false, false);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, true, false, true, false);
+	Capture_Init(&capture, &hspi, BW_800_Hz, PRE_TRIGGER, POST_TRIGGER, false, On_Capture, &trigger_entry);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+	Sim_Run_Until(Sim_Now() + 20000000ULL); // fill the pre-trigger history before the first shock
+	Capture_Arm(&capture);
+
+	while (completed < CAPTURES)
+	{
+		if (poll_ns && capture.state == CAPTURE_COLLECTING)
+		{
+			if (!Sim_Wait_Interrupt(SIM_INT1, next_poll > Sim_Now() ? next_poll - Sim_Now() : 0))
+			{
+				next_poll = Sim_Now() + poll_ns;
+				Capture_Process(&capture, Sim_Now() / 1000);
+				continue;
+			}
+		}
+		else if (!Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+		{
+			continue;
+		}
+		before = capture.state;
+		if (before == CAPTURE_ARMED)
+		{
+			trigger_entry = Sim_Now();
+			next_poll = Sim_Now() + poll_ns;
+		}
+		Get_Interrupt_Source(&hspi, &source);
+		Capture_Process(&capture, Sim_Now() / 1000);
+	}
+	printf("%-22s window mean %6.2f ms max %6.2f ms   ready mean %7.1f us max %7.1f us   trigger max %6.1f us   aligned %u/%u   arm errors %u\n",
+		   poll_ns ? "watermark + 1 ms poll" : "watermark only", window_sum / 1e6 / completed, window_max / 1e6, ready_sum / 1e3 / completed,
+		   ready_max / 1e3, trigger_max / 1e3, aligned, completed, capture.arm_errors);
+	return aligned == completed && capture.sequence == completed && capture.arm_errors == 1 && trigger_max < 2 * SAMPLE_NS;
+}
+
+int main(void)
+{
+	printf("1600 Hz, %d pre-trigger + %d post-trigger samples, watermark %d, %d captures\n", PRE_TRIGGER, POST_TRIGGER, PRE_TRIGGER, CAPTURES);
+	bool ok = Run(0);
+	ok = Run(1000000ULL) && ok;
+	return ok ? 0 : 1;
+}
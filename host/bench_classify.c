@@ -0,0 +1,324 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "adxl_classify.h"
+#include "adxl_sim.h"
+#include "classify_tree.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Motion Classifier Benchmark 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Windows of 256 samples at 800 Hz (full resolution, 256 LSB/g) recorded from the simulated sensor through Read_FIFO,
+ * each one labelled with a randomly drawn motion class:
+ *	IDLE		1 g on Z and 3 mg of noise
+ *	RUNNING		20-35 Hz rotation-like vibration of 0.05-0.25 g on X and Y
+ *	FAULT		the same plus 6 ms, 0.3-0.6 g impacts ringing at 250 Hz every 30-60 ms
+ *	TRANSPORT	0.5-3 Hz sway of 0.1-0.4 g, the housing tilted by up to 25 degrees, and road noise
+ * Amplitudes, frequencies and tilt are drawn per window.
+ *
+ *	bench_classify					classifies 800 windows with the tree of classify_tree.h and reports the accuracy, the
+ *									host cost and the RAM and flash used
+ *	bench_classify --features FILE	writes 2000 other windows as training data for train_tree.py (make tree)
+ *
+ * As a cost reference the harness also times an int8 MLP with the same inputs (8-16-4, ReLU, int32 accumulators and
+ * random weights): only its cost is compared, its accuracy is not evaluated.
+ */
+
+#define WINDOW 						256
+#define WATERMARK 					16
+#define TEST_WINDOWS 				800
+#define TRAIN_WINDOWS 				2000
+#define CLASSES 					4
+#define HIDDEN 						16
+#define RUNS 						2000
+#define PI 							3.14159265358979323846
+
+typedef struct t_WindowParameters
+{
+	uint8_t label;
+	double amplitude; 				// g
+	double frequency; 				// Hz
+	double tilt; 					// rad
+	double impact_period; 			// s
+	double impact_amplitude; 		// g
+} t_WindowParameters;
+
+static SPI_HandleTypeDef hspi;
+static t_WindowParameters schedule[TRAIN_WINDOWS];
+static uint32_t windows = 0; 		// windows classified so far
+static uint32_t confusion[CLASSES][CLASSES];
+static FILE *features_file = NULL;
+static uint32_t converted = 0; 		// samples converted by the simulated sensor
+
+static int8_t mlp_w1[HIDDEN][FEATURE_COUNT];
+static int32_t mlp_b1[HIDDEN];
+static int8_t mlp_w2[CLASSES][HIDDEN];
+static int32_t mlp_b2[CLASSES];
+static volatile uint32_t sink = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static double Uniform(double low, double high)
+{
+	return low + (high - low) * (Sim_Random() / 4294967296.0);
+}
+
+static int32_t Noise(int32_t ug)
+{
+	return (int32_t)(Sim_Random() % (uint32_t)(2 * ug + 1)) - ug;
+}
+
+static void Draw_Schedule(uint32_t count)
+{
+	uint32_t i = 0;
+	for (i = 0; i < count; i++)
+	{
+		schedule[i].label = (uint8_t)(Sim_Random() % CLASSES);
+		schedule[i].amplitude = (schedule[i].label == MOTION_TRANSPORT) ? Uniform(0.1, 0.4) : Uniform(0.05, 0.25);
+		schedule[i].frequency = (schedule[i].label == MOTION_TRANSPORT) ? Uniform(0.5, 3) : Uniform(20, 35);
+		schedule[i].tilt = Uniform(-25, 25) * PI / 180;
+		schedule[i].impact_period = Uniform(0.03, 0.06);
+		schedule[i].impact_amplitude = Uniform(0.3, 0.6);
+	}
+}
+
+static void Signal(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	const t_WindowParameters *p = &schedule[(converted / WINDOW < TRAIN_WINDOWS) ? converted / WINDOW : TRAIN_WINDOWS - 1];
+	double t = time / 1e9;
+	double since_impact = 0;
+	(void)arg;
+
+	converted++;
+	acceleration[0] = Noise(3000);
+	acceleration[1] = Noise(3000);
+	acceleration[2] = 1000000 + Noise(3000);
+	switch (p->label)
+	{
+	case MOTION_FAULT:
+		since_impact = fmod(t, p->impact_period);
+		if (since_impact < 0.006)
+		{
+			acceleration[0] += (int32_t)(1e6 * p->impact_amplitude * sin(2 * PI * 250 * since_impact) * (1 - since_impact / 0.006));
+		}
+		// fall through - a fault rides on a running machine
+	case MOTION_RUNNING:
+		acceleration[0] += (int32_t)(1e6 * p->amplitude * sin(2 * PI * p->frequency * t));
+		acceleration[1] += (int32_t)(1e6 * p->amplitude * cos(2 * PI * p->frequency * t));
+		break;
+	case MOTION_TRANSPORT:
+		acceleration[0] = (int32_t)(1e6 * (sin(p->tilt) + p->amplitude * sin(2 * PI * p->frequency * t))) + Noise(30000);
+		acceleration[1] = (int32_t)(1e6 * p->amplitude * 0.5 * cos(2 * PI * p->frequency * t)) + Noise(30000);
+		acceleration[2] = (int32_t)(1e6 * cos(p->tilt)) + Noise(30000);
+		break;
+	default:
+		break;
+	}
+}
+
+static void On_Window(uint8_t motion_class, const int16_t *features, void *arg)
+{
+	uint8_t label = schedule[windows].label;
+	uint8_t i = 0;
+	(void)arg;
+	if (features_file != NULL)
+	{
+		for (i = 0; i < FEATURE_COUNT; i++)
+		{
+			fprintf(features_file, "%d,", features[i]);
+		}
+		fprintf(features_file, "%u\n", label);
+	}
+	else
+	{
+		confusion[label][motion_class < CLASSES ? motion_class : 0]++;
+	}
+	windows++;
+}
+
+/**
+ * @brief Function that records count windows from the simulated sensor and classifies them as they complete
+ *
+ * @param classifier Pointer to the classifier
+ * @param count Number of windows
+ */
+static void Record(t_Classifier *classifier, uint32_t count)
+{
+	t_SimConfig config = {0};
+	t_Sample samples[WATERMARK];
+	t_SampleBlock block;
+	uint32_t sequence = 0;
+
+	config.bus_hz = 5000000;
+	config.seed = 17;
+	config.signal = Signal;
+	Sim_Init(&config);
+	converted = 0;
+	Set_Bandwidth_Rate(&hspi, false, BW_400_Hz);
+	Set_Data_Format(&hspi, false, false, false, true, false, RANGE_4_G);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, false);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+	windows = 0;
+	while (windows < count && Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+	{
+		Read_FIFO(&hspi, samples, WATERMARK);
+		block.sequence = sequence;
+		block.timestamp = 0;
+		block.period = Sample_Period_Ns(BW_400_Hz);
+		block.count = WATERMARK;
+		block.samples = samples;
+		Classify_Process_Block(classifier, &block);
+		sequence += WATERMARK;
+	}
+}
+
+static uint8_t Mlp_Evaluate(const int16_t *features)
+{
+	int32_t hidden[HIDDEN];
+	int32_t best = INT32_MIN;
+	int32_t accumulator = 0;
+	uint8_t result = 0;
+	uint8_t i = 0;
+	uint8_t j = 0;
+	for (i = 0; i < HIDDEN; i++)
+	{
+		accumulator = mlp_b1[i];
+		for (j = 0; j < FEATURE_COUNT; j++)
+		{
+			accumulator += (int32_t)mlp_w1[i][j] * (features[j] >> 8); // inputs requantized to int8
+		}
+		hidden[i] = (accumulator > 0) ? ((accumulator >> 7) > 127 ? 127 : accumulator >> 7) : 0;
+	}
+	for (i = 0; i < CLASSES; i++)
+	{
+		accumulator = mlp_b2[i];
+		for (j = 0; j < HIDDEN; j++)
+		{
+			accumulator += (int32_t)mlp_w2[i][j] * hidden[j];
+		}
+		if (accumulator > best)
+		{
+			best = accumulator;
+			result = i;
+		}
+	}
+	return result;
+}
+
+static void Report_Cost(const t_Classifier *classifier)
+{
+	static t_Sample samples[WINDOW];
+	t_Classifier timing = *classifier;
+	t_SampleBlock block = {0, 0, 0, WINDOW, samples};
+	uint64_t accumulate = 0;
+	uint64_t tree = 0;
+	uint64_t mlp = 0;
+	uint32_t r = 0;
+	uint32_t i = 0;
+
+	for (i = 0; i < WINDOW; i++)
+	{
+		samples[i].x = (int16_t)Noise(300);
+		samples[i].y = (int16_t)Noise(300);
+		samples[i].z = (int16_t)(256 + Noise(30));
+	}
+	for (i = 0; i < HIDDEN * FEATURE_COUNT; i++)
+	{
+		mlp_w1[i / FEATURE_COUNT][i % FEATURE_COUNT] = (int8_t)Sim_Random();
+	}
+	for (i = 0; i < CLASSES * HIDDEN; i++)
+	{
+		mlp_w2[i / HIDDEN][i % HIDDEN] = (int8_t)Sim_Random();
+	}
+
+	timing.callback = NULL;
+	accumulate = Host_Ns();
+	for (r = 0; r < RUNS; r++)
+	{
+		Classify_Process_Block(&timing, &block);
+	}
+	accumulate = Host_Ns() - accumulate;
+	tree = Host_Ns();
+	for (r = 0; r < RUNS * 100; r++)
+	{
+		timing.features[FEATURE_HIGH_BAND] = (int16_t)r;
+		sink += Classify_Evaluate(classify_tree, CLASSIFY_TREE_NODES, timing.features);
+	}
+	tree = Host_Ns() - tree;
+	mlp = Host_Ns();
+	for (r = 0; r < RUNS * 100; r++)
+	{
+		timing.features[FEATURE_HIGH_BAND] = (int16_t)r;
+		sink += Mlp_Evaluate(timing.features);
+	}
+	mlp = Host_Ns() - mlp;
+
+	printf("host   features %.2f ns/sample (%.1f us per window, feature pass included in every inference below)\n", (double)accumulate / RUNS / WINDOW,
+		   (double)accumulate / RUNS / 1000);
+	printf("host   tree %.1f ns/inference (%.1f M inferences/s), int8 MLP 8-16-4 %.1f ns/inference (%.1f M inferences/s)\n", (double)tree / RUNS / 100,
+		   RUNS * 100 * 1e3 / tree, (double)mlp / RUNS / 100, RUNS * 100 * 1e3 / mlp);
+	printf("memory classifier state %zu bytes RAM, tree %zu bytes flash (%d nodes), MLP weights %zu bytes flash\n", sizeof(t_Classifier), sizeof(classify_tree),
+		   CLASSIFY_TREE_NODES, sizeof(mlp_w1) + sizeof(mlp_b1) + sizeof(mlp_w2) + sizeof(mlp_b2));
+}
+
+int main(int argc, char **argv)
+{
+	t_Classifier classifier;
+	uint32_t correct = 0;
+	uint32_t i = 0;
+	uint32_t j = 0;
+
+	if (argc == 3 && strcmp(argv[1], "--features") == 0)
+	{
+		features_file = fopen(argv[2], "w");
+		if (features_file == NULL)
+		{
+			perror(argv[2]);
+			return 1;
+		}
+		Sim_Init(&(t_SimConfig){.seed = 1});
+		Draw_Schedule(TRAIN_WINDOWS);
+		Classify_Init(&classifier, classify_tree, CLASSIFY_TREE_NODES, WINDOW, On_Window, NULL);
+		Record(&classifier, TRAIN_WINDOWS);
+		fclose(features_file);
+		printf("%u training windows written to %s\n", windows, argv[2]);
+		return 0;
+	}
+
+	Sim_Init(&(t_SimConfig){.seed = 2});
+	Draw_Schedule(TEST_WINDOWS);
+	Classify_Init(&classifier, classify_tree, CLASSIFY_TREE_NODES, WINDOW, On_Window, NULL);
+	Record(&classifier, TEST_WINDOWS);
+
+	printf("%u test windows of %d samples at 800 Hz, rows: true class, columns: predicted\n", windows, WINDOW);
+	for (i = 0; i < CLASSES; i++)
+	{
+		printf("  %-10s", (const char *[]){"idle", "running", "fault", "transport"}[i]);
+		for (j = 0; j < CLASSES; j++)
+		{
+			printf(" %5u", confusion[i][j]);
+		}
+		printf("\n");
+		correct += confusion[i][i];
+	}
+	printf("accuracy %.1f %%\n", 100.0 * correct / windows);
+	Report_Cost(&classifier);
+	return (correct * 100 >= windows * 90) ? 0 : 1;
+}
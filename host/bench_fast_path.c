@@ -0,0 +1,315 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include "adxl_latency.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			 SPI Fast Path Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * The driver is built with ADXL_SPI_LL (adxl_ll.o). The host SPI registers are plain memory, so the register-level path
+ * cannot talk to the simulated sensor and its cycle count needs the target board: run Latency_Measure_Reads there once
+ * with Set_SPI_Fast_Path and once without. What the host can check:
+ *	- Latency_Measure_Reads on the HAL path of a device that is not selected: 7 bytes of SPI clock plus two HAL calls
+ *	- Set_SPI_Fast_Path hands out ADXL_SPI_LL_DEVICES slots, refuses one more and frees a slot on disable
+ *	- on a loopback register model (TXE and RXNE always set, DR returns the last byte written) every byte sent is taken
+ *	  back once, the peripheral is enabled and CS ends released, with one start and one complete reported to the bus hook
+ *	- on a stalled register model (RXNE or TXE never set) the transfer gives up with ERR_RECEIVE and releases CS and the bus
+ *
+ * Until DWT figures from the board are attached, a cycle model compares the two paths of Read_6Bytes on an F411 at
+ * 100 MHz. A timed SPI peripheral (shift register plus one-byte transmit buffer, TXE/RXNE/BSY as on the F4) is driven
+ * step by step by a copy of each polling loop: SPI_LL_Transfer, and HAL_SPI_Transmit of the address followed by
+ * HAL_SPI_Receive of six bytes (which runs HAL_SPI_TransmitReceive with one byte in flight). The per-step costs are
+ * estimates read off the F4 HAL polling code, not measurements; the bus idle time and the call overhead follow from the
+ * structure of the loops. For every SPI prescaler the harness checks that:
+ *	- the register-level path takes fewer cycles than the HAL path
+ *	- it keeps the bus busy from the first to the last bit once a byte lasts at least two loop iterations
+ */
+
+#define READS 						10000
+#define BUS_HZ 						5000000
+#define CALL_NS 					1500
+#define CALLS 						2 		// one transmit and one receive
+#define BUS_BYTES 					7 		// DATAX0 address and six data bytes
+
+#define CPU_HZ 						100000000 	// F411 HCLK, SPI1 on APB2 at the same clock
+#define LL_SETUP_CYCLES 			20 		// SPE check, DR and SR dummy reads, bus hook test
+#define LL_ITER_CYCLES 				10 		// one pass of the transfer loop: two SR reads, DR access, counters
+#define LL_CS_CYCLES 				2 		// BSRR store
+#define HAL_GPIO_CYCLES 			12 		// HAL_GPIO_WritePin call
+#define HAL_ENTRY_CYCLES 			120 	// parameter and state checks, lock, HAL_GetTick, handle setup
+#define HAL_ITER_CYCLES 			30 		// one pass of the polling loop, HAL_GetTick timeout check included
+#define HAL_EXIT_CYCLES 			80 		// SPI_EndRxTxTransaction set-up, OVR clear, unlock
+
+typedef struct t_SpiModel
+{
+	uint64_t now; 					// CPU cycles
+	uint32_t byte_cycles; 			// CPU cycles per byte on the bus
+	uint64_t shift_end; 			// end of the byte in the shift register, 0 when idle
+	bool tx_full; 					// a byte waits in the transmit buffer
+	uint8_t rx_ready; 				// received bytes not read yet
+	uint64_t first_bit; 			// start of the first byte
+	uint64_t last_bit; 				// end of the last byte
+	uint64_t busy; 					// cycles the shift register was busy
+	uint32_t overruns;
+} t_SpiModel;
+
+static SPI_HandleTypeDef hspi;
+static SPI_HandleTypeDef fast[ADXL_SPI_LL_DEVICES + 1];
+static SPI_TypeDef registers;
+static uint32_t starts = 0;
+static uint32_t completes = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void Count_Events(SPI_HandleTypeDef *spi, bool complete, void *arg)
+{
+	(void)spi;
+	(void)arg;
+	if (complete)
+	{
+		completes++;
+	}
+	else
+	{
+		starts++;
+	}
+}
+
+static bool Check_Slots(void)
+{
+	bool ok = true;
+	uint8_t i = 0;
+	for (i = 0; i < ADXL_SPI_LL_DEVICES; i++)
+	{
+		ok = ok && Set_SPI_Fast_Path(&fast[i], true) == STATUS_OK_ADXL;
+	}
+	ok = ok && Set_SPI_Fast_Path(&fast[ADXL_SPI_LL_DEVICES], true) == ERR_PARAM;
+	ok = ok && Set_SPI_Fast_Path(&fast[0], false) == STATUS_OK_ADXL;
+	ok = ok && Set_SPI_Fast_Path(&fast[ADXL_SPI_LL_DEVICES], true) == STATUS_OK_ADXL;
+	ok = ok && Set_SPI_Fast_Path(&fast[ADXL_SPI_LL_DEVICES], false) == STATUS_OK_ADXL;
+	for (i = 1; i < ADXL_SPI_LL_DEVICES; i++)
+	{
+		ok = ok && Set_SPI_Fast_Path(&fast[i], false) == STATUS_OK_ADXL;
+	}
+	printf("%d fast path slots: %s\n", ADXL_SPI_LL_DEVICES, ok ? "handed out, one more refused, freed on disable" : "WRONG");
+	return ok;
+}
+
+static bool Check_Loopback(void)
+{
+	int16_t x = -1;
+	int16_t y = -1;
+	int16_t z = -1;
+	uint8_t value = 0xFF;
+	STATUS_ADXL read = STATUS_OK_ADXL;
+	STATUS_ADXL byte = STATUS_OK_ADXL;
+	bool ok = false;
+
+	registers.CR1 = 0;
+	registers.SR = SPI_SR_TXE | SPI_SR_RXNE;
+	registers.DR = 0xA5;
+	fast[0].Instance = &registers;
+	Set_SPI_Fast_Path(&fast[0], true);
+	starts = 0;
+	completes = 0;
+	Set_Bus_Hook(Count_Events, NULL);
+	read = Read_6Bytes(&fast[0], MEASUREMENTS_DATA, &x, &y, &z);
+	byte = Read_Byte(&fast[0], DEVID_0, &value);
+	Set_Bus_Hook(NULL, NULL);
+	Set_SPI_Fast_Path(&fast[0], false);
+
+	// The dummy bytes come back, not the stale 0xA5 or the address
+	ok = read == STATUS_OK_ADXL && byte == STATUS_OK_ADXL && x == 0 && y == 0 && z == 0 && value == 0 && (registers.CR1 & SPI_CR1_SPE) &&
+		 GPIOB->BSRR == CS_Pin && starts == 2 && completes == 2;
+	printf("loopback registers: Read_6Bytes %d (%d, %d, %d), Read_Byte %d (0x%02X), %u starts / %u completes, CS %s\n", read, x, y, z, byte, value,
+		   starts, completes, GPIOB->BSRR == CS_Pin ? "released" : "HELD");
+	return ok;
+}
+
+static bool Check_Stall(uint32_t status)
+{
+	int16_t x = 0;
+	int16_t y = 0;
+	int16_t z = 0;
+	STATUS_ADXL read = STATUS_OK_ADXL;
+	STATUS_ADXL again = STATUS_OK_ADXL;
+
+	registers.SR = status;
+	fast[0].Instance = &registers;
+	Set_SPI_Fast_Path(&fast[0], true);
+	read = Read_6Bytes(&fast[0], MEASUREMENTS_DATA, &x, &y, &z);
+	// The bus must be free again: a second call gets as far as the peripheral instead of ERR_BUSY
+	again = Read_6Bytes(&fast[0], MEASUREMENTS_DATA, &x, &y, &z);
+	Set_SPI_Fast_Path(&fast[0], false);
+	printf("stalled registers (SR 0x%02X): Read_6Bytes %d then %d, CS %s\n", (unsigned)status, read, again, GPIOB->BSRR == CS_Pin ? "released" : "HELD");
+	return read == ERR_RECEIVE && again == ERR_RECEIVE && GPIOB->BSRR == CS_Pin;
+}
+
+static void Model_Run(t_SpiModel *m, uint32_t cycles)
+{
+	uint64_t end = m->now + cycles;
+	while (m->shift_end != 0 && m->shift_end <= end)
+	{
+		m->overruns += m->rx_ready != 0;
+		m->rx_ready = 1;
+		m->last_bit = m->shift_end;
+		m->busy += m->byte_cycles;
+		// The waiting byte moves to the shift register as the previous one ends, with no gap on the bus
+		m->shift_end = m->tx_full ? m->shift_end + m->byte_cycles : 0;
+		m->tx_full = false;
+	}
+	m->now = end;
+}
+
+static void Model_Write(t_SpiModel *m)
+{
+	if (m->shift_end == 0)
+	{
+		m->shift_end = m->now + m->byte_cycles;
+		m->first_bit = m->first_bit ? m->first_bit : m->now;
+	}
+	else
+	{
+		m->tx_full = true;
+	}
+}
+
+static bool Model_Busy(const t_SpiModel *m)
+{
+	return m->shift_end != 0 || m->tx_full;
+}
+
+// SPI_LL_Transfer of the address and six data bytes
+static void Model_LL(t_SpiModel *m)
+{
+	uint8_t sent = 0;
+	uint8_t received = 0;
+	Model_Run(m, LL_SETUP_CYCLES + LL_CS_CYCLES);
+	while (received < 7)
+	{
+		if (sent < 7 && (uint8_t)(sent - received) < 2 && !m->tx_full)
+		{
+			Model_Write(m);
+			sent++;
+		}
+		if (m->rx_ready)
+		{
+			m->rx_ready--;
+			received++;
+		}
+		Model_Run(m, LL_ITER_CYCLES);
+	}
+	while (Model_Busy(m))
+	{
+		Model_Run(m, LL_ITER_CYCLES);
+	}
+	Model_Run(m, LL_CS_CYCLES);
+}
+
+// HAL_SPI_TransmitReceive polling loop: a byte is written only once the previous one has been read back
+static void Model_HAL_Exchange(t_SpiModel *m, uint8_t count)
+{
+	uint8_t tx = count;
+	uint8_t rx = count;
+	bool allowed = true;
+	while (tx > 0 || rx > 0)
+	{
+		if (tx > 0 && allowed && !m->tx_full)
+		{
+			Model_Write(m);
+			tx--;
+			allowed = false;
+		}
+		if (rx > 0 && m->rx_ready)
+		{
+			m->rx_ready--;
+			rx--;
+			allowed = true;
+		}
+		Model_Run(m, HAL_ITER_CYCLES);
+	}
+}
+
+// Read_6Bytes on the HAL: CS, HAL_SPI_Transmit of the address, HAL_SPI_Receive of six bytes, CS
+static void Model_HAL(t_SpiModel *m)
+{
+	Model_Run(m, HAL_GPIO_CYCLES);
+	// HAL_SPI_Transmit of one byte writes it straight away, then waits for BSY to drop and clears the overrun of the unread byte
+	Model_Run(m, HAL_ENTRY_CYCLES);
+	Model_Write(m);
+	while (Model_Busy(m))
+	{
+		Model_Run(m, HAL_ITER_CYCLES);
+	}
+	m->rx_ready = 0;
+	Model_Run(m, HAL_EXIT_CYCLES);
+	// HAL_SPI_Receive in 2-line master mode calls HAL_SPI_TransmitReceive: two entries, then the loop
+	Model_Run(m, 2 * HAL_ENTRY_CYCLES);
+	Model_HAL_Exchange(m, 6);
+	while (Model_Busy(m))
+	{
+		Model_Run(m, HAL_ITER_CYCLES);
+	}
+	Model_Run(m, HAL_EXIT_CYCLES + HAL_GPIO_CYCLES);
+}
+
+/**
+ * @return bool true if the register-level path is faster at every prescaler and keeps the bus busy when a byte lasts two loop iterations
+ */
+static bool Check_Cycle_Model(void)
+{
+	t_SpiModel ll;
+	t_SpiModel hal;
+	uint32_t prescaler = 0;
+	bool ok = true;
+	printf("cycle model, Read_6Bytes at %u MHz: prescaler, SPI clock, register-level / HAL cycles, bus idle between first and last bit\n", CPU_HZ / 1000000);
+	for (prescaler = 2; prescaler <= 64; prescaler <<= 1)
+	{
+		ll = (t_SpiModel){0};
+		hal = (t_SpiModel){0};
+		ll.byte_cycles = 8 * prescaler;
+		hal.byte_cycles = 8 * prescaler;
+		Model_LL(&ll);
+		Model_HAL(&hal);
+		printf("  /%-2u %6.3f MHz: %5u / %5u cycles (%.2fx), idle %4u / %4u cycles, overruns %u / %u\n", prescaler, CPU_HZ / 1e6 / prescaler,
+			   (uint32_t)ll.now, (uint32_t)hal.now, (double)hal.now / ll.now, (uint32_t)(ll.last_bit - ll.first_bit - ll.busy),
+			   (uint32_t)(hal.last_bit - hal.first_bit - hal.busy), ll.overruns, hal.overruns);
+		ok = ok && ll.now < hal.now && ll.overruns == 0 && ll.busy == 7 * ll.byte_cycles;
+		ok = ok && (ll.byte_cycles < 2 * LL_ITER_CYCLES || ll.last_bit - ll.first_bit == ll.busy);
+	}
+	return ok;
+}
+
+int main(void)
+{
+	t_SimConfig config = {0};
+	t_Histogram histogram;
+	STATUS_ADXL measured = STATUS_OK_ADXL;
+	uint32_t expected = 0;
+	bool ok = true;
+
+	config.bus_hz = BUS_HZ;
+	config.call_ns = CALL_NS;
+	config.seed = 5;
+	Sim_Init(&config);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+
+	measured = Latency_Measure_Reads(&hspi, &histogram, READS);
+	expected = (uint32_t)((uint64_t)BUS_BYTES * 8 * 1000000000ULL / BUS_HZ) + CALLS * CALL_NS;
+	printf("HAL path, %u Read_6Bytes at %u Hz: p50 %u, max %u ns (expected %u)\n", READS, BUS_HZ, Histogram_Percentile(&histogram, 50000),
+		   Histogram_Percentile(&histogram, 100000), expected);
+	ok = ok && measured == STATUS_OK_ADXL && histogram.total == READS && Histogram_Percentile(&histogram, 100000) == expected;
+
+	ok = Check_Slots() && ok;
+	ok = Check_Loopback() && ok;
+	ok = Check_Stall(SPI_SR_TXE) && ok;
+	ok = Check_Stall(0) && ok;
+	ok = Check_Cycle_Model() && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "adxl.h"
+#include "adxl_gravity.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Gravity Removal Benchmark 																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * The simulated sensor runs at 100 Hz with a 16-sample watermark; every drain goes through Gravity_Process_Block
+ * (shift 7, 100 mg band) and the linear output is compared, in mg, with the motion the signal put in. Sample truth is
+ * recorded per conversion by the signal callback.
+ *	- Vibration: 30 degrees of tilt, 0.2 g at 10 Hz on X and 0.05 g at 7 Hz on Y, for 60 s, switching from full resolution
+ *	  +/-4 g to 10-bit +/-2 g after 30 s (Gravity_Set_Format). Run without gating and with dynamic_shift 3.
+ *	- Justification: a slow rotation (0.5 degree/s) with 0.05 g at 10 Hz on X, inside the band, in 10-bit +/-2 g right
+ *	  justified (256 LSB/g) and left justified (16384 LSB/g). Both must give the same residual: with the JUSTIFY bit
+ *	  ignored the band shrinks 64 times, every sample reads as motion and the estimate lags the rotation.
+ *	- Gravity_Stage restarts the estimate on an activity or an inactivity interrupt and not on a watermark alone.
+ * It prints the host time per sample of Gravity_Process_Block.
+ */
+
+#define RATE_HZ 					100
+#define WATERMARK 					16
+#define RUN_NS 						60000000000ULL
+#define SETTLE_NS 					5000000000ULL
+#define HISTORY 					64
+#define PI 							3.14159265358979323846
+
+typedef struct t_Motion
+{
+	double tilt; 					// fixed tilt in degrees
+	double rotation; 				// degrees per second added to the tilt
+	double vibration_x; 			// g at 10 Hz
+	double vibration_y; 			// g at 7 Hz
+} t_Motion;
+
+static SPI_HandleTypeDef hspi;
+static double truth[HISTORY][3]; 	// linear acceleration of each conversion in g
+static uint32_t conversions = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void Signal(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	const t_Motion *motion = (const t_Motion *)arg;
+	double t = time * 1e-9;
+	double angle = (motion->tilt + motion->rotation * t) * PI / 180;
+	double *linear = truth[conversions++ % HISTORY];
+	linear[0] = motion->vibration_x * sin(2 * PI * 10 * t);
+	linear[1] = motion->vibration_y * sin(2 * PI * 7 * t);
+	linear[2] = 0;
+	acceleration[0] = (int32_t)lround((sin(angle) + linear[0]) * 1e6);
+	acceleration[1] = (int32_t)lround(linear[1] * 1e6);
+	acceleration[2] = (int32_t)lround(cos(angle) * 1e6);
+}
+
+/**
+ * @return double rms residual in mg after the first SETTLE_NS
+ */
+static double Run(const t_Motion *motion, uint8_t dynamic_shift, uint8_t data_format, uint8_t switch_format, uint32_t *lsb_per_g)
+{
+	t_SimConfig sim = {0};
+	t_SimStats stats;
+	t_GravityConfig config = {7, dynamic_shift, 100};
+	t_Gravity gravity;
+	t_Sample samples[FIFO_SIZE];
+	t_SampleBlock block = {0, 0, 1000000000 / RATE_HZ, 0, samples};
+	double square_sum = 0;
+	double error = 0;
+	uint32_t counted = 0;
+	uint32_t first = 0;
+	uint8_t entries = 0;
+	uint8_t i = 0;
+	uint8_t axis = 0;
+	bool triggered = false;
+	bool switched = false;
+
+	sim.seed = 23;
+	sim.signal = Signal;
+	sim.arg = (void *)motion;
+	Sim_Init(&sim);
+	conversions = 0;
+	Gravity_Init(&gravity, &config, data_format);
+	*lsb_per_g = gravity.lsb_per_g;
+	Set_Bandwidth_Rate(&hspi, false, BW_50_Hz);
+	Set_Data_Format(&hspi, false, false, false, data_format & 0x08, data_format & 0x04, data_format & 0x03);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, true);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+
+	while (Sim_Now() < RUN_NS && Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+	{
+		Get_FIFO_Status(&hspi, &triggered, &entries);
+		Sim_Get_Stats(&stats);
+		first = stats.samples - entries;
+		Read_FIFO(&hspi, samples, entries);
+		block.sequence = first;
+		block.count = entries;
+		Gravity_Process_Block(&gravity, &block, samples);
+		for (i = 0; i < entries && Sim_Now() > SETTLE_NS; i++)
+		{
+			for (axis = 0; axis < 3; axis++)
+			{
+				error = (axis == 0 ? samples[i].x : (axis == 1 ? samples[i].y : samples[i].z)) * 1000.0 / gravity.lsb_per_g -
+						truth[(first + i) % HISTORY][axis] * 1000;
+				square_sum += error * error;
+			}
+			counted++;
+		}
+		if (switch_format && !switched && Sim_Now() > RUN_NS / 2)
+		{
+			Set_Data_Format(&hspi, false, false, false, switch_format & 0x08, switch_format & 0x04, switch_format & 0x03);
+			Gravity_Set_Format(&gravity, switch_format);
+			switched = true;
+		}
+	}
+	return sqrt(square_sum / counted);
+}
+
+static bool Check_Stage_Resets(void)
+{
+	t_GravityConfig config = {7, 0, 100};
+	t_Gravity gravity;
+	t_Sample samples[WATERMARK];
+	t_SampleBlock block = {0, 0, 1000000000 / RATE_HZ, WATERMARK, samples};
+	t_IntSource watermark = {false, false, false, true, false};
+	t_IntSource activity = {false, true, false, true, false};
+	t_IntSource inactivity = {false, false, true, true, false};
+	uint32_t after_watermark = 0;
+	uint32_t after_activity = 0;
+	uint32_t after_inactivity = 0;
+	uint8_t i = 0;
+	bool restarted = true;
+
+	Gravity_Init(&gravity, &config, 0x0B);
+	for (i = 0; i < WATERMARK; i++)
+	{
+		samples[i] = (t_Sample){0, 0, 1024};
+	}
+	Gravity_Stage(&block, samples, NULL, &gravity);
+	block.sequence += WATERMARK;
+	for (i = 0; i < WATERMARK; i++)
+	{
+		samples[i] = (t_Sample){512, 0, 887};
+	}
+	Gravity_Stage(&block, samples, &watermark, &gravity);
+	after_watermark = gravity.resets;
+	// Orientation changed while the sensor was asleep: the first sample after the activity interrupt is the new gravity
+	block.sequence += WATERMARK;
+	for (i = 0; i < WATERMARK; i++)
+	{
+		samples[i] = (t_Sample){-700, 0, 748};
+	}
+	Gravity_Stage(&block, samples, &activity, &gravity);
+	after_activity = gravity.resets;
+	restarted = restarted && samples[0].x == 0 && samples[0].z == 0;
+	block.sequence += WATERMARK;
+	for (i = 0; i < WATERMARK; i++)
+	{
+		samples[i] = (t_Sample){0, 1024, 0};
+	}
+	Gravity_Stage(&block, samples, &inactivity, &gravity);
+	after_inactivity = gravity.resets;
+	restarted = restarted && samples[0].y == 0;
+	printf("Gravity_Stage restarts: watermark %u, activity %u, inactivity %u (first output after a restart %s)\n", after_watermark - 1,
+		   after_activity - after_watermark, after_inactivity - after_activity, restarted ? "0" : "NOT 0");
+	return after_watermark == 1 && after_activity == 2 && after_inactivity == 3 && restarted;
+}
+
+int main(void)
+{
+	t_Motion vibration = {30, 0, 0.2, 0.05};
+	t_Motion rotation = {0, 0.5, 0.05, 0};
+	t_GravityConfig config = {7, 3, 100};
+	t_Gravity gravity;
+	t_Sample samples[WATERMARK];
+	t_SampleBlock block = {0, 0, 1000000000 / RATE_HZ, WATERMARK, samples};
+	uint32_t right_lsb = 0;
+	uint32_t left_lsb = 0;
+	uint32_t lsb = 0;
+	uint64_t host = 0;
+	uint32_t k = 0;
+	double ungated = Run(&vibration, 0, 0x0B, 0x02, &lsb);
+	double gated = Run(&vibration, 3, 0x0B, 0x02, &lsb);
+	double right = Run(&rotation, 3, 0x02, 0, &right_lsb);
+	double left = Run(&rotation, 3, 0x06, 0, &left_lsb);
+	bool ok = true;
+
+	printf("tilt + 0.2 g vibration, range change at 30 s: %.2f mg rms without gating, %.2f mg with it\n", ungated, gated);
+	printf("slow rotation, 10-bit +/-2 g: right justified %u LSB/g %.2f mg rms, left justified %u LSB/g %.2f mg rms\n", right_lsb, right, left_lsb,
+		   left);
+	ok = ok && gated < ungated && right_lsb == 256 && left_lsb == 16384 && fabs(left - right) <= 0.2 * right;
+	ok = Check_Stage_Resets() && ok;
+
+	Gravity_Init(&gravity, &config, 0x0B);
+	for (k = 0; k < WATERMARK; k++)
+	{
+		samples[k] = (t_Sample){(int16_t)(k * 13), (int16_t)(-k * 7), 1024};
+	}
+	host = Host_Ns();
+	for (k = 0; k < 200000; k++)
+	{
+		block.sequence = k * WATERMARK;
+		Gravity_Process_Block(&gravity, &block, samples);
+	}
+	printf("Gravity_Process_Block host %.1f ns/sample\n", (double)(Host_Ns() - host) / (200000.0 * WATERMARK));
+	return ok ? 0 : 1;
+}
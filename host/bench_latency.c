@@ -0,0 +1,141 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include "adxl_latency.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Latency Harness Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * DATA_READY at 800 Hz on the simulated sensor, serviced the way a handler would: Latency_Begin at interrupt entry,
+ * Get_Interrupt_Source and Read_6Bytes with Latency_Bus_Hook installed as the driver bus hook, decode into t_Sample,
+ * delivery to a consumer that stamps the last stage and commits the trace. It runs for every combination of SPI clock
+ * and interrupt entry jitter below and prints p50/p99/max per stage. LATENCY_NOW reads the DWT counter, which the
+ * simulator drives in ns.
+ *
+ * Only the bus and the entry delay take simulated time: the decode and delivery stages read 0 here, on the target they
+ * are whatever the handler costs. The harness checks that:
+ *	- every trace is monotonic and the hook saw both transactions of the sample
+ *	- the bus stage equals 9 bytes of SPI clock plus four HAL calls, within one histogram bucket
+ *	- the edge to entry delay stays within the configured jitter and no sample is lost
+ */
+
+#define INTERRUPTS 					20000
+#define CALL_NS 					1500
+#define CALLS 						4 		// Read_Byte and Read_6Bytes: one transmit and one receive each
+#define BUS_BYTES 					9 		// INT_SOURCE address and value, DATAX0 address and six data bytes
+
+static const uint32_t bus_speeds[] = {1000000, 5000000};
+static const uint32_t jitters[] = {0, 20000};
+static const char *stage_names[STAGE_COUNT - 1] = {"entry->bus", "bus", "bus->decode", "decode->deliver"};
+
+static SPI_HandleTypeDef hspi;
+static t_Latency latency;
+static t_LatencyTrace trace;
+static uint32_t broken = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void Consumer(const t_Sample *sample)
+{
+	uint8_t i = 0;
+	(void)sample;
+	Latency_Mark(&trace, STAGE_DELIVERY);
+	for (i = 0; i < STAGE_COUNT - 1; i++)
+	{
+		if ((int32_t)(trace.time[i + 1] - trace.time[i]) < 0)
+		{
+			broken++;
+		}
+	}
+	if (trace.transactions != 2)
+	{
+		broken++;
+	}
+	Latency_Commit(&latency, &trace);
+}
+
+static void Print(const char *name, const t_Histogram *histogram)
+{
+	printf("  %-16s p50 %7u  p99 %7u  max %7u ns\n", name, Histogram_Percentile(histogram, 50000), Histogram_Percentile(histogram, 99000),
+		   Histogram_Percentile(histogram, 100000));
+}
+
+static bool Run(uint32_t bus_hz, uint32_t jitter_ns)
+{
+	t_SimConfig config = {0};
+	t_SimStats stats;
+	t_Histogram entry;
+	t_IntSource source;
+	t_Sample sample;
+	uint32_t expected = 0;
+	uint32_t bus_p50 = 0;
+	uint32_t bus_max = 0;
+	uint32_t i = 0;
+	uint8_t s = 0;
+
+	config.bus_hz = bus_hz;
+	config.call_ns = CALL_NS;
+	config.jitter_ns = jitter_ns;
+	config.seed = 3;
+	Sim_Init(&config);
+	Latency_Reset(&latency);
+	Histogram_Reset(&entry);
+	broken = 0;
+	Set_Bandwidth_Rate(&hspi, false, BW_400_Hz);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, true, false, false, false, false);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+	Set_Bus_Hook(Latency_Bus_Hook, &trace);
+
+	for (i = 0; i < INTERRUPTS; i++)
+	{
+		if (!Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+		{
+			broken++;
+			break;
+		}
+		Latency_Begin(&trace);
+		Histogram_Record(&entry, (uint32_t)(Sim_Now() - Sim_Edge_Time()));
+		Get_Interrupt_Source(&hspi, &source);
+		Read_6Bytes(&hspi, MEASUREMENTS_DATA, &sample.x, &sample.y, &sample.z);
+		Latency_Mark(&trace, STAGE_DECODE);
+		Consumer(&sample);
+	}
+	Set_Bus_Hook(NULL, NULL);
+	Sim_Get_Stats(&stats);
+
+	printf("bus %u Hz, entry jitter %u ns, %u interrupts\n", bus_hz, jitter_ns, INTERRUPTS);
+	Print("edge->entry", &entry);
+	for (s = 0; s < STAGE_COUNT - 1; s++)
+	{
+		Print(stage_names[s], &latency.stage[s]);
+	}
+	Print("entry->deliver", &latency.total);
+
+	expected = (uint32_t)((uint64_t)BUS_BYTES * 8 * 1000000000ULL / bus_hz) + CALLS * CALL_NS;
+	bus_p50 = Histogram_Percentile(&latency.stage[STAGE_BUS_START], 50000);
+	bus_max = Histogram_Percentile(&latency.stage[STAGE_BUS_START], 100000);
+	printf("  bus expected %u ns, %u broken traces, %u samples lost\n", expected, broken, stats.lost);
+	return broken == 0 && stats.lost == 0 && bus_max == expected && bus_p50 >= expected && bus_p50 <= expected + expected / 16 && entry.max <= jitter_ns;
+}
+
+int main(void)
+{
+	bool ok = true;
+	uint32_t b = 0;
+	uint32_t j = 0;
+	for (b = 0; b < sizeof(bus_speeds) / sizeof(bus_speeds[0]); b++)
+	{
+		for (j = 0; j < sizeof(jitters) / sizeof(jitters[0]); j++)
+		{
+			ok = Run(bus_speeds[b], jitters[j]) && ok;
+		}
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "adxl_log.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Log Format Benchmark 																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Encodes a trace with the log encoder, decodes it back and reports the compression ratio (raw int16 triplets over
+ * encoded bytes) and the host time per sample of both directions. It then corrupts one byte and checks that the
+ * decoder skips exactly the damaged block.
+ *
+ *	bench_log				trace recorded from the simulated sensor: 1600 Hz, full resolution +-4 g, 1 g on Z plus a
+ *							50 Hz 0.3 g / 120 Hz 0.05 g vibration on X and Y and 4 mg of noise, drained by Read_FIFO
+ *	bench_log trace.raw		raw trace: little endian int16 x, y, z per sample, e.g. dumped from a board
+ */
+
+#define TRACE_SAMPLES 				(1600 * 60)
+#define WATERMARK 					16
+#define PI 							3.14159265358979323846
+
+static SPI_HandleTypeDef hspi;
+static t_Sample trace[TRACE_SAMPLES];
+static t_Sample decoded[TRACE_SAMPLES];
+static uint8_t store[TRACE_SAMPLES * 6 + 4096];
+static uint32_t used = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static STATUS_ADXL Store(const uint8_t *data, uint16_t length, void *arg)
+{
+	(void)arg;
+	if (used + length > sizeof(store))
+	{
+		return ERR_PARAM;
+	}
+	memcpy(&store[used], data, length);
+	used += length;
+	return STATUS_OK_ADXL;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static int32_t Noise(void)
+{
+	return (int32_t)(Sim_Random() % 8001) - 4000;
+}
+
+static void Signal(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	double t = time / 1e9;
+	(void)arg;
+	acceleration[0] = (int32_t)(300000 * sin(2 * PI * 50 * t) + 50000 * sin(2 * PI * 120 * t)) + Noise();
+	acceleration[1] = (int32_t)(300000 * cos(2 * PI * 50 * t) + 50000 * sin(2 * PI * 120 * t + 1)) + Noise();
+	acceleration[2] = 1000000 + Noise();
+}
+
+static uint32_t Record(void)
+{
+	t_SimConfig config = {0};
+	uint32_t count = 0;
+
+	config.bus_hz = 5000000;
+	config.seed = 3;
+	config.signal = Signal;
+	Sim_Init(&config);
+	Set_Bandwidth_Rate(&hspi, false, BW_800_Hz);
+	Set_Data_Format(&hspi, false, false, false, true, false, RANGE_4_G);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, false);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+	while (count + WATERMARK <= TRACE_SAMPLES && Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+	{
+		Read_FIFO(&hspi, &trace[count], WATERMARK);
+		count += WATERMARK;
+	}
+	return count;
+}
+
+static uint32_t Load(const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	uint8_t raw[6];
+	uint32_t count = 0;
+
+	if (file == NULL)
+	{
+		perror(path);
+		exit(1);
+	}
+	while (count < TRACE_SAMPLES && fread(raw, 1, sizeof(raw), file) == sizeof(raw))
+	{
+		trace[count].x = (int16_t)(raw[0] | raw[1] << 8);
+		trace[count].y = (int16_t)(raw[2] | raw[3] << 8);
+		trace[count].z = (int16_t)(raw[4] | raw[5] << 8);
+		count++;
+	}
+	fclose(file);
+	return count;
+}
+
+/**
+ * @brief Function that decodes every valid block of the store into decoded[] at its sequence number
+ *
+ * @param blocks Pointer to the number of blocks decoded
+ * @param bad Pointer to the number of resynchronizations
+ * @return uint32_t Samples decoded
+ */
+static uint32_t Decode(uint32_t *blocks, uint32_t *bad)
+{
+	t_LogHeader header;
+	uint32_t offset = 0;
+	uint32_t length = 0;
+	uint32_t samples = 0;
+
+	*blocks = 0;
+	*bad = 0;
+	while (offset < used)
+	{
+		if (Log_Parse_Block(&store[offset], used - offset, &header, &length) != STATUS_OK_ADXL)
+		{
+			(*bad)++;
+			offset++;
+			if (Log_Resync(store, used, &offset) != STATUS_OK_ADXL)
+			{
+				break;
+			}
+			continue;
+		}
+		if (header.sequence + header.count <= TRACE_SAMPLES)
+		{
+			Log_Decode_Samples(&store[offset], &header, &decoded[header.sequence]);
+			samples += header.count;
+		}
+		(*blocks)++;
+		offset += length;
+	}
+	return samples;
+}
+
+int main(int argc, char **argv)
+{
+	t_LogEncoder encoder;
+	t_SampleBlock block;
+	uint32_t count = (argc > 1) ? Load(argv[1]) : Record();
+	uint32_t blocks = 0;
+	uint32_t bad = 0;
+	uint32_t samples = 0;
+	uint32_t i = 0;
+	uint64_t encode = 0;
+	uint64_t decode = 0;
+	bool ok = true;
+
+	printf("%s: %u samples\n", (argc > 1) ? argv[1] : "simulated vibration trace", count);
+
+	Log_Encoder_Init(&encoder, 0x0B, BW_800_Hz, Store, NULL);
+	encode = Host_Ns();
+	for (i = 0; i + WATERMARK <= count; i += WATERMARK)
+	{
+		block.sequence = i;
+		block.timestamp = (uint64_t)i * 625;
+		block.period = 625000;
+		block.count = WATERMARK;
+		block.samples = &trace[i];
+		ok = ok && Log_Encoder_Push(&encoder, &block) == STATUS_OK_ADXL;
+	}
+	ok = ok && Log_Encoder_Flush(&encoder) == STATUS_OK_ADXL;
+	encode = Host_Ns() - encode;
+	count = i;
+
+	decode = Host_Ns();
+	samples = Decode(&blocks, &bad);
+	decode = Host_Ns() - decode;
+	ok = ok && samples == count && bad == 0 && memcmp(decoded, trace, count * sizeof(t_Sample)) == 0;
+
+	printf("ratio %.2f (%u -> %u bytes, %u blocks)  encode %.1f ns/sample  decode %.1f ns/sample  round trip %s\n", (double)encoder.raw_bytes / encoder.encoded_bytes,
+		   encoder.raw_bytes, encoder.encoded_bytes, blocks, (double)encode / count, (double)decode / count, ok ? "exact" : "FAILED");
+
+	// One flipped byte must cost one block and nothing else
+	store[used / 2] ^= 0x55;
+	memset(decoded, 0, sizeof(decoded));
+	samples = Decode(&blocks, &bad);
+	printf("corrupted byte: %u blocks kept, %u samples lost\n", blocks, count - samples);
+	ok = ok && samples < count && count - samples <= LOG_BLOCK_SAMPLES;
+	return ok ? 0 : 1;
+}
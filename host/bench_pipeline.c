@@ -0,0 +1,249 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "adxl_pipeline.h"
+#include "adxl_gravity.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Pipeline Scaling Benchmark 																		  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Built without main.h on the include path, as on a gateway: adxl_pipeline and adxl_gravity only need adxl_types.h.
+ *
+ * Scaling: 48 streams fed by 2 producer threads with 32-sample blocks, each stream running an order check and
+ * Gravity_Stage in place, for 1, 2, 4 and 8 workers. It prints blocks/s and the number of 3200 Hz streams (100 blocks/s
+ * each) that rate sustains, next to the number of online CPUs. With a core for every worker and producer, N workers must
+ * reach at least half of N times the 1-worker rate; with fewer cores the figures stay flat, the scaling is reported as
+ * not checked and has to be read on the gateway itself.
+ *
+ * Idle cost: 4 workers and one producer that pushes a block every millisecond. Workers block on the pipeline condition
+ * variable between blocks, so the process CPU time must stay a small fraction of the wall time (a polling worker keeps a
+ * core busy).
+ *
+ * The harness checks that every block is processed once, in order, in both parts, that the workers scale where the
+ * cores allow it, and that the idle part uses less than a quarter of a core.
+ */
+
+#define STREAMS 					48
+#define PRODUCERS 					2
+#define BLOCK 						32
+#define BLOCKS_PER_STREAM 			2000
+#define STREAM_RATE 				100 	// blocks/s of a 3200 Hz stream
+#define IDLE_BLOCKS 				200
+#define IDLE_PERIOD_NS 				1000000
+#define IDLE_LIMIT 					0.25 	// cores
+#define SCALE_MIN 					0.5 	// fraction of linear scaling required when the cores are there
+
+static const uint8_t worker_counts[] = {1, 2, 4, 8};
+
+static t_PipelineStream streams[STREAMS];
+static t_Pipeline pipeline;
+static t_Gravity gravity[STREAMS];
+static uint32_t next_sequence[STREAMS];
+static uint32_t out_of_order = 0;
+static uint32_t blocks_per_stream = 0;
+static uint32_t idle_blocks = 0;
+static double single_rate = 0; 		// blocks/s with one worker
+static long cpus = 0;
+
+static uint64_t Clock_Ns(clockid_t clock)
+{
+	struct timespec now;
+	clock_gettime(clock, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static STATUS_ADXL Check_Order(const t_SampleBlock *block, t_Sample *samples, const t_IntSource *int_source, void *state)
+{
+	uint32_t *expected = (uint32_t *)state;
+	(void)samples;
+	(void)int_source;
+	if (block->sequence != *expected)
+	{
+		__atomic_fetch_add(&out_of_order, 1, __ATOMIC_RELAXED);
+	}
+	*expected = block->sequence + block->count;
+	return STATUS_OK_ADXL;
+}
+
+static void *Worker(void *arg)
+{
+	Pipeline_Worker(&pipeline, (uint8_t)(uintptr_t)arg);
+	return NULL;
+}
+
+static void *Producer(void *arg)
+{
+	t_Sample samples[BLOCK];
+	t_SampleBlock block = {0, 0, 312500, BLOCK, samples};
+	uint32_t k = 0;
+	uint16_t s = 0;
+	uint8_t i = 0;
+	for (i = 0; i < BLOCK; i++)
+	{
+		samples[i].x = (int16_t)(i * 7);
+		samples[i].y = (int16_t)(-i * 3);
+		samples[i].z = (int16_t)(1024 + i);
+	}
+	for (k = 0; k < blocks_per_stream; k++)
+	{
+		for (s = (uint16_t)(uintptr_t)arg; s < STREAMS; s += PRODUCERS)
+		{
+			block.sequence = k * BLOCK;
+			while (Pipeline_Push(&pipeline, s, &block, NULL) == ERR_BUSY)
+			{
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+
+static void *Slow_Producer(void *arg)
+{
+	t_Sample samples[BLOCK] = {{0}};
+	t_SampleBlock block = {0, 0, 312500, BLOCK, samples};
+	struct timespec delay = {0, IDLE_PERIOD_NS};
+	uint32_t k = 0;
+	(void)arg;
+	for (k = 0; k < idle_blocks; k++)
+	{
+		block.sequence = (k / STREAMS) * BLOCK;
+		Pipeline_Push(&pipeline, (uint16_t)(k % STREAMS), &block, NULL);
+		nanosleep(&delay, NULL);
+	}
+	return NULL;
+}
+
+static void Setup(uint8_t workers)
+{
+	t_GravityConfig config = {6, 0, 0};
+	uint16_t s = 0;
+	Pipeline_Init(&pipeline, streams, STREAMS, workers);
+	for (s = 0; s < STREAMS; s++)
+	{
+		next_sequence[s] = 0;
+		Gravity_Init(&gravity[s], &config, 0x0B);
+		Pipeline_Add_Stage(&pipeline, s, Check_Order, &next_sequence[s]);
+		Pipeline_Add_Stage(&pipeline, s, Gravity_Stage, &gravity[s]);
+	}
+	out_of_order = 0;
+}
+
+static uint64_t Processed(void)
+{
+	uint64_t total = 0;
+	uint16_t s = 0;
+	for (s = 0; s < STREAMS; s++)
+	{
+		total += streams[s].processed;
+	}
+	return total;
+}
+
+static bool Scale(uint8_t workers)
+{
+	pthread_t worker[8];
+	pthread_t producer[PRODUCERS];
+	uint64_t start = 0;
+	double elapsed = 0;
+	double rate = 0;
+	uint64_t total = 0;
+	uint8_t i = 0;
+	bool scaled = true;
+
+	Setup(workers);
+	blocks_per_stream = BLOCKS_PER_STREAM;
+	start = Clock_Ns(CLOCK_MONOTONIC);
+	for (i = 0; i < workers; i++)
+	{
+		pthread_create(&worker[i], NULL, Worker, (void *)(uintptr_t)i);
+	}
+	for (i = 0; i < PRODUCERS; i++)
+	{
+		pthread_create(&producer[i], NULL, Producer, (void *)(uintptr_t)i);
+	}
+	for (i = 0; i < PRODUCERS; i++)
+	{
+		pthread_join(producer[i], NULL);
+	}
+	Pipeline_Stop(&pipeline);
+	for (i = 0; i < workers; i++)
+	{
+		pthread_join(worker[i], NULL);
+	}
+	Pipeline_Deinit(&pipeline);
+	elapsed = (Clock_Ns(CLOCK_MONOTONIC) - start) * 1e-9;
+	total = Processed();
+	rate = total / elapsed;
+	if (workers == 1)
+	{
+		single_rate = rate;
+	}
+	printf("%u workers: %.2f M blocks/s, %.0f streams at %u blocks/s, %u out of order, %u sleeps", workers, rate * 1e-6, rate / STREAM_RATE,
+		   STREAM_RATE, out_of_order, pipeline.waits);
+	if (workers == 1)
+	{
+		printf("\n");
+	}
+	else if (cpus >= workers + PRODUCERS)
+	{
+		scaled = rate >= SCALE_MIN * workers * single_rate;
+		printf(", %.2fx the 1-worker rate%s\n", rate / single_rate, scaled ? "" : " (does NOT scale)");
+	}
+	else
+	{
+		printf(", scaling not checked on %ld CPUs\n", cpus);
+	}
+	return out_of_order == 0 && total == (uint64_t)STREAMS * BLOCKS_PER_STREAM && scaled;
+}
+
+static bool Idle(void)
+{
+	pthread_t worker[4];
+	pthread_t producer;
+	uint64_t wall = 0;
+	uint64_t cpu = 0;
+	double cores = 0;
+	uint8_t i = 0;
+
+	Setup(4);
+	idle_blocks = IDLE_BLOCKS;
+	wall = Clock_Ns(CLOCK_MONOTONIC);
+	cpu = Clock_Ns(CLOCK_PROCESS_CPUTIME_ID);
+	for (i = 0; i < 4; i++)
+	{
+		pthread_create(&worker[i], NULL, Worker, (void *)(uintptr_t)i);
+	}
+	pthread_create(&producer, NULL, Slow_Producer, NULL);
+	pthread_join(producer, NULL);
+	Pipeline_Stop(&pipeline);
+	for (i = 0; i < 4; i++)
+	{
+		pthread_join(worker[i], NULL);
+	}
+	Pipeline_Deinit(&pipeline);
+	cores = (double)(Clock_Ns(CLOCK_PROCESS_CPUTIME_ID) - cpu) / (Clock_Ns(CLOCK_MONOTONIC) - wall);
+	printf("idle: 4 workers, one block per ms: %.3f cores busy over %.2f s, %u sleeps, %lu of %u blocks processed\n", cores,
+		   (Clock_Ns(CLOCK_MONOTONIC) - wall) * 1e-9, pipeline.waits, (unsigned long)Processed(), IDLE_BLOCKS);
+	return cores < IDLE_LIMIT && Processed() == IDLE_BLOCKS && out_of_order == 0;
+}
+
+int main(void)
+{
+	bool ok = true;
+	uint8_t i = 0;
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	printf("%ld online CPUs\n", cpus);
+	for (i = 0; i < sizeof(worker_counts) / sizeof(worker_counts[0]); i++)
+	{
+		ok = Scale(worker_counts[i]) && ok;
+	}
+	ok = Idle() && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "adxl_pool.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Block Pool Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Zero-copy path on the simulated sensor at 3200 Hz: the watermark handler reads INT_SOURCE, takes a pool block,
+ * drains the FIFO into it with Pool_Read_FIFO and hands it to Stream_Push_Block. Two consumers (a logger and an
+ * uplink that retains blocks for a while) get the block itself and recover the pool block with Pool_From_Block.
+ * The uplink stalls once for long enough to overrun the FIFO. The harness checks that:
+ *	- every consumer sees the pool block that was allocated, numbered without holes except the reported gap
+ *	- the overrun is reported as a gap with the samples the sensor lost, within one (the interrupt time stands in for the
+ *	  conversion time of the newest sample)
+ *	- every block returns to the pool, and exhaustion is counted, not hidden
+ *	- a double release asserts (checked in a child process)
+ */
+
+#define DRAINS 						4000
+#define WATERMARK 					16
+#define UPLINK_HOLD 				3 		// blocks the uplink keeps before releasing the oldest
+#define STALL_AT 					2000
+
+static SPI_HandleTypeDef hspi;
+static t_Pool pool;
+static t_Stream stream;
+static t_PoolBlock *current = NULL; 	// block being pushed
+static t_PoolBlock *held[UPLINK_HOLD];
+static uint32_t held_count = 0;
+static uint32_t next_sequence = 0;
+static uint32_t wrong_block = 0;
+static uint32_t holes = 0;
+static uint32_t gap_lost = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void Logger(const t_SampleBlock *block)
+{
+	if (Pool_From_Block(block) != current)
+	{
+		wrong_block++;
+	}
+	if (block->sequence != next_sequence)
+	{
+		holes++;
+	}
+	next_sequence = block->sequence + block->count;
+}
+
+static void Uplink(const t_SampleBlock *block)
+{
+	t_PoolBlock *owner = Pool_From_Block(block);
+	uint32_t i = 0;
+	Pool_Retain(owner);
+	if (held_count == UPLINK_HOLD)
+	{
+		Pool_Release(&pool, held[0]);
+		for (i = 1; i < UPLINK_HOLD; i++)
+		{
+			held[i - 1] = held[i];
+		}
+		held_count--;
+	}
+	held[held_count++] = owner;
+}
+
+static void On_Block(const t_SampleBlock *block, void *arg)
+{
+	(void)arg;
+	Logger(block);
+	Uplink(block);
+}
+
+static void On_Gap(const t_Gap *gap, void *arg)
+{
+	(void)arg;
+	gap_lost += gap->lost;
+	next_sequence += gap->lost;
+}
+
+static bool Double_Release_Asserts(void)
+{
+	t_PoolBlock *block = NULL;
+	int status = 0;
+	pid_t child = fork();
+	if (child == 0)
+	{
+		// No core dump or message clutter from the expected abort
+		freopen("/dev/null", "w", stderr);
+		Pool_Init(&pool);
+		Pool_Alloc(&pool, &block);
+		Pool_Release(&pool, block);
+		Pool_Release(&pool, block);
+		_exit(0);
+	}
+	waitpid(child, &status, 0);
+	return WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT;
+}
+
+int main(void)
+{
+	t_SimConfig config = {0};
+	t_SimStats stats;
+	t_StreamSink sink = {On_Block, On_Gap, NULL};
+	t_IntSource source;
+	uint32_t drains = 0;
+	uint32_t i = 0;
+	uint32_t failed = 0;
+	uint32_t lost_before = 0;
+	bool double_release = false;
+	bool ok = false;
+
+	config.bus_hz = 5000000;
+	config.call_ns = 1500;
+	config.jitter_ns = 2000;
+	config.seed = 11;
+	Sim_Init(&config);
+	Pool_Init(&pool);
+	Stream_Init(&stream, BW_1600_Hz, &sink);
+	Set_Bandwidth_Rate(&hspi, false, BW_1600_Hz);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, WATERMARK);
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, true);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+
+	for (drains = 0; drains < DRAINS; drains++)
+	{
+		if (drains == STALL_AT)
+		{
+			// Uplink stall: the FIFO fills and overruns before the next interrupt is serviced
+			Sim_Get_Stats(&stats);
+			lost_before = stats.lost;
+			Sim_Run_Until(Sim_Now() + 20000000ULL);
+		}
+		Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL);
+		Get_Interrupt_Source(&hspi, &source);
+		if (Pool_Alloc(&pool, &current) != STATUS_OK_ADXL)
+		{
+			failed++;
+			continue;
+		}
+		Pool_Read_FIFO(&hspi, current, source.overrun ? FIFO_SIZE : WATERMARK);
+		Stream_Push_Block(&stream, &source, &current->block, (uint32_t)(Sim_Now() / 1000));
+		Pool_Release(&pool, current); // the producer's reference
+	}
+	for (i = 0; i < held_count; i++)
+	{
+		Pool_Release(&pool, held[i]);
+	}
+	Sim_Get_Stats(&stats);
+	double_release = Double_Release_Asserts();
+
+	printf("%u drains into %d pool blocks of %d samples: %u wrong owner, %u sequence holes, %u failed allocations, high water %u\n", DRAINS, POOL_BLOCKS,
+		   POOL_BLOCK_SAMPLES, wrong_block, holes, failed, pool.in_use_max);
+	printf("overrun: gap of %u samples reported, %u lost by the sensor\n", gap_lost, stats.lost - lost_before);
+	printf("pool after the run: free mask 0x%02X, double release %s\n", (unsigned)pool.free_mask, double_release ? "asserts" : "NOT CAUGHT");
+
+	ok = wrong_block == 0 && holes == 0 && failed == 0 && gap_lost + 1 >= stats.lost - lost_before && gap_lost <= stats.lost - lost_before + 1 && pool.free_mask == ((1UL << POOL_BLOCKS) - 1) && double_release;
+	return ok ? 0 : 1;
+}
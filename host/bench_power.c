@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "adxl_power.h"
+#include "adxl_replay.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Power Model Check 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Runs Power_Optimize on the default model with requirements whose answer can be worked out by hand from the datasheet
+ * table, and checks the pick:
+ *	- tilt logger (1 Hz, 2 s latency, 5 mg, 5 % in motion, 1 s to wake): LOW_POWER 12.5 Hz ODR (55 uA) beats normal
+ *	  6.25 Hz (57 uA), 25-sample watermark, auto-sleep at 1 Hz
+ *	- 0.7 mg noise budget: LOW_POWER is too noisy, so normal 6.25 Hz; 0.2 s to wake only allows the 8 Hz sleep rate
+ *	- no wake delay allowed: the sensor keeps measuring at rest, and the average is the measuring power
+ *	- 2 kHz bandwidth or an activity fraction of 1.5: ERR_PARAM
+ * Then an hour at 12.5 Hz (10 min at rest, 2 min of 0.5 g at 2 Hz, the rest at rest) is written in the log format,
+ * replayed into Power_Profile_Block and turned into segments. The profile must hold about 130 s of motion (the two
+ * minutes plus the 5 s inactivity time twice) in 4 segments, and Power_Battery_Life on a 220 mAh cell must match the
+ * figure worked out from those totals. A configuration that is not available must give 0 hours.
+ */
+
+#define ODR_HZ 						12.5
+#define PERIOD_NS 					80000000U
+#define SAMPLES 					45000U 	// one hour
+#define MOTION_START 				7500U 	// 600 s
+#define MOTION_END 					9000U 	// 720 s
+#define PUSH 						25
+#define THRESHOLD 					64 		// LSB at 1024 LSB/g, 62.5 mg
+#define INACTIVE_SAMPLES 			63 		// 5 s
+#define CAPACITY_MAH 				220.0f
+#define SEGMENTS 					16
+
+static uint8_t recording[1 << 20];
+static uint32_t recorded = 0;
+static t_ReplayEntry index_entries[64];
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static STATUS_ADXL Write(const uint8_t *data, uint16_t length, void *arg)
+{
+	STATUS_ADXL ret_val = ERR_PARAM;
+	(void)arg;
+	if (recorded + length <= sizeof(recording))
+	{
+		memcpy(&recording[recorded], data, length);
+		recorded += length;
+		ret_val = STATUS_OK_ADXL;
+	}
+	return ret_val;
+}
+
+static bool Check_Pick(const char *name, const t_PowerModel *model, const t_PowerRequirement *requirement, uint8_t rate, bool low_power,
+					   uint8_t watermark, bool auto_sleep, uint8_t sleep_rate)
+{
+	t_PowerConfig config;
+	bool ok = Power_Optimize(model, requirement, &config) == STATUS_OK_ADXL;
+	ok = ok && config.rate == rate && config.low_power == low_power && config.watermark == watermark && config.auto_sleep == auto_sleep &&
+		 (!auto_sleep || config.sleep_rate == sleep_rate);
+	printf("%-18s rate 0x%02X %s watermark %2u %s %u: %.1f uW active, %.1f uW at rest, %.1f uW average%s\n", name, config.rate,
+		   config.low_power ? "LOW_POWER" : "normal   ", config.watermark, config.auto_sleep ? "auto-sleep" : "measuring ", config.sleep_rate,
+		   config.active_uw, config.inactive_uw, config.power_uw, ok ? "" : " (WRONG)");
+	return ok;
+}
+
+static bool Record(void)
+{
+	t_LogEncoder encoder;
+	t_SampleBlock block;
+	t_Sample samples[PUSH];
+	uint32_t i = 0;
+	uint32_t j = 0;
+	uint32_t n = 0;
+	double motion = 0;
+	bool ok = true;
+
+	Log_Encoder_Init(&encoder, 0x0B, BW_6_25_Hz, Write, NULL);
+	for (i = 0; i < SAMPLES && ok; i += PUSH)
+	{
+		for (j = 0; j < PUSH; j++)
+		{
+			n = i + j;
+			motion = (n >= MOTION_START && n < MOTION_END) ? 512.0 * sin(2 * 3.14159265358979 * 2.0 * (n - MOTION_START) / ODR_HZ) : 0.0;
+			samples[j].x = (int16_t)(lround(motion) + (int32_t)(n * 7 % 5) - 2);
+			samples[j].y = (int16_t)((int32_t)(n * 3 % 5) - 2);
+			samples[j].z = (int16_t)(1024 + (int32_t)(n * 11 % 5) - 2);
+		}
+		block.sequence = i;
+		block.timestamp = (uint64_t)i * PERIOD_NS / 1000;
+		block.period = PERIOD_NS;
+		block.count = PUSH;
+		block.samples = samples;
+		ok = Log_Encoder_Push(&encoder, &block) == STATUS_OK_ADXL;
+	}
+	return ok && Log_Encoder_Flush(&encoder) == STATUS_OK_ADXL;
+}
+
+int main(void)
+{
+	t_PowerModel model;
+	t_PowerRequirement logger = {1.0f, 2.0f, 5000.0f, 0.05f, 1.0f};
+	t_PowerRequirement quiet = {1.0f, 2.0f, 700.0f, 0.05f, 0.2f};
+	t_PowerRequirement awake = {1.0f, 2.0f, 5000.0f, 0.05f, 0.0f};
+	t_PowerRequirement fast = {2000.0f, 2.0f, 1e9f, 0.05f, 1.0f};
+	t_PowerRequirement wrong = {1.0f, 2.0f, 5000.0f, 1.5f, 1.0f};
+	t_PowerConfig config;
+	t_PowerConfig unavailable = {BW_1600_Hz, true, 16, true, FREC_1HZ, 0.0f, 0.0f, 0.0f};
+	t_PowerSegment segments[SEGMENTS];
+	t_PowerProfile profile;
+	t_Replay replay;
+	t_StreamSink sink = {Power_Profile_Block, NULL, &profile};
+	float active_s = 0.0f;
+	float rest_s = 0.0f;
+	float hours = 0.0f;
+	float expected = 0.0f;
+	uint16_t count = 0;
+	uint16_t i = 0;
+	bool ok = true;
+
+	Power_Default_Model(&model);
+	ok = Check_Pick("tilt logger", &model, &logger, BW_6_25_Hz, true, 25, true, FREC_1HZ) && ok;
+	ok = Check_Pick("0.7 mg noise", &model, &quiet, BW_3_125_Hz, false, 12, true, FREC_8HZ) && ok;
+	ok = Check_Pick("no wake delay", &model, &awake, BW_6_25_Hz, true, 25, false, 0) && ok;
+	Power_Optimize(&model, &awake, &config);
+	ok = ok && config.power_uw == config.active_uw;
+	printf("2 kHz bandwidth: %s, activity 1.5: %s\n", Power_Optimize(&model, &fast, &config) == ERR_PARAM ? "ERR_PARAM" : "NOT refused",
+		   Power_Optimize(&model, &wrong, &config) == ERR_PARAM ? "ERR_PARAM" : "NOT refused");
+	ok = ok && Power_Optimize(&model, &fast, &config) == ERR_PARAM && Power_Optimize(&model, &wrong, &config) == ERR_PARAM;
+
+	ok = Record() && ok;
+	ok = ok && Replay_Open(&replay, recording, recorded, index_entries, 64) == STATUS_OK_ADXL;
+	Power_Profile_Init(&profile, segments, SEGMENTS, THRESHOLD, INACTIVE_SAMPLES);
+	ok = ok && Replay_Run(&replay, &sink, NULL, NULL) == STATUS_OK_ADXL;
+	count = Power_Profile_Finish(&profile);
+	for (i = 0; i < count; i++)
+	{
+		*(segments[i].active ? &active_s : &rest_s) += segments[i].duration_s;
+	}
+	Power_Optimize(&model, &logger, &config);
+	hours = Power_Battery_Life(&model, &config, segments, count, CAPACITY_MAH);
+	expected = CAPACITY_MAH * model.supply * 1000.0f * (active_s + rest_s) / (active_s * config.active_uw + rest_s * config.inactive_uw);
+	printf("recorded hour (%u bytes): %u segments, %.1f s in motion, %.1f s at rest; tilt logger on %.0f mAh: %.0f h (expected %.0f h)\n",
+		   recorded, count, active_s, rest_s, CAPACITY_MAH, hours, expected);
+	ok = ok && count == 4 && fabsf(active_s - 130.0f) < 1.0f && fabsf(active_s + rest_s - 3600.0f) < 0.1f && fabsf(hours - expected) < 0.001f * expected;
+
+	Power_Evaluate(&model, 0.05f, &unavailable);
+	hours = Power_Battery_Life(&model, &unavailable, segments, count, CAPACITY_MAH);
+	printf("LOW_POWER at 3200 Hz ODR: power %.1f uW, battery life %.0f h\n", unavailable.power_uw, hours);
+	ok = ok && unavailable.power_uw < 0.0f && hours == 0.0f;
+	return ok ? 0 : 1;
+}
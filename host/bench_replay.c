@@ -0,0 +1,267 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "adxl_replay_file.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Replay Benchmark 																			  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Writes an hour of 3200 Hz samples in the log format to a file, maps it with Replay_File_Open and measures the
+ * index scan, the replay throughput and the seek time, first with a fixed 255-entry index, then with the index the
+ * reader sizes to the file. The recording starts 60 s before the 32-bit us counter wraps and has one 7-sample gap,
+ * and the fixed index has an odd number of entries, so the harness also checks that:
+ *	- the index entries stay exactly stride blocks apart after every halving
+ *	- every seek by sequence and by time lands on the block that contains the key, on both sides of the wrap
+ *	- Replay_Run reports the gap and nothing else
+ *	- the sized index keeps the stride within REPLAY_FILE_STRIDE, so a seek walks a bounded number of blocks
+ *
+ *	bench_replay [file]		the recording is written to file (default: a temporary file, removed afterwards)
+ */
+
+#define SAMPLES 					(3200U * 3600U)
+#define PUSH 						32
+#define GAP_AT 						(SAMPLES / 3)
+#define GAP_LOST 					7
+#define PERIOD_NS 					312500
+#define START_US 					(0x100000000ULL - 60000000ULL)
+#define INDEX_SIZE 					255
+#define SEEKS 						10000
+
+static t_ReplayEntry index_entries[INDEX_SIZE];
+static t_ReplayFile file;
+static FILE *out = NULL;
+static uint64_t replayed = 0;
+static uint32_t gaps = 0;
+static uint32_t gap_lost = 0;
+static int64_t checksum = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static STATUS_ADXL Write(const uint8_t *data, uint16_t length, void *arg)
+{
+	(void)arg;
+	return (fwrite(data, 1, length, out) == length) ? STATUS_OK_ADXL : ERR_PARAM;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static uint32_t Sequence_Of(uint32_t sample)
+{
+	return sample + ((sample >= GAP_AT) ? GAP_LOST : 0);
+}
+
+static uint64_t Time_Of(uint32_t sequence)
+{
+	return START_US + ((uint64_t)sequence * PERIOD_NS) / 1000;
+}
+
+static void On_Block(const t_SampleBlock *block, void *arg)
+{
+	(void)arg;
+	replayed += block->count;
+	checksum += block->samples[block->count - 1].x;
+}
+
+static void On_Gap(const t_Gap *gap, void *arg)
+{
+	(void)arg;
+	gaps++;
+	gap_lost += gap->lost;
+}
+
+static bool Record(const char *path)
+{
+	t_LogEncoder encoder;
+	t_SampleBlock block;
+	t_Sample samples[PUSH];
+	uint32_t i = 0;
+	uint32_t j = 0;
+	bool ok = true;
+
+	out = fopen(path, "wb");
+	if (out == NULL)
+	{
+		perror(path);
+		return false;
+	}
+	Log_Encoder_Init(&encoder, 0x0B, BW_1600_Hz, Write, NULL);
+	for (i = 0; i < SAMPLES && ok; i += PUSH)
+	{
+		for (j = 0; j < PUSH; j++)
+		{
+			samples[j].x = (int16_t)((i + j) % 97);
+			samples[j].y = (int16_t)((i + j) % 13);
+			samples[j].z = 256;
+		}
+		block.sequence = Sequence_Of(i);
+		block.timestamp = Time_Of(block.sequence);
+		block.period = PERIOD_NS;
+		block.count = PUSH;
+		block.samples = samples;
+		ok = Log_Encoder_Push(&encoder, &block) == STATUS_OK_ADXL;
+	}
+	ok = ok && Log_Encoder_Flush(&encoder) == STATUS_OK_ADXL;
+	fclose(out);
+	return ok;
+}
+
+/**
+ * @brief Function that checks that the entries are stride blocks apart: before the gap every block holds LOG_BLOCK_SAMPLES samples
+ *
+ * @param replay Pointer to the replay
+ * @return bool
+ */
+static bool Check_Index(const t_Replay *replay)
+{
+	uint32_t i = 0;
+	uint32_t sample = 0;
+	for (i = 0; i < replay->index_count; i++)
+	{
+		sample = i * replay->stride * LOG_BLOCK_SAMPLES;
+		if (sample + LOG_BLOCK_SAMPLES > GAP_AT)
+		{
+			break;
+		}
+		if (replay->index[i].sequence != sample || replay->index[i].timestamp != Time_Of(sample))
+		{
+			printf("index entry %u: sequence %u, expected %u\n", i, replay->index[i].sequence, sample);
+			return false;
+		}
+	}
+	return i > 0;
+}
+
+/**
+ * @brief Function that seeks to random samples and checks the block found
+ *
+ * @param replay Pointer to the replay
+ * @param by_time true to seek by time
+ * @param ns Pointer to the mean host time per seek
+ * @return uint32_t Seeks that did not land on the right block
+ */
+static uint32_t Check_Seeks(t_Replay *replay, bool by_time, double *ns)
+{
+	t_SampleBlock block;
+	uint32_t wrong = 0;
+	uint32_t i = 0;
+	uint32_t sequence = 0;
+	uint64_t time = 0;
+	uint64_t spent = 0;
+	uint64_t start = 0;
+	bool found = false;
+
+	srand(by_time ? 2 : 1);
+	for (i = 0; i < SEEKS; i++)
+	{
+		sequence = Sequence_Of((uint32_t)(((uint64_t)rand() * RAND_MAX + rand()) % SAMPLES));
+		time = Time_Of(sequence);
+		start = Host_Ns();
+		found = (by_time ? Replay_Seek_Time(replay, time) : Replay_Seek_Sequence(replay, sequence)) == STATUS_OK_ADXL;
+		spent += Host_Ns() - start;
+		found = found && Replay_Next(replay, &block) == STATUS_OK_ADXL;
+		if (!found || block.sequence > sequence || block.sequence + block.count <= sequence)
+		{
+			wrong++;
+		}
+	}
+	*ns = (double)spent / SEEKS;
+	return wrong;
+}
+
+int main(int argc, char **argv)
+{
+	char path[] = "/tmp/bench_replay_XXXXXX";
+	t_StreamSink sink = {On_Block, On_Gap, NULL};
+	uint64_t open_ns = 0;
+	uint64_t run_ns = 0;
+	double sequence_ns = 0;
+	double time_ns = 0;
+	double sized_sequence_ns = 0;
+	double sized_time_ns = 0;
+	uint32_t wrong_sequence = 0;
+	uint32_t wrong_time = 0;
+	uint32_t wrong_sized = 0;
+	uint32_t index_entries_used = 0;
+	uint32_t index_stride = 0;
+	uint32_t sized_entries = 0;
+	uint32_t sized_stride = 0;
+	bool index_ok = false;
+	bool ok = false;
+	int fd = -1;
+
+	if (argc < 2)
+	{
+		fd = mkstemp(path);
+		if (fd < 0)
+		{
+			perror(path);
+			return 1;
+		}
+		close(fd);
+	}
+	if (!Record((argc > 1) ? argv[1] : path))
+	{
+		return 1;
+	}
+
+	open_ns = Host_Ns();
+	if (Replay_File_Open(&file, (argc > 1) ? argv[1] : path, index_entries, INDEX_SIZE) != STATUS_OK_ADXL)
+	{
+		printf("open failed\n");
+		return 1;
+	}
+	open_ns = Host_Ns() - open_ns;
+	index_ok = Check_Index(&file.replay);
+	index_entries_used = file.replay.index_count;
+	index_stride = file.replay.stride;
+
+	run_ns = Host_Ns();
+	Replay_Run(&file.replay, &sink, NULL, NULL);
+	run_ns = Host_Ns() - run_ns;
+
+	wrong_sequence = Check_Seeks(&file.replay, false, &sequence_ns);
+	wrong_time = Check_Seeks(&file.replay, true, &time_ns);
+	Replay_File_Close(&file);
+
+	if (Replay_File_Open(&file, (argc > 1) ? argv[1] : path, NULL, 0) != STATUS_OK_ADXL)
+	{
+		printf("open with a sized index failed\n");
+		return 1;
+	}
+	sized_entries = file.replay.index_count;
+	sized_stride = file.replay.stride;
+	wrong_sized = Check_Seeks(&file.replay, false, &sized_sequence_ns);
+	wrong_sized += Check_Seeks(&file.replay, true, &sized_time_ns);
+
+	printf("%u samples (%.1f min at 3200 Hz, crossing the 32-bit us wrap), %u bytes, %u blocks\n", SAMPLES, SAMPLES / 3200.0 / 60, file.size, file.replay.blocks);
+	printf("open  %6.1f ms (%.0f MB/s)  index %u/%u entries, stride %u, spacing %s\n", open_ns / 1e6, file.size * 1e3 / open_ns, index_entries_used, INDEX_SIZE,
+		   index_stride, index_ok ? "exact" : "WRONG");
+	printf("run   %6.1f ms (%.1f M samples/s)  %llu samples, %u gap of %u samples\n", run_ns / 1e6, replayed * 1e3 / run_ns, (unsigned long long)replayed, gaps, gap_lost);
+	printf("seek  by sequence %.0f ns, by time %.0f ns  misplaced %u + %u of %u\n", sequence_ns, time_ns, wrong_sequence, wrong_time, 2 * SEEKS);
+	printf("sized index %u entries, stride %u: seek by sequence %.0f ns, by time %.0f ns  misplaced %u of %u\n", sized_entries, sized_stride, sized_sequence_ns,
+		   sized_time_ns, wrong_sized, 2 * SEEKS);
+
+	ok = index_ok && replayed == SAMPLES && gaps == 1 && gap_lost == GAP_LOST && wrong_sequence == 0 && wrong_time == 0 && checksum != 0;
+	ok = ok && wrong_sized == 0 && sized_stride <= REPLAY_FILE_STRIDE;
+	Replay_File_Close(&file);
+	if (argc < 2)
+	{
+		unlink(path);
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "adxl_shock.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Shock Detector Benchmark 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Scripted 1600 Hz stream (full resolution, 256 LSB/g, noise on every axis over 1 g on Z) with one event every 400
+ * samples, cycling through: single shock, double shock, vibration burst longer than the duration, and a shock followed
+ * by a burst in the window. The detector (threshold 2 g, duration 8, latency 20, window 100 samples) must report
+ * SINGLE, DOUBLE, nothing and SINGLE, each exactly once; a DOUBLE must carry the peak of its first shock as well. The stream is then replayed to measure the host time per
+ * sample, both for the whole stream and for a quiet stream that only takes the idle fast path.
+ */
+
+#define SAMPLES 					(400 * 400)
+#define EVENT_SPACING 				400
+#define BLOCK 						32
+#define RUNS 						50
+
+static t_Sample stream[SAMPLES];
+static t_Sample quiet[SAMPLES];
+static uint32_t reports[2] = {0};
+static uint32_t wrong = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static void On_Shock(const t_ShockEvent *event, void *arg)
+{
+	uint32_t kind = (event->index / EVENT_SPACING) % 4;
+	(void)arg;
+	reports[event->type]++;
+	// Singles come from kinds 0 and 3, doubles from kind 1 (peak of the second shock); kind 2 must stay silent
+	if ((event->type == SHOCK_SINGLE && kind != 0 && kind != 3) || (event->type == SHOCK_DOUBLE && kind != 1))
+	{
+		wrong++;
+	}
+	// The first shock of a double spans samples 100 - 102 of its event, the second 150 - 153
+	if (event->type == SHOCK_DOUBLE &&
+		(event->first_index % EVENT_SPACING < 100 || event->first_index % EVENT_SPACING > 102 || event->index % EVENT_SPACING < 150 || event->first_peak < 700 * 700))
+	{
+		wrong++;
+	}
+	if (event->type == SHOCK_SINGLE && (event->first_index != event->index || event->first_peak != event->peak))
+	{
+		wrong++;
+	}
+}
+
+static void Pulse(uint32_t start, uint32_t length, int16_t x)
+{
+	uint32_t i = 0;
+	for (i = start; i < start + length && i < SAMPLES; i++)
+	{
+		stream[i].x = x;
+	}
+}
+
+static void Build(void)
+{
+	uint32_t i = 0;
+	for (i = 0; i < SAMPLES; i++)
+	{
+		quiet[i].x = (int16_t)(Sim_Random() % 11) - 5;
+		quiet[i].y = (int16_t)(Sim_Random() % 11) - 5;
+		quiet[i].z = (int16_t)(256 + (int16_t)(Sim_Random() % 11) - 5);
+		stream[i] = quiet[i];
+	}
+	for (i = 100; i < SAMPLES; i += EVENT_SPACING)
+	{
+		switch ((i / EVENT_SPACING) % 4)
+		{
+		case 0:
+			Pulse(i, 4, 900);
+			break;
+		case 1:
+			Pulse(i, 3, 800);
+			Pulse(i + 50, 4, 1000);
+			break;
+		case 2:
+			Pulse(i, 60, 700);
+			break;
+		default:
+			Pulse(i, 3, 800);
+			Pulse(i + 50, 60, 700);
+			break;
+		}
+	}
+}
+
+static uint64_t Run(t_Shock *shock, const t_Sample *samples)
+{
+	t_SampleBlock block;
+	uint64_t start = Host_Ns();
+	uint32_t i = 0;
+
+	for (i = 0; i < SAMPLES; i += BLOCK)
+	{
+		block.sequence = i;
+		block.timestamp = 0;
+		block.period = 625000;
+		block.count = BLOCK;
+		block.samples = &samples[i];
+		Shock_Process_Block(shock, &block);
+	}
+	return Host_Ns() - start;
+}
+
+int main(void)
+{
+	t_ShockConfig config = {512, 8, 20, 100};
+	t_Shock shock;
+	uint32_t events = SAMPLES / EVENT_SPACING;
+	uint64_t busy = 0;
+	uint64_t idle = 0;
+	uint32_t r = 0;
+	bool ok = false;
+
+	Sim_Init(&(t_SimConfig){.seed = 5});
+	Build();
+	Shock_Init(&shock, &config, On_Shock, NULL);
+	Run(&shock, stream);
+	printf("%u scripted events: %u single (expected %u), %u double (expected %u), %u misreported\n", events, reports[SHOCK_SINGLE], events / 2, reports[SHOCK_DOUBLE],
+		   events / 4, wrong);
+	ok = reports[SHOCK_SINGLE] == events / 2 && reports[SHOCK_DOUBLE] == events / 4 && wrong == 0;
+
+	Shock_Init(&shock, &config, NULL, NULL);
+	for (r = 0; r < RUNS; r++)
+	{
+		busy += Run(&shock, stream);
+		idle += Run(&shock, quiet);
+	}
+	printf("host %.2f ns/sample with events, %.2f ns/sample idle (%u-sample blocks)\n", (double)busy / RUNS / SAMPLES, (double)idle / RUNS / SAMPLES, BLOCK);
+	return ok ? 0 : 1;
+}
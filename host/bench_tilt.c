@@ -0,0 +1,196 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "adxl_tilt.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																				Tilt Benchmark 																				  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Compares the integer tilt math with libm:
+ *	Tilt_Atan2		every 0.01 degree step of a radius 4096 circle, against atan2
+ *	Tilt_Isqrt		every root boundary up to 65535 plus random values, against the exactly rounded root
+ *	Tilt_Angles		random orientations at 256 LSB/g (full resolution) and at the int16 extremes, against atan2f/sqrtf
+ * and measures the host time per Tilt_Angles call against the same computation with atan2f/sqrtf. The accuracy limits
+ * are the ones documented in adxl_tilt.h; the harness fails if they are exceeded.
+ */
+
+#define ORIENTATIONS 				200000
+#define RUNS 						20
+#define PI 							3.14159265358979323846
+
+static t_Sample samples[ORIENTATIONS];
+static volatile int32_t sink = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static uint64_t Host_Ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static double Angle_Error(double a, double b)
+{
+	double d = fabs(a - b);
+	return (d > 18000) ? 36000 - d : d;
+}
+
+static double Check_Atan2(void)
+{
+	double worst = 0;
+	double error = 0;
+	int32_t step = 0;
+	for (step = -18000; step < 18000; step++)
+	{
+		double angle = step * PI / 18000;
+		int32_t x = (int32_t)lround(4096 * cos(angle));
+		int32_t y = (int32_t)lround(4096 * sin(angle));
+		error = Angle_Error(Tilt_Atan2(y, x), atan2(y, x) * 18000 / PI);
+		worst = (error > worst) ? error : worst;
+	}
+	return worst / 100;
+}
+
+static uint32_t Check_Isqrt(void)
+{
+	uint32_t wrong = 0;
+	uint32_t root = 0;
+	uint32_t i = 0;
+	uint32_t value = 0;
+	// Rounded to nearest: r^2 + r is the largest value that still rounds down to r
+	for (root = 1; root < 65535; root++)
+	{
+		value = root * root + root;
+		wrong += Tilt_Isqrt(value) != root;
+		wrong += Tilt_Isqrt(value + 1) != root + 1;
+	}
+	for (i = 0; i < 1000000; i++)
+	{
+		value = Sim_Random();
+		wrong += Tilt_Isqrt(value) != (uint32_t)fmin(llround(sqrt((double)value)), 65535);
+	}
+	return wrong;
+}
+
+static void Make_Samples(double scale)
+{
+	uint32_t i = 0;
+	for (i = 0; i < ORIENTATIONS; i++)
+	{
+		// Uniform on the sphere
+		double z = 2.0 * (Sim_Random() / 4294967296.0) - 1.0;
+		double phi = 2.0 * PI * (Sim_Random() / 4294967296.0);
+		double r = sqrt(1.0 - z * z);
+		samples[i].x = (int16_t)lround(scale * r * cos(phi));
+		samples[i].y = (int16_t)lround(scale * r * sin(phi));
+		samples[i].z = (int16_t)lround(scale * z);
+	}
+}
+
+static double Check_Angles(void)
+{
+	double worst = 0;
+	double error = 0;
+	int16_t pitch = 0;
+	int16_t roll = 0;
+	uint32_t i = 0;
+	for (i = 0; i < ORIENTATIONS; i++)
+	{
+		float y = samples[i].y;
+		float z = samples[i].z;
+		Tilt_Angles(&samples[i], &pitch, &roll);
+		error = Angle_Error(pitch, atan2f(-samples[i].x, sqrtf(y * y + z * z)) * 18000 / (float)PI);
+		worst = (error > worst) ? error : worst;
+		// Roll is undefined straight up or down
+		if (samples[i].y != 0 || samples[i].z != 0)
+		{
+			error = Angle_Error(roll, atan2f(y, z) * 18000 / (float)PI);
+			worst = (error > worst) ? error : worst;
+		}
+	}
+	return worst / 100;
+}
+
+static double Time_Integer(void)
+{
+	int16_t pitch = 0;
+	int16_t roll = 0;
+	uint32_t i = 0;
+	uint32_t r = 0;
+	uint64_t start = Host_Ns();
+	for (r = 0; r < RUNS; r++)
+	{
+		for (i = 0; i < ORIENTATIONS; i++)
+		{
+			Tilt_Angles(&samples[i], &pitch, &roll);
+			sink += pitch + roll;
+		}
+	}
+	return (double)(Host_Ns() - start) / RUNS / ORIENTATIONS;
+}
+
+static double Time_Libm(void)
+{
+	uint32_t i = 0;
+	uint32_t r = 0;
+	uint64_t start = Host_Ns();
+	for (r = 0; r < RUNS; r++)
+	{
+		for (i = 0; i < ORIENTATIONS; i++)
+		{
+			float x = samples[i].x;
+			float y = samples[i].y;
+			float z = samples[i].z;
+			int16_t pitch = (int16_t)lrintf(atan2f(-x, sqrtf(y * y + z * z)) * 18000 / (float)PI);
+			int16_t roll = (int16_t)lrintf(atan2f(y, z) * 18000 / (float)PI);
+			sink += pitch + roll;
+		}
+	}
+	return (double)(Host_Ns() - start) / RUNS / ORIENTATIONS;
+}
+
+int main(void)
+{
+	t_Sample extreme[] = {{-32768, -32768, -32768}, {32767, -32768, -32768}, {0, 32767, 32767}, {-32768, 0, -32768}};
+	double atan2_error = 0;
+	double angles_error = 0;
+	double extreme_error = 0;
+	double error = 0;
+	double integer_ns = 0;
+	double libm_ns = 0;
+	uint32_t isqrt_wrong = 0;
+	uint32_t i = 0;
+	int16_t pitch = 0;
+	int16_t roll = 0;
+
+	Sim_Init(&(t_SimConfig){.seed = 9});
+	atan2_error = Check_Atan2();
+	isqrt_wrong = Check_Isqrt();
+	Make_Samples(256);
+	angles_error = Check_Angles();
+	integer_ns = Time_Integer();
+	libm_ns = Time_Libm();
+
+	// Squares of the int16 extremes sum to 2^31: the pitch must still match libm
+	for (i = 0; i < sizeof(extreme) / sizeof(extreme[0]); i++)
+	{
+		Tilt_Angles(&extreme[i], &pitch, &roll);
+		error = Angle_Error(pitch, atan2(-extreme[i].x, sqrt((double)extreme[i].y * extreme[i].y + (double)extreme[i].z * extreme[i].z)) * 18000 / PI) / 100;
+		extreme_error = (error > extreme_error) ? error : extreme_error;
+	}
+
+	printf("Tilt_Atan2   max error %.3f deg over 36000 angles (limit 0.1)\n", atan2_error);
+	printf("Tilt_Isqrt   %u wrong roots\n", isqrt_wrong);
+	printf("Tilt_Angles  max error %.3f deg at 256 LSB/g, %.3f deg at the int16 extremes (limit 0.2)\n", angles_error, extreme_error);
+	printf("host         %.1f ns/call integer, %.1f ns/call atan2f + sqrtf (%.2fx)\n", integer_ns, libm_ns, libm_ns / integer_ns);
+	return (atan2_error <= 0.1 && isqrt_wrong == 0 && angles_error <= 0.2 && extreme_error <= 0.2) ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include "adxl_watchdog.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Configuration Watchdog Check 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * The watchdog guards a simulated sensor set up for 400 Hz FIFO streaming with activity detection (5 MHz bus, 3 us
+ * transaction overhead). The harness checks that:
+ *	- Watchdog_Step before any capture returns ERR_PARAM and does not touch the bus
+ *	- a capture whose second burst fails part-way returns ERR_READING and leaves the previous expected values and CRC as
+ *	  they were, so the next check still restores the good configuration and not the half-read one
+ *	- a clean sensor passes a check in the four burst reads, with no drift
+ *	- after a brown-out that clears part of the configuration, checks run in 25 us budgets rewrite exactly the registers
+ *	  that differ, POWER_CTL last, and the sensor ends with the captured values
+ *	- a budget below one transaction returns ERR_BUSY
+ */
+
+#define SPI_HZ 						5000000
+#define OVERHEAD_US 				3
+#define BUDGET_US 					25
+
+// Register of each position in the watchdog arrays (0x21 - 0x23 are reserved and not compared)
+static const uint8_t addresses[WATCHDOG_REGISTERS] = {0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x2C, 0x2D, 0x2E, 0x2F, 0x31, 0x38};
+
+static SPI_HandleTypeDef hspi;
+static t_Watchdog watchdog;
+static uint8_t reported[WATCHDOG_REGISTERS];
+static uint32_t reports = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+static void On_Drift(uint8_t address, uint8_t expected, uint8_t actual, void *arg)
+{
+	(void)expected;
+	(void)actual;
+	(void)arg;
+	if (reports < WATCHDOG_REGISTERS)
+	{
+		reported[reports] = address;
+	}
+	reports++;
+}
+
+static void Configure(void)
+{
+	Set_Bandwidth_Rate(&hspi, false, BW_200_Hz);
+	Set_Data_Format(&hspi, false, false, false, true, false, RANGE_2_G);
+	Set_FIFO_Control(&hspi, FIFO_STREAM, false, 16);
+	Set_Threshold_Activity(&hspi, 12);
+	Set_Threshold_Inactivity(&hspi, 4);
+	Set_Time_Inactivity(&hspi, 5);
+	Set_Activity_Inactivity_Control(&hspi, AC_SET, AC_SET, true, true, true);
+	Set_Interrupt_Pins(&hspi, false, true, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, true, true, true, true);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+}
+
+static uint32_t Transactions(void)
+{
+	t_SimStats stats;
+	Sim_Get_Stats(&stats);
+	return stats.transactions;
+}
+
+int main(void)
+{
+	t_SimConfig config = {0};
+	uint8_t expected[WATCHDOG_REGISTERS];
+	uint16_t expected_crc = 0;
+	uint32_t before = 0;
+	uint32_t calls = 0;
+	uint32_t wrong = 0;
+	uint8_t i = 0;
+	STATUS_ADXL early = STATUS_OK_ADXL;
+	STATUS_ADXL partial = STATUS_OK_ADXL;
+	STATUS_ADXL status = STATUS_OK_ADXL;
+	bool ok = true;
+
+	config.bus_hz = SPI_HZ;
+	config.call_ns = 1500;
+	config.seed = 9;
+	Sim_Init(&config);
+	Configure();
+	Watchdog_Init(&watchdog, SPI_HZ, OVERHEAD_US, On_Drift, NULL);
+
+	before = Transactions();
+	early = Watchdog_Step(&hspi, &watchdog, 1000);
+	printf("step before capture: %s, %u transactions\n", early == ERR_PARAM ? "ERR_PARAM" : "accepted", Transactions() - before);
+	ok = ok && early == ERR_PARAM && Transactions() == before;
+
+	ok = ok && Watchdog_Capture(&hspi, &watchdog) == STATUS_OK_ADXL;
+	memcpy(expected, watchdog.expected, sizeof(expected));
+	expected_crc = watchdog.expected_crc;
+
+	// Second burst (0x2C - 0x2F) stalls half way, on a sensor whose configuration has been changed meanwhile
+	Sim_Poke(THRESHOLD_ACTIVITY, 40);
+	Sim_Poke(INTERRUPT_ENABLE, 0);
+	Sim_Fail_Receive(1);
+	partial = Watchdog_Capture(&hspi, &watchdog);
+	printf("capture failing in the second burst: %s, expected values %s, CRC %s\n", partial == ERR_READING ? "ERR_READING" : "accepted",
+		   memcmp(expected, watchdog.expected, sizeof(expected)) ? "CHANGED" : "kept", watchdog.expected_crc == expected_crc ? "kept" : "CHANGED");
+	ok = ok && partial == ERR_READING && memcmp(expected, watchdog.expected, sizeof(expected)) == 0 && watchdog.expected_crc == expected_crc;
+	while (watchdog.phase != WATCHDOG_IDLE || calls == 0)
+	{
+		Watchdog_Step(&hspi, &watchdog, 1000);
+		calls++;
+	}
+	ok = ok && Sim_Peek(THRESHOLD_ACTIVITY) == 12 && Sim_Peek(INTERRUPT_ENABLE) == expected[12];
+
+	before = Transactions();
+	status = Watchdog_Step(&hspi, &watchdog, 1000);
+	printf("clean check: %d in %u transactions, %u drifts so far\n", status, Transactions() - before, watchdog.drifts);
+	ok = ok && status == STATUS_OK_ADXL && Transactions() - before == WATCHDOG_BURSTS && watchdog.phase == WATCHDOG_IDLE;
+
+	// Brown-out: measurement off, rate, format, FIFO and thresholds back to their reset values
+	Sim_Poke(PWR_CNTRL, 0x00);
+	Sim_Poke(BW_RATE, 0x0A);
+	Sim_Poke(DATA_FORMAT, 0x00);
+	Sim_Poke(FIFO_CTL, 0x00);
+	Sim_Poke(THRESHOLD_ACTIVITY, 0x00);
+	reports = 0;
+	calls = 0;
+	do
+	{
+		status = Watchdog_Step(&hspi, &watchdog, BUDGET_US);
+		calls++;
+	} while (watchdog.phase != WATCHDOG_IDLE && calls < 100);
+	for (i = 0; i < WATCHDOG_REGISTERS; i++)
+	{
+		wrong += (i < 3 || i > 5) && Sim_Peek(addresses[i]) != expected[i];
+	}
+	printf("brown-out: %u registers rewritten in %u calls of %u us, last %s, %u differ from the capture\n", reports, calls, BUDGET_US,
+		   reported[reports - 1] == PWR_CNTRL ? "POWER_CTL" : "OTHER", wrong);
+	ok = ok && reports == 5 && reported[reports - 1] == PWR_CNTRL && wrong == 0 && calls > 1;
+
+	status = Watchdog_Step(&hspi, &watchdog, OVERHEAD_US);
+	printf("budget of %u us: %s\n", OVERHEAD_US, status == ERR_BUSY ? "ERR_BUSY" : "ran");
+	ok = ok && status == ERR_BUSY;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include "adxl_watermark.h"
+#include "adxl_sim.h"
+
+/******************************************************************************************************************************************************************************/
+/*																			Watermark Controller Benchmark 																	  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * The simulated sensor runs at 400 Hz in stream mode with the watermark and overrun interrupts on INT1 (5 MHz bus,
+ * 1.5 us per HAL call). Each interrupt is entered 100 - 300 us after its edge, and 1 % of them 4 - 8 ms late; the handler
+ * reads INT_SOURCE and FIFO_STATUS, drains the entries with Read_FIFO and, in the adaptive run, calls Watermark_Update
+ * and Watermark_Apply. The age of the oldest sample of each drain is taken from the conversion times recorded by the
+ * signal callback, independently of the controller's own estimate. Ten simulated minutes each, with a 20 ms age target:
+ * watermark fixed at 4, fixed at 8, adaptive on the measured latency peak only, and adaptive with the 8.3 ms worst case
+ * configured.
+ *
+ * On the measured peak alone the target is soft: the peak is forgotten after one to two windows and the next spike finds
+ * the watermark grown back, so only the number of late drains is printed. The harness checks that the run with the
+ * configured worst case has no late drain and no overrun, raises fewer interrupts than the fixed watermark of 4, and
+ * that FIFO_CTL holds the watermark it last applied.
+ */
+
+#define RUN_NS 						600000000000ULL
+#define MAX_AGE_US 					20000
+#define ENTRY_NS 					100000
+#define JITTER_NS 					200000
+#define SPIKE_NS 					4000000 	// 1 % of the interrupts are entered 4 - 8 ms late
+#define WORST_LATENCY_US 			((ENTRY_NS + JITTER_NS + 2 * SPIKE_NS) / 1000)
+#define HISTORY 					64 		// conversion times kept, more than the FIFO holds
+
+typedef struct t_Run
+{
+	uint32_t interrupts;
+	uint32_t late;
+	uint32_t overruns;
+	uint32_t worst_age; 			// us
+	uint8_t watermark; 				// final setting
+	bool fifo_ctl_ok;
+} t_Run;
+
+static SPI_HandleTypeDef hspi;
+static uint64_t conversion[HISTORY];
+static uint32_t conversions = 0;
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *spi)
+{
+	(void)spi;
+}
+
+// 1 g on Z, and the time of every conversion for the age measurement
+static void Record(uint64_t time, int32_t acceleration[3], void *arg)
+{
+	(void)arg;
+	acceleration[0] = 0;
+	acceleration[1] = 0;
+	acceleration[2] = 1000000;
+	conversion[conversions++ % HISTORY] = time;
+}
+
+static t_Run Run(uint8_t fixed, uint32_t worst_latency)
+{
+	t_SimConfig sim = {0};
+	t_SimStats stats;
+	t_WatermarkConfig config = {MAX_AGE_US, 1, 31, FIFO_STREAM, worst_latency};
+	t_Watermark control;
+	t_IntSource source;
+	t_Sample samples[FIFO_SIZE];
+	t_Run run = {0};
+	uint64_t start = 0;
+	uint32_t latency = 0;
+	uint32_t age = 0;
+	uint8_t entries = 0;
+	bool triggered = false;
+
+	sim.bus_hz = 5000000;
+	sim.call_ns = 1500;
+	sim.jitter_ns = JITTER_NS;
+	sim.seed = 13;
+	sim.signal = Record;
+	Sim_Init(&sim);
+	conversions = 0;
+	Watermark_Init(&control, &config, BW_200_Hz);
+	Set_Bandwidth_Rate(&hspi, false, BW_200_Hz);
+	if (fixed)
+	{
+		Set_FIFO_Control(&hspi, FIFO_STREAM, false, fixed);
+	}
+	else
+	{
+		Watermark_Apply(&hspi, &control);
+	}
+	Set_Interrupt_Pins(&hspi, false, false, false, false, false);
+	Set_Interrupt_Enable(&hspi, false, false, false, true, true);
+	Set_Power_Control(&hspi, false, false, false, true, false, 0);
+
+	while (Sim_Now() < RUN_NS && Sim_Wait_Interrupt(SIM_INT1, 1000000000ULL))
+	{
+		Sim_Run_Until(Sim_Now() + ENTRY_NS + ((Sim_Random() % 100 == 0) ? SPIKE_NS + Sim_Random() % (SPIKE_NS + 1) : 0));
+		latency = (uint32_t)((Sim_Now() - Sim_Edge_Time()) / 1000);
+		Get_Interrupt_Source(&hspi, &source);
+		Get_FIFO_Status(&hspi, &triggered, &entries);
+		Sim_Get_Stats(&stats);
+		start = Sim_Now();
+		Read_FIFO(&hspi, samples, entries);
+		age = (uint32_t)((Sim_Now() - conversion[(stats.samples - entries) % HISTORY]) / 1000);
+		run.interrupts++;
+		run.late += age > MAX_AGE_US;
+		run.overruns += source.overrun;
+		run.worst_age = age > run.worst_age ? age : run.worst_age;
+		if (!fixed)
+		{
+			Watermark_Update(&control, &source, entries, latency, (uint32_t)((Sim_Now() - start) / 1000));
+			Watermark_Apply(&hspi, &control);
+		}
+	}
+	run.watermark = fixed ? fixed : control.watermark;
+	run.fifo_ctl_ok = (Sim_Peek(FIFO_CTL) & 0x1F) == run.watermark;
+	return run;
+}
+
+static void Print(const char *name, const t_Run *run)
+{
+	printf("%-12s watermark %2u: %6.1f int/s, %5u late drains, %u overruns, oldest sample at most %.1f ms\n", name, run->watermark,
+		   run->interrupts / (RUN_NS * 1e-9), run->late, run->overruns, run->worst_age * 1e-3);
+}
+
+int main(void)
+{
+	t_Run four = Run(4, 0);
+	t_Run eight = Run(8, 0);
+	t_Run soft = Run(0, 0);
+	t_Run bounded = Run(0, WORST_LATENCY_US);
+	Print("fixed", &four);
+	Print("fixed", &eight);
+	Print("adaptive", &soft);
+	Print("worst case", &bounded);
+	printf("worst case %u us configured, FIFO_CTL %s\n", WORST_LATENCY_US, bounded.fifo_ctl_ok ? "holds the applied watermark" : "DIFFERS");
+	return (bounded.late == 0 && bounded.overruns == 0 && bounded.interrupts < four.interrupts && bounded.fifo_ctl_ok && soft.fifo_ctl_ok) ? 0 : 1;
+}
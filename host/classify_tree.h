@@ -0,0 +1,19 @@
+/* Generated by train_tree.py from 2000 windows (training accuracy 99.8 %), depth 5, minimum 4 windows per leaf */
+#ifndef CLASSIFY_TREE_H
+#define CLASSIFY_TREE_H
+
+#include "adxl_classify.h"
+
+#define CLASSIFY_TREE_NODES 		7
+
+static const t_TreeNode classify_tree[CLASSIFY_TREE_NODES] = {
+	{FEATURE_RMS_Z, 9, 1, 6}, 	// 0: RMS_Z <= 9
+	{FEATURE_HIGH_BAND, 48, 2, 5}, 	// 1: HIGH_BAND <= 48
+	{FEATURE_RMS_X, 19, 3, 4}, 	// 2: RMS_X <= 19
+	{TREE_LEAF, 0, 0, 0}, 	// 3: class IDLE
+	{TREE_LEAF, 0, 1, 0}, 	// 4: class RUNNING
+	{TREE_LEAF, 0, 2, 0}, 	// 5: class FAULT
+	{TREE_LEAF, 0, 3, 0}, 	// 6: class TRANSPORT
+};
+
+#endif /* CLASSIFY_TREE_H */
@@ -0,0 +1,89 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/******************************************************************************************************************************************************************************/
+/*																				 Host HAL Stub 																				  */
+/******************************************************************************************************************************************************************************/
+
+/*
+ * Stand-in for the CubeMX main.h on host builds. It declares the handful of HAL types and calls the driver uses; the calls
+ * are implemented by the simulated sensor in adxl_sim.c, so every SPI transaction of adxl.c ends up on its register model.
+ */
+
+typedef enum
+{
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+	volatile uint32_t CR1;
+	volatile uint32_t SR;
+	volatile uint32_t DR;
+} SPI_TypeDef;
+
+typedef struct
+{
+	volatile uint32_t BSRR;
+} GPIO_TypeDef;
+
+typedef struct __SPI_HandleTypeDef
+{
+	SPI_TypeDef *Instance;
+} SPI_HandleTypeDef;
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define CS_Pin 						0x0040
+#define SPI_CR1_SPE 				(1UL << 6)
+#define SPI_SR_RXNE 				(1UL << 0)
+#define SPI_SR_TXE 					(1UL << 1)
+#define SPI_SR_BSY 					(1UL << 7)
+#define DWT_CTRL_CYCCNTENA_Msk 		(1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk 	(1UL << 24)
+
+extern GPIO_TypeDef *GPIOB;
+// Plain objects rather than the CMSIS macros, so Latency_Enable_Counter leaves them alone on the host
+extern DWT_Type *DWT;
+extern CoreDebug_Type *CoreDebug;
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef *hspi, uint8_t *pTxData, uint8_t *pRxData, uint16_t Size);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+// Provided by the program, called by the simulated SPI when an interrupt-driven transfer ends
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MAIN_H */
@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+"""Train the adxl_classify decision tree on host-extracted window features and emit it as a C table.
+
+The input is the CSV written by `bench_classify --features FILE`: one line per window, the FEATURE_COUNT integer
+features in enum FEATURE order followed by the MOTION_CLASS label. The tree is grown with CART (Gini impurity,
+exhaustive threshold search) in plain Python, so no numpy or scikit-learn is needed. Features are integers and the
+classifier tests `feature <= threshold`, so every split threshold is the floor of the midpoint between two adjacent
+feature values and quantizes to int16 without changing a single decision on the training set.
+
+    python3 train_tree.py train.csv [--depth 5] [--leaf 4] > classify_tree.h
+"""
+
+import argparse
+import sys
+
+FEATURES = ["MEAN_X", "MEAN_Y", "MEAN_Z", "RMS_X", "RMS_Y", "RMS_Z", "LOW_BAND", "HIGH_BAND"]
+CLASSES = ["IDLE", "RUNNING", "FAULT", "TRANSPORT"]
+TREE_LEAF = 0xFF
+MAX_NODES = 255
+
+
+def load(path):
+    rows = []
+    with open(path) as f:
+        for line in f:
+            values = [int(v) for v in line.split(",")]
+            if len(values) != len(FEATURES) + 1:
+                sys.exit("%s: expected %d columns" % (path, len(FEATURES) + 1))
+            rows.append((values[:-1], values[-1]))
+    return rows
+
+
+def gini(counts, total):
+    return 1.0 - sum((c / total) ** 2 for c in counts if c)
+
+
+def histogram(rows):
+    counts = [0] * len(CLASSES)
+    for _, label in rows:
+        counts[label] += 1
+    return counts
+
+
+def best_split(rows, min_leaf):
+    """Return (impurity, feature, threshold) of the best split, or None."""
+    total = len(rows)
+    parent = histogram(rows)
+    best = None
+    for feature in range(len(FEATURES)):
+        ordered = sorted(rows, key=lambda r: r[0][feature])
+        left = [0] * len(CLASSES)
+        right = list(parent)
+        for i in range(total - 1):
+            label = ordered[i][1]
+            left[label] += 1
+            right[label] -= 1
+            a = ordered[i][0][feature]
+            b = ordered[i + 1][0][feature]
+            n_left = i + 1
+            if a == b or n_left < min_leaf or total - n_left < min_leaf:
+                continue
+            impurity = (n_left * gini(left, n_left) + (total - n_left) * gini(right, total - n_left)) / total
+            if best is None or impurity < best[0] - 1e-12:
+                best = (impurity, feature, (a + b) // 2)
+    return best
+
+
+def grow(rows, depth, max_depth, min_leaf):
+    """Return a nested tree: ("leaf", class) or ("split", feature, threshold, left, right)."""
+    counts = histogram(rows)
+    majority = max(range(len(CLASSES)), key=lambda c: counts[c])
+    if depth == max_depth or counts[majority] == len(rows):
+        return ("leaf", majority)
+    split = best_split(rows, min_leaf)
+    if split is None or split[0] >= gini(counts, len(rows)) - 1e-12:
+        return ("leaf", majority)
+    _, feature, threshold = split
+    threshold = max(-32768, min(32767, threshold))
+    left = [r for r in rows if r[0][feature] <= threshold]
+    right = [r for r in rows if r[0][feature] > threshold]
+    left = grow(left, depth + 1, max_depth, min_leaf)
+    right = grow(right, depth + 1, max_depth, min_leaf)
+    if left[0] == "leaf" and left == right:
+        return left  # the split lowers the impurity but decides nothing
+    return ("split", feature, threshold, left, right)
+
+
+def flatten(tree, table):
+    """Pre-order layout, node 0 is the root. Returns the index of the node."""
+    index = len(table)
+    if tree[0] == "leaf":
+        table.append((TREE_LEAF, 0, tree[1], 0, "class %s" % CLASSES[tree[1]]))
+        return index
+    table.append(None)
+    left = flatten(tree[3], table)
+    right = flatten(tree[4], table)
+    table[index] = (tree[1], tree[2], left, right, "%s <= %d" % (FEATURES[tree[1]], tree[2]))
+    return index
+
+
+def predict(tree, features):
+    while tree[0] == "split":
+        tree = tree[3] if features[tree[1]] <= tree[2] else tree[4]
+    return tree[1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("csv")
+    parser.add_argument("--depth", type=int, default=5)
+    parser.add_argument("--leaf", type=int, default=4, help="minimum windows per leaf")
+    args = parser.parse_args()
+
+    rows = load(args.csv)
+    tree = grow(rows, 0, args.depth, args.leaf)
+    table = []
+    flatten(tree, table)
+    if len(table) > MAX_NODES:
+        sys.exit("tree has %d nodes, t_TreeNode indexes are 8-bit" % len(table))
+    correct = sum(predict(tree, f) == label for f, label in rows)
+
+    print("/* Generated by train_tree.py from %d windows (training accuracy %.1f %%), depth %d, minimum %d windows per leaf */"
+          % (len(rows), 100.0 * correct / len(rows), args.depth, args.leaf))
+    print("#ifndef CLASSIFY_TREE_H")
+    print("#define CLASSIFY_TREE_H")
+    print()
+    print('#include "adxl_classify.h"')
+    print()
+    print("#define CLASSIFY_TREE_NODES \t\t%d" % len(table))
+    print()
+    print("static const t_TreeNode classify_tree[CLASSIFY_TREE_NODES] = {")
+    for i, (feature, threshold, left, right, comment) in enumerate(table):
+        feature_name = "TREE_LEAF" if feature == TREE_LEAF else "FEATURE_" + FEATURES[feature]
+        print("\t{%s, %d, %d, %d}, \t// %d: %s" % (feature_name, threshold, left, right, i, comment))
+    print("};")
+    print()
+    print("#endif /* CLASSIFY_TREE_H */")
+    print("training accuracy %.1f %% on %d windows, %d nodes" % (100.0 * correct / len(rows), len(rows), len(table)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()